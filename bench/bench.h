@@ -0,0 +1,6 @@
+#pragma once
+
+#include <cstddef>
+
+// Number of operator new calls since the start of splash_bench
+std::size_t allocationCount();
@@ -0,0 +1,50 @@
+// Entry point of splash_bench: counts heap allocations for every benchmark
+// and records the libclang version in the context of the JSON report.
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <string>
+
+#include <benchmark/benchmark.h>
+#include <clang-c/Index.h>
+
+#include "bench.h"
+
+static std::atomic<std::size_t> allocations {0};
+
+std::size_t allocationCount()
+{
+    return allocations;
+}
+
+void* operator new(std::size_t size)
+{
+    allocations++;
+    if (void *p = std::malloc(size))
+        return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void *p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+int main(int argc, char** argv)
+{
+    CXString version = clang_getClangVersion();
+    benchmark::AddCustomContext("libclang", clang_getCString(version));
+    clang_disposeString(version);
+
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv))
+        return 1;
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
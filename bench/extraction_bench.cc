@@ -0,0 +1,277 @@
+// Benchmarks of the extraction pipeline on synthetic ns-3 like sources:
+// lexical prescan, translation unit loading, model traversal, merging with parent resolution
+// and export. Every benchmark takes {classes, attributes, depth} arguments.
+#include <filesystem>
+#include <map>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+#include <clang-c/Index.h>
+
+#include "bench.h"
+#include "binary_ir.h"
+#include "model_index.h"
+#include "model_scanner.h"
+#include "model_writer.h"
+#include "parent_resolver.h"
+#include "query_server.h"
+#include "splash.h"
+#include "synthetic_corpus.h"
+
+namespace fs = std::filesystem;
+
+// One generated source per argument set, written once to the temp directory
+class CorpusFile {
+public:
+    CorpusFile(unsigned classes, unsigned attributes, unsigned depth)
+    {
+        directory = (fs::temp_directory_path() / ("splash_bench_" + std::to_string(classes) + "_" +
+                     std::to_string(attributes) + "_" + std::to_string(depth))).string();
+        source = SyntheticCorpus(classes, attributes, depth).write(directory, 1).front();
+        arguments = SyntheticCorpus::compileArguments(directory);
+        sourceBytes = fs::file_size(source);
+    }
+
+    std::string directory;
+    std::string source;
+    std::vector<std::string> arguments;
+    std::size_t sourceBytes;
+};
+
+static const CorpusFile& corpusFile(const benchmark::State &state)
+{
+    static std::map<std::tuple<int64_t, int64_t, int64_t>, CorpusFile> files;
+
+    const auto key = std::make_tuple(state.range(0), state.range(1), state.range(2));
+    auto it = files.find(key);
+    if (it == files.end())
+        it = files.emplace(key, CorpusFile(state.range(0), state.range(1), state.range(2))).first;
+    return it->second;
+}
+
+// Parsed the way Splash::loadTranslationUnit parses a source input
+static CXTranslationUnit parse(CXIndex index, const CorpusFile &file)
+{
+    std::vector<const char *> args;
+    for (auto& a : file.arguments)
+        args.push_back(a.c_str());
+
+    const unsigned options = CXTranslationUnit_KeepGoing |
+                             CXTranslationUnit_SkipFunctionBodies |
+                             CXTranslationUnit_LimitSkipFunctionBodiesToPreamble |
+                             CXTranslationUnit_PrecompiledPreamble |
+                             CXTranslationUnit_CreatePreambleOnFirstParse;
+
+    CXTranslationUnit translationUnit = nullptr;
+    clang_parseTranslationUnit2(index, file.source.c_str(), args.data(), args.size(),
+                                nullptr, 0, options, &translationUnit);
+    return translationUnit;
+}
+
+static std::vector<Model> extract(CXTranslationUnit translationUnit, TraversalCounters &counters, bool prune)
+{
+    std::vector<Model> models;
+    VisitorContext context {models, counters, prune, 0};
+    clang_visitChildren(clang_getTranslationUnitCursor(translationUnit), Splash::explorerCallback, &context);
+    return models;
+}
+
+static void BM_LoadTranslationUnit(benchmark::State &state)
+{
+    auto& file = corpusFile(state);
+    CXIndex index = clang_createIndex(0, 0);
+    const std::size_t before = allocationCount();
+
+    for (auto _ : state) {
+        CXTranslationUnit translationUnit = parse(index, file);
+        if (!translationUnit) {
+            state.SkipWithError("cannot parse the synthetic source");
+            break;
+        }
+        clang_disposeTranslationUnit(translationUnit);
+    }
+
+    clang_disposeIndex(index);
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * file.sourceBytes));
+    state.counters["allocs"] = benchmark::Counter(allocationCount() - before, benchmark::Counter::kAvgIterations);
+}
+
+static void BM_Prescan(benchmark::State &state)
+{
+    auto& file = corpusFile(state);
+
+    for (auto _ : state) {
+        ScanResult result;
+        if (!ModelScanner::scanFile(file.source, result) ||
+            result.classes.size() != static_cast<std::size_t>(state.range(0))) {
+            state.SkipWithError("unexpected scan of the synthetic source");
+            break;
+        }
+        benchmark::DoNotOptimize(result);
+    }
+
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * file.sourceBytes));
+}
+
+static void runTraversal(benchmark::State &state, bool prune)
+{
+    auto& file = corpusFile(state);
+    CXIndex index = clang_createIndex(0, 0);
+    CXTranslationUnit translationUnit = parse(index, file);
+    if (!translationUnit) {
+        state.SkipWithError("cannot parse the synthetic source");
+        clang_disposeIndex(index);
+        return;
+    }
+
+    TraversalCounters counters;
+    std::size_t models = 0;
+    const std::size_t before = allocationCount();
+
+    for (auto _ : state)
+        models = extract(translationUnit, counters, prune).size();
+
+    const double visited = static_cast<double>(counters.visited);
+    state.counters["cursors_per_s"] = benchmark::Counter(visited, benchmark::Counter::kIsRate);
+    state.counters["cursors"] = benchmark::Counter(visited, benchmark::Counter::kAvgIterations);
+    state.counters["allocs_per_cursor"] = visited > 0 ? (allocationCount() - before) / visited : 0;
+    state.counters["models"] = models;
+    if (models != static_cast<std::size_t>(state.range(0)))
+        state.SkipWithError("unexpected number of extracted models");
+
+    clang_disposeTranslationUnit(translationUnit);
+    clang_disposeIndex(index);
+}
+
+static void BM_Traversal(benchmark::State &state)
+{
+    runTraversal(state, true);
+}
+
+static void BM_FullTraversal(benchmark::State &state)
+{
+    runTraversal(state, false);
+}
+
+// Models of the synthetic source, extracted once per argument set
+static const std::vector<Model>& extractedModels(const benchmark::State &state)
+{
+    static std::map<std::tuple<int64_t, int64_t, int64_t>, std::vector<Model>> extracted;
+
+    const auto key = std::make_tuple(state.range(0), state.range(1), state.range(2));
+    auto it = extracted.find(key);
+    if (it == extracted.end()) {
+        CXIndex index = clang_createIndex(0, 0);
+        CXTranslationUnit translationUnit = parse(index, corpusFile(state));
+        TraversalCounters counters;
+        std::vector<Model> models;
+        if (translationUnit) {
+            models = extract(translationUnit, counters, true);
+            clang_disposeTranslationUnit(translationUnit);
+        }
+        clang_disposeIndex(index);
+        it = extracted.emplace(key, models).first;
+    }
+    return it->second;
+}
+
+static void BM_MergeAndResolveParents(benchmark::State &state)
+{
+    auto& models = extractedModels(state);
+    const std::size_t before = allocationCount();
+
+    for (auto _ : state) {
+        ModelTable table;
+        for (auto& model : models)
+            table.append(model);
+        ParentResolver(table).resolve();
+        benchmark::DoNotOptimize(table.attributeCount(table.size() - 1));
+    }
+
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * models.size()));
+    state.counters["allocs"] = benchmark::Counter(allocationCount() - before, benchmark::Counter::kAvgIterations);
+}
+
+template <typename Export>
+static void runExport(benchmark::State &state, const std::string &extension, Export exportModels)
+{
+    ModelTable table;
+    for (auto& model : extractedModels(state))
+        table.append(model);
+    ParentResolver(table).resolve();
+
+    const std::string path = corpusFile(state).directory + "/export" + extension;
+    const std::size_t before = allocationCount();
+
+    for (auto _ : state)
+        exportModels(path, table);
+
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * fs::file_size(path)));
+    state.counters["allocs"] = benchmark::Counter(allocationCount() - before, benchmark::Counter::kAvgIterations);
+}
+
+static void BM_ExportJson(benchmark::State &state)
+{
+    runExport(state, ".json", [](const std::string &path, const ModelTable &models) {
+        ModelWriter writer(path, false);
+        for (std::size_t m = 0; m < models.size(); m++)
+            writer.write(models, m);
+        writer.close();
+    });
+}
+
+static void BM_ExportBinaryIr(benchmark::State &state)
+{
+    runExport(state, ".spir", [](const std::string &path, const ModelTable &models) {
+        BinaryIr::write(path, models);
+    });
+}
+
+// "name" lookups of splash serve, inherited attributes resolved by the index
+static void BM_IndexLookup(benchmark::State &state)
+{
+    ModelTable table;
+    for (auto& model : extractedModels(state))
+        table.append(model);
+    const std::string path = corpusFile(state).directory + "/lookup.spir";
+    BinaryIr::write(path, table);
+    ModelIndex::build(path, ModelIndex::indexPath(path));
+
+    ModelIndex index(path);
+    std::vector<std::string> requests;
+    for (std::uint32_t m = 0; m < index.modelCount(); m++)
+        requests.push_back("name " + std::string(index.name(m)));
+
+    std::string answer;
+    std::size_t next = 0, bytes = 0;
+    for (auto _ : state) {
+        answer.clear();
+        QueryServer::answer(index, requests[next], answer);
+        bytes += answer.size();
+        next = (next + 1) % requests.size();
+    }
+
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+    state.SetBytesProcessed(static_cast<int64_t>(bytes));
+}
+
+// {classes, attributes, inheritance depth}
+static void corpusSizes(benchmark::internal::Benchmark *b)
+{
+    b->ArgNames({"classes", "attributes", "depth"});
+    b->Args({16, 8, 4});
+    b->Args({64, 16, 8});
+    b->Args({256, 8, 32});
+}
+
+// libclang parses on its own thread, so the load is timed on the wall clock
+BENCHMARK(BM_Prescan)->Apply(corpusSizes)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_LoadTranslationUnit)->Apply(corpusSizes)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(BM_Traversal)->Apply(corpusSizes)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_FullTraversal)->Apply(corpusSizes)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_MergeAndResolveParents)->Apply(corpusSizes)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_ExportJson)->Apply(corpusSizes)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_ExportBinaryIr)->Apply(corpusSizes)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_IndexLookup)->Apply(corpusSizes)->Unit(benchmark::kMicrosecond);
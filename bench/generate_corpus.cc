@@ -0,0 +1,47 @@
+// Writes a synthetic ns-3 like corpus with its compile_commands.json, so the
+// whole pipeline can be run and profiled offline:
+//   splash_corpus corpus -f 32 -n 64 -m 16 -d 8
+//   splash -p corpus/compile_commands.json -o corpus.json
+#include <exception>
+#include <iostream>
+#include <string>
+
+#include <cxxopts.hpp>
+
+#include "synthetic_corpus.h"
+
+int main(int argc, char** argv)
+{
+    cxxopts::Options options("splash_corpus", "Generate synthetic ns-3 like sources for splash.");
+    options.add_options()
+        ("directory", "Output directory.", cxxopts::value<std::string>())
+        ("f,files", "Number of source files.", cxxopts::value<unsigned>()->default_value("16"))
+        ("n,classes", "Models defined by every source file.", cxxopts::value<unsigned>()->default_value("64"))
+        ("m,attributes", "Attributes registered by every model.", cxxopts::value<unsigned>()->default_value("16"))
+        ("d,depth", "Length of the SetParent chains below ns3::Object.", cxxopts::value<unsigned>()->default_value("8"))
+        ("local-classes", "Declare the classes in the source files instead of in headers, every other one "
+                          "with its GetTypeId defined inline.")
+        ("h,help", "Print usage");
+    options.parse_positional({"directory"});
+    options.positional_help("DIRECTORY");
+
+    try {
+        auto result = options.parse(argc, argv);
+        if (result.count("help") || !result.count("directory")) {
+            std::cout << options.help() << std::endl;
+            return result.count("help") ? 0 : 1;
+        }
+
+        const auto files = result["files"].as<unsigned>();
+        SyntheticCorpus corpus(result["classes"].as<unsigned>(), result["attributes"].as<unsigned>(),
+                               result["depth"].as<unsigned>(), result.count("local-classes") > 0);
+        corpus.write(result["directory"].as<std::string>(), files);
+
+        std::cout << "Wrote " << files << " source file(s) with "
+                  << files * result["classes"].as<unsigned>() << " model(s)." << std::endl;
+        return 0;
+    } catch (const std::exception &e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+}
@@ -0,0 +1,193 @@
+// Microbenchmark of the cursor predicates evaluated by explorerCallback.
+// Compares the current predicates with the former std::string based ones
+// and reports heap allocations per visited cursor.
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+#include <clang-c/Index.h>
+
+#include "bench.h"
+#include "splash.h"
+
+static const char *BENCH_SOURCE = R"(
+namespace ns3 {
+class AttributeValue {};
+class TypeId {
+public:
+  explicit TypeId(const char *name) {}
+  template <typename T> TypeId SetParent() { return *this; }
+  TypeId AddAttribute(const char *name, const char *help, const AttributeValue &value) { return *this; }
+};
+class Object { public: static TypeId GetTypeId(); };
+class DoubleValue : public AttributeValue { public: DoubleValue(double v) {} };
+class Model : public Object { public: static TypeId GetTypeId(); };
+TypeId Model::GetTypeId()
+{
+  static TypeId tid = TypeId("ns3::Model")
+    .SetParent<Object>()
+    .AddAttribute("A", "First attribute.", DoubleValue(1.0))
+    .AddAttribute("B", "Second attribute.", DoubleValue(2.0))
+    .AddAttribute("C", "Third attribute.", DoubleValue(3.0));
+  return tid;
+}
+}
+)";
+
+// The predicates as they were before being rewritten on top of std::string_view,
+// kept as a baseline. hasParent releases its string here to keep memory bounded.
+namespace legacy {
+
+bool isNamespace(const CXCursor &cursor, std::string namespaceName)
+{
+    CXCursorKind curKind = clang_getCursorKind(cursor);
+    CXString spell = clang_getCursorSpelling(cursor);
+    std::string spellText = clang_getCString(spell);
+    const bool flag = curKind == CXCursorKind::CXCursor_Namespace &&
+                      spellText.compare(namespaceName) == 0;
+    clang_disposeString(spell);
+
+    return flag;
+}
+
+bool isMethod(const CXCursor &cursor, std::string methodName)
+{
+    CXCursorKind curKind = clang_getCursorKind(cursor);
+    CXString spell = clang_getCursorSpelling(cursor);
+    std::string spellText = clang_getCString(spell);
+    const bool flag = curKind == CXCursorKind::CXCursor_CXXMethod &&
+                      spellText.compare(methodName) == 0;
+    clang_disposeString(spell);
+
+    return flag;
+}
+
+bool hasParent(const CXCursor &parent, std::string targetParent)
+{
+    CXString parentName = clang_getCursorSpelling(parent);
+    const bool flag = targetParent.compare(clang_getCString(parentName)) == 0;
+    clang_disposeString(parentName);
+
+    return flag;
+}
+
+bool isDecl(const CXCursor &cursor, std::string typeDecl, std::string parentName)
+{
+    CXCursorKind curKind = clang_getCursorKind(cursor);
+    CXType type = clang_getCursorType(cursor);
+    CXString typeName = clang_getTypeSpelling(type);
+    std::string typeNameStr = clang_getCString(typeName);
+    CXCursor semanticParent = clang_getCursorSemanticParent(cursor);
+    CXString semanticParentName = clang_getCursorSpelling(semanticParent);
+    std::string semanticParentNameStr = clang_getCString(semanticParentName);
+
+    const bool flag = clang_isDeclaration(curKind) &&
+                      typeNameStr.compare(typeDecl) == 0 &&
+                      semanticParentNameStr.compare(parentName) == 0;
+
+    clang_disposeString(typeName);
+    clang_disposeString(semanticParentName);
+    return flag;
+}
+
+bool isCallExpr(const CXCursor &cursor, std::string exprReturnType, std::string name)
+{
+    CXCursorKind curKind = clang_getCursorKind(cursor);
+    CXString curKindName = clang_getCursorKindSpelling(curKind);
+    std::string curKindNameStr = clang_getCString(curKindName);
+    CXType type = clang_getCursorType(cursor);
+    CXString typeName = clang_getTypeSpelling(type);
+    std::string typeNameStr = clang_getCString(typeName);
+    CXString spell = clang_getCursorSpelling(cursor);
+    std::string spellStr = clang_getCString(spell);
+
+    const bool flag = clang_isExpression(curKind) &&
+                      curKindNameStr.compare("CallExpr") == 0 &&
+                      typeNameStr.compare(exprReturnType) == 0 &&
+                      spellStr.compare(name) == 0;
+
+    clang_disposeString(curKindName);
+    clang_disposeString(typeName);
+    clang_disposeString(spell);
+    return flag;
+}
+
+} // namespace legacy
+
+// Every cursor of the benchmark source with its parent, collected once.
+class CursorCorpus {
+public:
+    CursorCorpus()
+    {
+        m_index = clang_createIndex(0, 0);
+        CXUnsavedFile file {"bench.cc", BENCH_SOURCE, std::char_traits<char>::length(BENCH_SOURCE)};
+        const char *args[] = {"-x", "c++"};
+        clang_parseTranslationUnit2(m_index, "bench.cc", args, 2, &file, 1,
+                                    CXTranslationUnit_None, &m_translationUnit);
+
+        clang_visitChildren(clang_getTranslationUnitCursor(m_translationUnit),
+                            [](CXCursor cursor, CXCursor parent, CXClientData clientData) {
+            static_cast<CursorCorpus *>(clientData)->cursors.push_back({cursor, parent});
+            return CXChildVisit_Recurse;
+        }, this);
+    }
+
+    ~CursorCorpus()
+    {
+        clang_disposeTranslationUnit(m_translationUnit);
+        clang_disposeIndex(m_index);
+    }
+
+    std::vector<std::pair<CXCursor, CXCursor>> cursors;
+
+private:
+    CXIndex m_index;
+    CXTranslationUnit m_translationUnit;
+};
+
+static CursorCorpus& corpus()
+{
+    static CursorCorpus c;
+    return c;
+}
+
+template <typename Predicates>
+static void runPredicates(benchmark::State &state, Predicates predicates)
+{
+    auto& cursors = corpus().cursors;
+    const std::size_t before = allocationCount();
+
+    for (auto _ : state) {
+        for (auto& [cursor, parent] : cursors)
+            benchmark::DoNotOptimize(predicates(cursor, parent));
+    }
+
+    const double visited = static_cast<double>(state.iterations()) * cursors.size();
+    state.SetItemsProcessed(static_cast<int64_t>(visited));
+    state.counters["allocs_per_cursor"] = (allocationCount() - before) / visited;
+}
+
+static void BM_LegacyPredicates(benchmark::State &state)
+{
+    runPredicates(state, [](const CXCursor &cursor, const CXCursor &parent) {
+        return legacy::isNamespace(cursor, "ns3") +
+               legacy::isMethod(cursor, "GetTypeId") +
+               legacy::isDecl(cursor, "ns3::TypeId", "GetTypeId") +
+               legacy::hasParent(parent, "SetParent") +
+               legacy::isCallExpr(cursor, "ns3::TypeId", "AddAttribute");
+    });
+}
+BENCHMARK(BM_LegacyPredicates);
+
+static void BM_Predicates(benchmark::State &state)
+{
+    runPredicates(state, [](const CXCursor &cursor, const CXCursor &parent) {
+        return Splash::isNamespace(cursor, "ns3") +
+               Splash::isMethod(cursor, "GetTypeId") +
+               Splash::isDecl(cursor, "ns3::TypeId", "GetTypeId") +
+               Splash::hasParent(parent, "SetParent") +
+               Splash::isCallExpr(cursor, "ns3::TypeId", "AddAttribute");
+    });
+}
+BENCHMARK(BM_Predicates);
@@ -0,0 +1,197 @@
+#include "synthetic_corpus.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+
+namespace fs = std::filesystem;
+
+SyntheticCorpus::SyntheticCorpus(unsigned classes, unsigned attributes, unsigned depth, bool localClasses) :
+    m_classes {classes},
+    m_attributes {attributes},
+    m_depth {std::max(depth, 1u)},
+    m_localClasses {localClasses}
+{}
+
+static void writeFile(const fs::path &path, const std::string &content)
+{
+    fs::create_directories(path.parent_path());
+    std::ofstream ofs(path, std::ios::binary | std::ios::trunc);
+    ofs << content;
+    if (!ofs)
+        throw std::runtime_error("cannot write " + path.string());
+}
+
+std::vector<std::string> SyntheticCorpus::write(const std::string &directory, unsigned files) const
+{
+    const fs::path root = fs::absolute(directory);
+    writeFile(root / "include" / "ns3" / "object.h", objectHeader());
+
+    std::vector<std::string> sources;
+    std::string database = "[";
+    for (unsigned f = 0; f < files; f++) {
+        const std::string stem = "synthetic-" + std::to_string(f) + "-model";
+        writeFile(root / "include" / "ns3" / (stem + ".h"), header(f));
+        writeFile(root / "src" / (stem + ".cc"), source(f));
+        sources.push_back((root / "src" / (stem + ".cc")).string());
+
+        database += f > 0 ? ",\n" : "\n";
+        database += " {\"directory\": \"" + root.string() + "\", \"file\": \"src/" + stem + ".cc\", "
+                    "\"command\": \"/usr/bin/c++ -std=c++17 -I" + (root / "include").string() +
+                    " -O2 -o obj/" + stem + ".cc.o -c src/" + stem + ".cc\"}";
+    }
+    database += "\n]\n";
+    writeFile(root / "compile_commands.json", database);
+
+    return sources;
+}
+
+std::string SyntheticCorpus::className(unsigned file, unsigned model) const
+{
+    return "Synthetic" + std::to_string(file) + "Model" + std::to_string(model);
+}
+
+std::string SyntheticCorpus::header(unsigned file) const
+{
+    const std::string guard = "SYNTHETIC_" + std::to_string(file) + "_MODEL_H";
+    std::string h = "#ifndef " + guard + "\n#define " + guard + "\n#include \"ns3/object.h\"\nnamespace ns3 {\n";
+    if (!m_localClasses)
+        h += declarations(file);
+    h += "} // namespace ns3\n#endif\n";
+    return h;
+}
+
+std::string SyntheticCorpus::declarations(unsigned file) const
+{
+    std::string h;
+    for (unsigned c = 0; c < m_classes; c++) {
+        const std::string parent = c % m_depth == 0 ? "Object" : className(file, c - 1);
+        h += "class " + className(file, c) + " : public " + parent + " {\npublic:\n";
+        h += isInline(c) ? "  static ns3::TypeId GetTypeId()\n" + typeIdBody(file, c) : "  static ns3::TypeId GetTypeId();\n";
+        for (unsigned a = 0; a < m_attributes; a++) {
+            static const char *memberTypes[] = {"double", "uint32_t", "bool", "int"};
+            h += "  " + std::string(memberTypes[a % 4]) + " m_attribute" + std::to_string(a) + ";\n";
+        }
+        h += "};\n";
+    }
+    return h;
+}
+
+std::string SyntheticCorpus::source(unsigned file) const
+{
+    // like ns-3 sources, include the core headers directly as well
+    std::string s = "#include \"ns3/synthetic-" + std::to_string(file) + "-model.h\"\n"
+                    "#include \"ns3/object.h\"\n"
+                    "namespace ns3 {\n";
+    if (m_localClasses)
+        s += declarations(file);
+
+    for (unsigned c = 0; c < m_classes; c++) {
+        if (!isInline(c))
+            s += "ns3::TypeId\n" + className(file, c) + "::GetTypeId()\n" + typeIdBody(file, c) + "\n";
+    }
+
+    s += "} // namespace ns3\n";
+    return s;
+}
+
+std::string SyntheticCorpus::typeIdBody(unsigned file, unsigned model) const
+{
+    const std::string name = className(file, model);
+    const std::string parent = model % m_depth == 0 ? "Object" : className(file, model - 1);
+
+    std::string s = "{\n"
+                    "  static ns3::TypeId tid = ns3::TypeId(\"ns3::" + name + "\")\n"
+                    "    .SetParent<" + parent + ">()\n"
+                    "    .SetGroupName(\"Synthetic\")\n"
+                    "    .AddConstructor<" + name + ">()";
+
+    // cycle through the AddAttribute shapes met in ns-3
+    for (unsigned a = 0; a < m_attributes; a++) {
+        const std::string n = std::to_string(a);
+        const std::string member = "&" + name + "::m_attribute" + n;
+        s += "\n    .AddAttribute(\"Attribute" + n + "\", \"Attribute " + n + " of " + name + "\"\n"
+             "                  \" in synthetic units.\",\n";
+        switch (a % 4) {
+            case 0:
+                s += "                  DoubleValue(" + n + ".5),\n"
+                     "                  MakeDoubleAccessor(" + member + "),\n"
+                     "                  MakeDoubleChecker<double>(0.0, 100.0))";
+                break;
+            case 1:
+                s += "                  TypeId::ATTR_GET | TypeId::ATTR_SET,\n"
+                     "                  UintegerValue(" + n + "),\n"
+                     "                  MakeUintegerAccessor(" + member + "),\n"
+                     "                  MakeUintegerChecker<uint32_t>())";
+                break;
+            case 2:
+                s += "                  BooleanValue(false),\n"
+                     "                  MakeBooleanAccessor(" + member + "),\n"
+                     "                  MakeBooleanChecker())";
+                break;
+            case 3:
+                s += "                  EnumValue(1),\n"
+                     "                  MakeEnumAccessor(" + member + "),\n"
+                     "                  MakeEnumChecker(0, \"Idle\", 1, \"Active\", 2, \"Sleep\"))";
+                break;
+        }
+    }
+
+    s += ";\n  return tid;\n}\n";
+    return s;
+}
+
+std::vector<std::string> SyntheticCorpus::compileArguments(const std::string &directory)
+{
+    return {"-x", "c++", "-std=c++17", "-I" + (fs::absolute(directory) / "include").string()};
+}
+
+std::string SyntheticCorpus::objectHeader()
+{
+    // the standard headers stand for the weight of the real ns-3 core headers
+    return R"(#ifndef NS3_OBJECT_H
+#define NS3_OBJECT_H
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+namespace ns3 {
+typedef unsigned int uint32_t;
+class AttributeValue { public: virtual ~AttributeValue() {} };
+class AttributeAccessor {};
+class AttributeChecker {};
+template <typename T> class Ptr { public: Ptr() {} template <typename U> Ptr(Ptr<U>) {} };
+class TypeId {
+public:
+  enum AttributeFlag { ATTR_GET = 1 << 0, ATTR_SET = 1 << 1, ATTR_CONSTRUCT = 1 << 2, ATTR_SGC = ATTR_GET | ATTR_SET | ATTR_CONSTRUCT };
+  enum SupportLevel { SUPPORTED, DEPRECATED, OBSOLETE };
+  explicit TypeId(const char *name) {}
+  template <typename T> ns3::TypeId SetParent() { return *this; }
+  ns3::TypeId SetGroupName(const char *g) { return *this; }
+  template <typename T> ns3::TypeId AddConstructor() { return *this; }
+  ns3::TypeId AddAttribute(const char *name, const char *help, const AttributeValue &initialValue,
+                           Ptr<const AttributeAccessor> accessor, Ptr<const AttributeChecker> checker,
+                           SupportLevel supportLevel = SUPPORTED, const char *supportMsg = "") { return *this; }
+  ns3::TypeId AddAttribute(const char *name, const char *help, uint32_t flags, const AttributeValue &initialValue,
+                           Ptr<const AttributeAccessor> accessor, Ptr<const AttributeChecker> checker,
+                           SupportLevel supportLevel = SUPPORTED, const char *supportMsg = "") { return *this; }
+};
+class ObjectBase { public: static ns3::TypeId GetTypeId(); };
+class Object : public ObjectBase { public: static ns3::TypeId GetTypeId(); };
+class DoubleValue : public AttributeValue { public: DoubleValue() {} DoubleValue(double v) {} };
+class UintegerValue : public AttributeValue { public: UintegerValue() {} UintegerValue(unsigned long long v) {} };
+class BooleanValue : public AttributeValue { public: BooleanValue() {} BooleanValue(bool v) {} };
+class EnumValue : public AttributeValue { public: EnumValue() {} EnumValue(int v) {} };
+template <typename T> Ptr<const AttributeAccessor> MakeDoubleAccessor(T) { return Ptr<const AttributeAccessor>(); }
+template <typename T> Ptr<const AttributeAccessor> MakeUintegerAccessor(T) { return Ptr<const AttributeAccessor>(); }
+template <typename T> Ptr<const AttributeAccessor> MakeBooleanAccessor(T) { return Ptr<const AttributeAccessor>(); }
+template <typename T> Ptr<const AttributeAccessor> MakeEnumAccessor(T) { return Ptr<const AttributeAccessor>(); }
+template <typename T> Ptr<const AttributeChecker> MakeDoubleChecker(double min = -1e300, double max = 1e300) { return Ptr<const AttributeChecker>(); }
+template <typename T> Ptr<const AttributeChecker> MakeUintegerChecker(unsigned long long min = 0, unsigned long long max = ~0ull) { return Ptr<const AttributeChecker>(); }
+inline Ptr<const AttributeChecker> MakeBooleanChecker() { return Ptr<const AttributeChecker>(); }
+inline Ptr<const AttributeChecker> MakeEnumChecker(int v1, const char *n1, int v2 = 0, const char *n2 = "", int v3 = 0, const char *n3 = "") { return Ptr<const AttributeChecker>(); }
+} // namespace ns3
+#endif
+)";
+}
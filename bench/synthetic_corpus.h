@@ -0,0 +1,39 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+// Synthetic ns-3 like sources, so the extractor can be measured offline.
+// Each source file defines `classes` models registering `attributes`
+// attributes each; models form SetParent chains `depth` models deep below
+// ns3::Object. A stub ns3/object.h declares TypeId and the value types.
+// The classes are declared in a header of each source, or with
+// localClasses in the source itself: every other class then defines its
+// GetTypeId inline, the others below the class.
+class SyntheticCorpus
+{
+public:
+    SyntheticCorpus(unsigned classes, unsigned attributes, unsigned depth, bool localClasses = false);
+
+    // Writes include/ns3/object.h, one header and source per file and a
+    // compile_commands.json, then returns the paths of the sources
+    std::vector<std::string> write(const std::string &directory, unsigned files) const;
+
+    std::string header(unsigned file) const;
+    std::string source(unsigned file) const;
+    std::string className(unsigned file, unsigned model) const;
+
+    static std::string objectHeader();
+    static std::vector<std::string> compileArguments(const std::string &directory);
+
+private:
+    std::string declarations(unsigned file) const;
+    // "{ ... return tid; }" of the GetTypeId of a class
+    std::string typeIdBody(unsigned file, unsigned model) const;
+    bool isInline(unsigned model) const { return m_localClasses && model % 2 == 1; }
+
+    unsigned m_classes;
+    unsigned m_attributes;
+    unsigned m_depth;
+    bool m_localClasses;
+};
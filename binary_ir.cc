@@ -0,0 +1,353 @@
+#include "binary_ir.h"
+
+#include <atomic>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <limits>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#include <process.h>
+#endif
+
+// records are 8 bytes aligned in the file
+static std::uint64_t align(std::uint64_t offset)
+{
+    return (offset + 7) & ~std::uint64_t(7);
+}
+
+// Accumulates the records and the string table of a file. Strings are
+// already interned by the model table, each id is written once.
+class IrBuilder
+{
+public:
+    IrBuilder(const ModelTable &models) :
+        m_table {models},
+        m_ids(models.strings().size(), {UNSET, 0})
+    {}
+
+    IrString string(StringId id)
+    {
+        IrString &str = m_ids[id];
+        if (str.offset != UNSET)
+            return str;
+
+        std::string_view value = m_table.string(id);
+        if (m_strings.size() + value.size() + 1 >= UNSET)
+            throw BinaryIrException("", "string table exceeds 4 GiB");
+
+        str = {static_cast<std::uint32_t>(m_strings.size()), static_cast<std::uint32_t>(value.size())};
+        m_strings.append(value);
+        m_strings.push_back('\0');
+        return str;
+    }
+
+    void add(std::size_t m)
+    {
+        IrModel model {};
+        model.name = string(m_table.nameId(m));
+        model.parent = string(m_table.parentId(m));
+        model.qualifiedName = string(m_table.qualifiedNameId(m));
+        model.firstAttribute = m_attributes.size();
+        model.attributeCount = m_table.attributeCount(m);
+
+        for (std::uint32_t i = 0; i < m_table.attributeCount(m); i++) {
+            const AttributeRecord &a = m_table.attribute(m, i);
+            IrAttribute attribute {};
+            attribute.name = string(a.name);
+            attribute.description = string(a.description);
+            attribute.type = string(a.type);
+            attribute.initialValue = string(a.initialValue);
+            attribute.checker = string(a.checker);
+            attribute.flags = string(a.flags);
+            attribute.firstAccessor = list(a.firstAccessor, a.accessorCount);
+            attribute.accessorCount = a.accessorCount;
+            attribute.firstCheckerArgument = list(a.firstCheckerArgument, a.checkerArgumentCount);
+            attribute.checkerArgumentCount = a.checkerArgumentCount;
+            m_attributes.push_back(attribute);
+        }
+
+        m_models.push_back(model);
+    }
+
+    std::uint32_t list(std::uint32_t first, std::uint32_t count)
+    {
+        const auto listFirst = static_cast<std::uint32_t>(m_lists.size());
+        for (std::uint32_t i = 0; i < count; i++)
+            m_lists.push_back(string(m_table.listStringId(first + i)));
+        return listFirst;
+    }
+
+    std::vector<IrModel> m_models;
+    std::vector<IrAttribute> m_attributes;
+    std::vector<IrString> m_lists;
+    std::string m_strings;
+
+private:
+    static constexpr std::uint32_t UNSET = std::numeric_limits<std::uint32_t>::max();
+
+    const ModelTable &m_table;
+    std::vector<IrString> m_ids;
+};
+
+void BinaryIr::write(const std::string &path, const ModelTable &models)
+{
+    IrBuilder builder(models);
+    builder.m_models.reserve(models.size());
+
+    try {
+        for (std::size_t m = 0; m < models.size(); m++)
+            builder.add(m);
+    } catch (const BinaryIrException &e) {
+        throw BinaryIrException(path, e.reason);
+    }
+
+    IrHeader header {};
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.byteOrder = BYTE_ORDER_MARK;
+    header.modelCount = builder.m_models.size();
+    header.attributeCount = builder.m_attributes.size();
+    header.listCount = builder.m_lists.size();
+    header.modelsOffset = align(sizeof(IrHeader));
+    header.attributesOffset = align(header.modelsOffset + header.modelCount * sizeof(IrModel));
+    header.listsOffset = align(header.attributesOffset + header.attributeCount * sizeof(IrAttribute));
+    header.stringsOffset = align(header.listsOffset + header.listCount * sizeof(IrString));
+    header.stringsSize = builder.m_strings.size();
+
+    // replaced by a rename, so a reader mapping the previous file never
+    // sees it truncated
+    const std::string temporary = temporaryPath(path);
+    std::ofstream ofs(temporary, std::ios::binary);
+    if (!ofs)
+        throw BinaryIrException(path, "cannot open the file for writing");
+
+    auto writeAt = [&ofs](std::uint64_t offset, const void *data, std::size_t size) {
+        static const char padding[8] = {};
+        ofs.write(padding, offset - static_cast<std::uint64_t>(ofs.tellp()));
+        ofs.write(static_cast<const char *>(data), size);
+    };
+
+    writeAt(0, &header, sizeof(header));
+    writeAt(header.modelsOffset, builder.m_models.data(), builder.m_models.size() * sizeof(IrModel));
+    writeAt(header.attributesOffset, builder.m_attributes.data(), builder.m_attributes.size() * sizeof(IrAttribute));
+    writeAt(header.listsOffset, builder.m_lists.data(), builder.m_lists.size() * sizeof(IrString));
+    writeAt(header.stringsOffset, builder.m_strings.data(), builder.m_strings.size());
+
+    ofs.close();
+    std::error_code ec;
+    if (ofs)
+        std::filesystem::rename(temporary, path, ec);
+    if (!ofs || ec) {
+        std::filesystem::remove(temporary, ec);
+        throw BinaryIrException(path, "write failed");
+    }
+}
+
+std::string BinaryIr::temporaryPath(const std::string &path)
+{
+    static std::atomic<unsigned> counter {0};
+#ifdef _WIN32
+    const int pid = _getpid();
+#else
+    const pid_t pid = getpid();
+#endif
+    return path + ".tmp" + std::to_string(pid) + "." + std::to_string(counter++);
+}
+
+bool BinaryIr::isBinaryIr(const std::string &path)
+{
+    std::ifstream ifs(path, std::ios::binary);
+    char magic[sizeof(MAGIC)] = {};
+
+    ifs.read(magic, sizeof(magic));
+    return ifs && std::memcmp(magic, MAGIC, sizeof(MAGIC)) == 0;
+}
+
+bool BinaryIr::isBinaryIrPath(const std::string &path)
+{
+    const std::string extension = ".spir";
+    return path.size() >= extension.size() &&
+           path.compare(path.size() - extension.size(), extension.size(), extension) == 0;
+}
+
+BinaryIrReader::BinaryIrReader(const std::string &path) :
+    m_path {path}
+{
+#ifndef _WIN32
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        throw BinaryIrException(path, "cannot open the file");
+
+    struct stat st;
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+        void *data = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data != MAP_FAILED) {
+            m_data = data;
+            m_size = st.st_size;
+            m_mapped = true;
+        }
+    }
+    close(fd);
+#endif
+
+    // no mmap, read the file instead
+    if (!m_mapped) {
+        std::ifstream ifs(path, std::ios::binary);
+        if (!ifs)
+            throw BinaryIrException(path, "cannot open the file");
+
+        m_buffer.assign(std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>());
+        m_data = m_buffer.data();
+        m_size = m_buffer.size();
+    }
+
+    try {
+        validate();
+    } catch (const BinaryIrException &) {
+#ifndef _WIN32
+        if (m_mapped)
+            munmap(const_cast<void *>(m_data), m_size);
+#endif
+        throw;
+    }
+
+    auto base = static_cast<const char *>(m_data);
+    m_models = reinterpret_cast<const IrModel *>(base + header().modelsOffset);
+    m_attributes = reinterpret_cast<const IrAttribute *>(base + header().attributesOffset);
+    m_lists = reinterpret_cast<const IrString *>(base + header().listsOffset);
+    m_strings = base + header().stringsOffset;
+}
+
+BinaryIrReader::~BinaryIrReader()
+{
+#ifndef _WIN32
+    if (m_mapped)
+        munmap(const_cast<void *>(m_data), m_size);
+#endif
+}
+
+void BinaryIrReader::validate() const
+{
+    if (m_size < sizeof(IrHeader) || std::memcmp(header().magic, BinaryIr::MAGIC, sizeof(BinaryIr::MAGIC)) != 0)
+        throw BinaryIrException(m_path, "not a splash binary IR");
+    // the records are read in place, they cannot be swapped on the fly
+    const std::uint32_t byteOrder = header().byteOrder;
+    const std::uint32_t swappedMark = (BinaryIr::BYTE_ORDER_MARK >> 24) | ((BinaryIr::BYTE_ORDER_MARK >> 8) & 0xff00) |
+                                      ((BinaryIr::BYTE_ORDER_MARK << 8) & 0xff0000) | (BinaryIr::BYTE_ORDER_MARK << 24);
+    if (byteOrder == swappedMark)
+        throw BinaryIrException(m_path, "binary IR written on a host of the other byte order, convert it there to JSON");
+    if (header().version != BinaryIr::VERSION)
+        throw BinaryIrException(m_path, "unsupported binary IR version " + std::to_string(header().version));
+    if (byteOrder != BinaryIr::BYTE_ORDER_MARK)
+        throw BinaryIrException(m_path, "corrupted byte order mark");
+
+    // every section must fit in the file, records are then read unchecked
+    const IrHeader &h = header();
+    auto fits = [this](std::uint64_t offset, std::uint64_t count, std::uint64_t size) {
+        return offset % 8 == 0 && offset <= m_size && count <= (m_size - offset) / size;
+    };
+    if (!fits(h.modelsOffset, h.modelCount, sizeof(IrModel)) ||
+        !fits(h.attributesOffset, h.attributeCount, sizeof(IrAttribute)) ||
+        !fits(h.listsOffset, h.listCount, sizeof(IrString)) ||
+        !fits(h.stringsOffset, h.stringsSize, 1))
+        throw BinaryIrException(m_path, "truncated binary IR");
+
+    auto base = static_cast<const char *>(m_data);
+    auto models = reinterpret_cast<const IrModel *>(base + h.modelsOffset);
+    auto attributes = reinterpret_cast<const IrAttribute *>(base + h.attributesOffset);
+    auto lists = reinterpret_cast<const IrString *>(base + h.listsOffset);
+
+    auto validString = [&h](const IrString &str) {
+        return std::uint64_t(str.offset) + str.size < h.stringsSize;
+    };
+    auto validRange = [](std::uint32_t first, std::uint32_t count, std::uint32_t total) {
+        return first <= total && count <= total - first;
+    };
+
+    for (std::uint32_t i = 0; i < h.modelCount; i++) {
+        const IrModel &m = models[i];
+        if (!validString(m.name) || !validString(m.parent) || !validString(m.qualifiedName) ||
+            !validRange(m.firstAttribute, m.attributeCount, h.attributeCount))
+            throw BinaryIrException(m_path, "corrupted model record");
+    }
+    for (std::uint32_t i = 0; i < h.attributeCount; i++) {
+        const IrAttribute &a = attributes[i];
+        if (!validString(a.name) || !validString(a.description) || !validString(a.type) ||
+            !validString(a.initialValue) || !validString(a.checker) || !validString(a.flags) ||
+            !validRange(a.firstAccessor, a.accessorCount, h.listCount) ||
+            !validRange(a.firstCheckerArgument, a.checkerArgumentCount, h.listCount))
+            throw BinaryIrException(m_path, "corrupted attribute record");
+    }
+    for (std::uint32_t i = 0; i < h.listCount; i++) {
+        if (!validString(lists[i]))
+            throw BinaryIrException(m_path, "corrupted string list");
+    }
+}
+
+std::vector<Model> BinaryIrReader::models() const
+{
+    std::vector<Model> models;
+    models.reserve(modelCount());
+
+    for (std::uint32_t i = 0; i < modelCount(); i++) {
+        const IrModel &m = model(i);
+        Model result {std::string(string(m.name))};
+        result.parent = string(m.parent);
+        result.qualifiedName = string(m.qualifiedName);
+
+        for (std::uint32_t j = 0; j < m.attributeCount; j++) {
+            const IrAttribute &a = attribute(m.firstAttribute + j);
+            Attribute attr;
+            attr.name = string(a.name);
+            attr.description = string(a.description);
+            attr.type = string(a.type);
+            attr.initialValue = string(a.initialValue);
+            attr.checker = string(a.checker);
+            attr.flags = string(a.flags);
+            for (std::uint32_t k = 0; k < a.accessorCount; k++)
+                attr.accessor.emplace_back(listString(a.firstAccessor + k));
+            for (std::uint32_t k = 0; k < a.checkerArgumentCount; k++)
+                attr.checkerArguments.emplace_back(listString(a.firstCheckerArgument + k));
+            result.attributes.push_back(std::move(attr));
+        }
+
+        models.push_back(std::move(result));
+    }
+
+    return models;
+}
+
+struct SplashIr {
+    BinaryIrReader reader;
+};
+
+SplashIr *splash_ir_open(const char *path)
+{
+    try {
+        return new SplashIr {BinaryIrReader(path)};
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+void splash_ir_close(SplashIr *ir)
+{
+    delete ir;
+}
+
+const void *splash_ir_data(const SplashIr *ir)
+{
+    return ir->reader.data();
+}
+
+std::size_t splash_ir_size(const SplashIr *ir)
+{
+    return ir->reader.size();
+}
@@ -0,0 +1,145 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "model.h"
+#include "model_table.h"
+
+// Binary IR: a fixed-width alternative to the JSON export that is read in
+// place through mmap, without parsing. Records are in the byte order of the
+// host that wrote them, recorded by a byte order mark in the header, so a
+// file is only read on hosts of the same byte order. Layout:
+//
+//   header | models | attributes | string lists | string table
+//
+// Every string is a (offset, size) reference into the string table, where
+// it is also NUL terminated. Identical strings are stored once.
+
+class BinaryIrException : std::exception
+{
+public:
+    BinaryIrException(std::string path, std::string reason):
+        path {path},
+        reason {reason}
+    {}
+
+    std::string path;
+    std::string reason;
+};
+
+struct IrString {
+    std::uint32_t offset;
+    std::uint32_t size;
+};
+
+struct IrHeader {
+    char magic[8];
+    std::uint32_t version;
+    // BYTE_ORDER_MARK as written by the host, swapped on the other byte order
+    std::uint32_t byteOrder;
+    std::uint32_t modelCount;
+    std::uint32_t attributeCount;
+    std::uint32_t listCount;
+    std::uint32_t reserved;
+    std::uint64_t modelsOffset;
+    std::uint64_t attributesOffset;
+    std::uint64_t listsOffset;
+    std::uint64_t stringsOffset;
+    std::uint64_t stringsSize;
+};
+
+struct IrModel {
+    IrString name;
+    IrString parent;
+    std::uint32_t firstAttribute;
+    std::uint32_t attributeCount;
+    // Model::qualifiedName, empty for models converted from JSON
+    IrString qualifiedName;
+};
+
+struct IrAttribute {
+    IrString name;
+    IrString description;
+    IrString type;
+    IrString initialValue;
+    IrString checker;
+    IrString flags;
+    // ranges in the string lists
+    std::uint32_t firstAccessor;
+    std::uint32_t accessorCount;
+    std::uint32_t firstCheckerArgument;
+    std::uint32_t checkerArgumentCount;
+};
+
+static_assert(sizeof(IrHeader) == 72, "IrHeader layout is part of the file format");
+static_assert(sizeof(IrModel) == 32, "IrModel layout is part of the file format");
+static_assert(sizeof(IrAttribute) == 64, "IrAttribute layout is part of the file format");
+
+class BinaryIr
+{
+public:
+    static constexpr char MAGIC[8] = {'S', 'P', 'L', 'A', 'S', 'H', 'I', 'R'};
+    // 3: qualified names of the models
+    static constexpr std::uint32_t VERSION = 3;
+    static constexpr std::uint32_t BYTE_ORDER_MARK = 0x01020304;
+
+    static void write(const std::string &path, const ModelTable &models);
+    static bool isBinaryIr(const std::string &path);
+    static bool isBinaryIrPath(const std::string &path);
+    // Name next to path, unique among processes and threads, for a file
+    // written aside and then renamed to path
+    static std::string temporaryPath(const std::string &path);
+};
+
+// Read-only view of a binary IR file, mapped in memory
+class BinaryIrReader
+{
+public:
+    BinaryIrReader(const std::string &path);
+    ~BinaryIrReader();
+
+    BinaryIrReader(const BinaryIrReader &) = delete;
+    BinaryIrReader& operator=(const BinaryIrReader &) = delete;
+
+    std::uint32_t modelCount() const { return header().modelCount; }
+    const IrModel& model(std::uint32_t i) const { return m_models[i]; }
+    const IrAttribute& attribute(std::uint32_t i) const { return m_attributes[i]; }
+    std::string_view string(const IrString &str) const { return {m_strings + str.offset, str.size}; }
+    std::string_view listString(std::uint32_t i) const { return string(m_lists[i]); }
+    std::uint64_t stringsSize() const { return header().stringsSize; }
+
+    const void* data() const { return m_data; }
+    std::size_t size() const { return m_size; }
+
+    std::vector<Model> models() const;
+
+private:
+    const IrHeader& header() const { return *static_cast<const IrHeader *>(m_data); }
+    void validate() const;
+
+    std::string m_path;
+    const void *m_data {nullptr};
+    std::size_t m_size {0};
+    bool m_mapped {false};
+    std::vector<char> m_buffer;
+    const IrModel *m_models {nullptr};
+    const IrAttribute *m_attributes {nullptr};
+    const IrString *m_lists {nullptr};
+    const char *m_strings {nullptr};
+};
+
+// C interface of the reader, used by the Python binding (splash_ir.py).
+// The records are read in place from the mapping returned by splash_ir_data.
+extern "C" {
+    typedef struct SplashIr SplashIr;
+
+    SplashIr *splash_ir_open(const char *path);
+    void splash_ir_close(SplashIr *ir);
+    const void *splash_ir_data(const SplashIr *ir);
+    std::size_t splash_ir_size(const SplashIr *ir);
+}
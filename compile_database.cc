@@ -0,0 +1,175 @@
+#include "compile_database.h"
+
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+#include <boost/json.hpp>
+
+CompileDatabase CompileDatabase::fromFile(const std::string &path)
+{
+    // accept both the JSON file itself and the build directory holding it
+    std::string databasePath = path;
+    if (std::filesystem::is_directory(databasePath))
+        databasePath = (std::filesystem::path(databasePath) / "compile_commands.json").string();
+
+    std::ifstream ifs(databasePath);
+    if (!ifs)
+        throw CompileDatabaseException(databasePath, "cannot open file");
+
+    std::stringstream contents;
+    contents << ifs.rdbuf();
+
+    boost::json::error_code ec;
+    auto root = boost::json::parse(contents.str(), ec);
+    if (ec || !root.is_array())
+        throw CompileDatabaseException(databasePath, "not a JSON array of compile commands");
+
+    // a field of the wrong type is reported like a missing one, rather
+    // than escaping as a boost::json exception
+    auto stringField = [&databasePath](const boost::json::object &obj, const char *key) {
+        auto value = obj.if_contains(key);
+        if (value == nullptr || !value->is_string())
+            throw CompileDatabaseException(databasePath, std::string("entry without string ") + key);
+        return std::string(value->as_string().c_str());
+    };
+
+    CompileDatabase db;
+    for (auto& entry : root.as_array()) {
+        auto obj = entry.if_object();
+        if (obj == nullptr)
+            throw CompileDatabaseException(databasePath, "entry is not a JSON object");
+
+        CompileCommand cmd;
+        cmd.directory = stringField(*obj, "directory");
+        cmd.file = normalizePath(stringField(*obj, "file"), cmd.directory);
+
+        std::vector<std::string> arguments;
+        if (auto args = obj->if_contains("arguments")) {
+            if (!args->is_array())
+                throw CompileDatabaseException(databasePath, "entry with arguments that are not an array");
+            for (auto& a : args->as_array()) {
+                if (!a.is_string())
+                    throw CompileDatabaseException(databasePath, "entry with an argument that is not a string");
+                arguments.push_back(a.as_string().c_str());
+            }
+        } else if (obj->contains("command")) {
+            arguments = splitCommandLine(stringField(*obj, "command"));
+        } else {
+            throw CompileDatabaseException(databasePath, "entry without arguments or command");
+        }
+
+        cmd.arguments = cleanArguments(arguments, cmd.directory, cmd.file);
+        db.m_commands.push_back(cmd);
+    }
+
+    return db;
+}
+
+const std::vector<CompileCommand>& CompileDatabase::commands() const
+{
+    return m_commands;
+}
+
+const CompileCommand* CompileDatabase::find(const std::string &filePath) const
+{
+    const auto target = normalizePath(filePath);
+
+    for (auto& cmd : m_commands) {
+        if (cmd.file == target)
+            return &cmd;
+    }
+
+    return nullptr;
+}
+
+std::string CompileDatabase::normalizePath(const std::string &path, const std::string &directory)
+{
+    std::filesystem::path p {path};
+    if (p.is_relative() && !directory.empty())
+        p = std::filesystem::path(directory) / p;
+
+    // resolve symbolic links, IoD Sim links its modules inside the ns-3 tree
+    std::error_code ec;
+    auto canonical = std::filesystem::weakly_canonical(p, ec);
+    if (ec)
+        return std::filesystem::absolute(p).lexically_normal().string();
+
+    return canonical.string();
+}
+
+std::vector<std::string> CompileDatabase::splitCommandLine(const std::string &commandLine)
+{
+    std::vector<std::string> arguments;
+    std::string current;
+    bool inArgument = false;
+    char quote = '\0';
+
+    for (std::size_t i = 0; i < commandLine.size(); i++) {
+        const char c = commandLine[i];
+
+        if (quote == '\'') {
+            if (c == '\'') quote = '\0';
+            else           current += c;
+        } else if (c == '\\' && i + 1 < commandLine.size() &&
+                   (quote == '\0' || commandLine[i + 1] == '"' || commandLine[i + 1] == '\\')) {
+            current += commandLine[++i];
+            inArgument = true;
+        } else if (quote == '"') {
+            if (c == '"') quote = '\0';
+            else          current += c;
+        } else if (c == '"' || c == '\'') {
+            quote = c;
+            inArgument = true;
+        } else if (c == ' ' || c == '\t' || c == '\n') {
+            if (inArgument)
+                arguments.push_back(current);
+            current.clear();
+            inArgument = false;
+        } else {
+            current += c;
+            inArgument = true;
+        }
+    }
+
+    if (inArgument)
+        arguments.push_back(current);
+
+    return arguments;
+}
+
+std::vector<std::string> CompileDatabase::cleanArguments(const std::vector<std::string> &arguments,
+                                                         const std::string &directory,
+                                                         const std::string &file)
+{
+    std::vector<std::string> cleaned;
+
+    // relative include paths are resolved against the entry's directory
+    cleaned.push_back("-working-directory=" + directory);
+
+    // skip the compiler executable, libclang only wants the flags
+    for (std::size_t i = 1; i < arguments.size(); i++) {
+        const auto& arg = arguments[i];
+
+        // empty arguments are valid JSON and mean nothing to the compiler
+        if (arg.empty() || arg == "-c" || arg == "-MD" || arg == "-MMD")
+            continue;
+
+        // options that are meaningful only when producing object files
+        if (arg == "-o" || arg == "-MF" || arg == "-MT" || arg == "-MQ") {
+            i++;
+            continue;
+        }
+        if (arg.rfind("-o", 0) == 0 || arg.rfind("-MF", 0) == 0 ||
+            arg.rfind("-MT", 0) == 0 || arg.rfind("-MQ", 0) == 0)
+            continue;
+
+        // the source file is passed to libclang separately
+        if (arg[0] != '-' && normalizePath(arg, directory) == file)
+            continue;
+
+        cleaned.push_back(arg);
+    }
+
+    return cleaned;
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <exception>
+#include <string>
+#include <vector>
+
+class CompileDatabaseException : std::exception
+{
+public:
+    CompileDatabaseException(std::string path, std::string reason):
+        databasePath {path},
+        reason {reason}
+    {}
+
+    std::string databasePath;
+    std::string reason;
+};
+
+// A single entry of a JSON Compilation Database, reduced to the
+// arguments that libclang needs to parse the file in memory.
+class CompileCommand {
+public:
+    CompileCommand() {}
+
+    std::string directory;
+    std::string file;
+    std::vector<std::string> arguments;
+};
+
+class CompileDatabase
+{
+public:
+    static CompileDatabase fromFile(const std::string &path);
+
+    const std::vector<CompileCommand>& commands() const;
+    const CompileCommand* find(const std::string &filePath) const;
+
+    static std::string normalizePath(const std::string &path, const std::string &directory = "");
+    static std::vector<std::string> splitCommandLine(const std::string &commandLine);
+
+private:
+    CompileDatabase() {}
+    static std::vector<std::string> cleanArguments(const std::vector<std::string> &arguments,
+                                                   const std::string &directory,
+                                                   const std::string &file);
+
+    std::vector<CompileCommand> m_commands;
+};
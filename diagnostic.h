@@ -0,0 +1,9 @@
+#pragma once
+
+#include <functional>
+#include <string>
+
+// Receives the warnings and progress messages of a session, one line each
+// without the newline. libsplash never prints them itself, the splash
+// executable writes them to stdout and the C API keeps them for the caller.
+using DiagnosticHandler = std::function<void(const std::string &message)>;
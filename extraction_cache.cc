@@ -0,0 +1,243 @@
+#include "extraction_cache.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+#include <boost/json.hpp>
+
+#include "binary_ir.h"
+#include "model_json.h"
+
+namespace fs = std::filesystem;
+
+// bump whenever the layout of an entry or the extracted information changes
+static const char *CACHE_FORMAT_VERSION = "7";
+
+// file timestamps come from a coarse clock, lagging behind the parse start
+static constexpr auto MTIME_RESOLUTION = std::chrono::milliseconds(20);
+
+ExtractionCache::ExtractionCache(std::string directory, std::string toolVersion, bool rebuild) :
+    m_directory {directory},
+    m_toolVersion {toolVersion + "/" + CACHE_FORMAT_VERSION},
+    m_rebuild {rebuild}
+{
+    fs::create_directories(m_directory);
+}
+
+bool ExtractionCache::lookup(const TranslationUnitInput &input, std::vector<Model> &models)
+{
+    if (m_rebuild)
+        return false;
+
+    std::ifstream ifs(entryPath(input));
+    if (!ifs)
+        return false;
+
+    std::stringstream contents;
+    contents << ifs.rdbuf();
+
+    try {
+        auto entry = boost::json::parse(contents.str()).as_object();
+
+        if (entry.at("version").as_string() != m_toolVersion ||
+            entry.at("input").as_string() != input.path ||
+            entry.at("arguments").as_string() != toHex(argumentsHash(input)))
+            return false;
+
+        for (auto& d : entry.at("dependencies").as_array()) {
+            auto& dep = d.as_object();
+            FileState cached;
+            cached.size = dep.at("size").to_number<std::uint64_t>();
+            cached.mtime = dep.at("mtime").to_number<std::int64_t>();
+            cached.contentHash = std::stoull(dep.at("hash").as_string().c_str(), nullptr, 16);
+
+            if (!isUpToDate(dep.at("path").as_string().c_str(), cached))
+                return false;
+        }
+
+        models = modelsFromJson(entry.at("models"));
+        // the USRs, qualified names and files are not part of the exported models
+        auto& usrs = entry.at("usrs").as_array();
+        auto& qualifiedNames = entry.at("qualifiedNames").as_array();
+        auto& files = entry.at("files").as_array();
+        if (usrs.size() != models.size() || qualifiedNames.size() != models.size() || files.size() != models.size())
+            return false;
+        for (std::size_t i = 0; i < models.size(); i++) {
+            models[i].usr = usrs[i].as_string().c_str();
+            models[i].qualifiedName = qualifiedNames[i].as_string().c_str();
+            models[i].file = files[i].as_string().c_str();
+        }
+    } catch (const std::exception &) {
+        // a corrupted or outdated entry is just a cache miss
+        return false;
+    }
+
+    return true;
+}
+
+void ExtractionCache::store(const TranslationUnitInput &input, CXTranslationUnit translationUnit,
+                            const std::vector<Model> &models, fs::file_time_type parseStart,
+                            const std::vector<std::string> &extraDependencies)
+{
+    std::vector<std::string> dependencies;
+
+    if (input.kind == TranslationUnitInput::Kind::Ast) {
+        // a regenerated AST file is enough to invalidate its entry
+        dependencies.push_back(input.path);
+    } else {
+        // the main file is reported as an inclusion with an empty stack
+        clang_getInclusions(translationUnit, [](CXFile includedFile, CXSourceLocation *, unsigned, CXClientData clientData) {
+            CXString fileName = clang_getFileName(includedFile);
+            static_cast<std::vector<std::string> *>(clientData)->push_back(clang_getCString(fileName));
+            clang_disposeString(fileName);
+        }, &dependencies);
+        dependencies.insert(dependencies.end(), extraDependencies.begin(), extraDependencies.end());
+        // a header is reported once per file including it
+        std::sort(dependencies.begin(), dependencies.end());
+        dependencies.erase(std::unique(dependencies.begin(), dependencies.end()), dependencies.end());
+    }
+
+    const auto modifiedSince = (parseStart - MTIME_RESOLUTION).time_since_epoch().count();
+    boost::json::array deps;
+    for (auto& path : dependencies) {
+        FileState state;
+        if (!readFileState(path, state, true) || state.mtime >= modifiedSince)
+            return;
+
+        deps.push_back({
+            {"path", path},
+            {"size", state.size},
+            {"mtime", state.mtime},
+            {"hash", toHex(state.contentHash)}
+        });
+    }
+
+    boost::json::object entry;
+    entry["version"] = m_toolVersion;
+    entry["input"] = input.path;
+    entry["arguments"] = toHex(argumentsHash(input));
+    entry["dependencies"] = deps;
+    entry["models"] = modelsToJson(models);
+    boost::json::array usrs;
+    boost::json::array qualifiedNames;
+    boost::json::array files;
+    for (auto& model : models) {
+        usrs.push_back(boost::json::string(model.usr));
+        qualifiedNames.push_back(boost::json::string(model.qualifiedName));
+        files.push_back(boost::json::string(model.file));
+    }
+    entry["usrs"] = usrs;
+    entry["qualifiedNames"] = qualifiedNames;
+    entry["files"] = files;
+
+    // write aside and rename, so that readers never see a partial entry
+    const auto path = entryPath(input);
+    const auto tmpPath = BinaryIr::temporaryPath(path);
+    std::ofstream ofs(tmpPath);
+    ofs << boost::json::serialize(entry);
+    ofs.close();
+
+    // a short write, on a full disk, is not published
+    std::error_code ec;
+    if (ofs)
+        fs::rename(tmpPath, path, ec);
+    if (!ofs || ec)
+        fs::remove(tmpPath, ec);
+}
+
+void ExtractionCache::forget(const std::vector<std::string> &paths)
+{
+    std::lock_guard<std::mutex> lock(m_fileStatesMutex);
+    for (auto& path : paths)
+        m_fileStates.erase(path);
+}
+
+std::uint64_t ExtractionCache::hash(const char *data, std::size_t size, std::uint64_t seed)
+{
+    // 64-bit FNV-1a
+    std::uint64_t h = seed;
+    for (std::size_t i = 0; i < size; i++) {
+        h ^= static_cast<unsigned char>(data[i]);
+        h *= 1099511628211ull;
+    }
+
+    return h;
+}
+
+std::string ExtractionCache::entryPath(const TranslationUnitInput &input) const
+{
+    // an input parsed with other flags keeps an entry of its own
+    const auto key = hash(input.path.data(), input.path.size());
+    return (fs::path(m_directory) / (toHex(key) + "-" + toHex(argumentsHash(input)) + ".json")).string();
+}
+
+std::uint64_t ExtractionCache::argumentsHash(const TranslationUnitInput &input) const
+{
+    std::uint64_t h = hash(input.kind == TranslationUnitInput::Kind::Ast ? "ast" : "src", 3);
+    for (auto& a : input.arguments)
+        h = hash(a.c_str(), a.size() + 1, h);
+
+    return h;
+}
+
+bool ExtractionCache::readFileState(const std::string &path, FileState &state, bool withContent)
+{
+    std::error_code ec;
+    state.size = fs::file_size(path, ec);
+    if (ec)
+        return false;
+    state.mtime = fs::last_write_time(path, ec).time_since_epoch().count();
+    if (ec)
+        return false;
+
+    if (!withContent)
+        return true;
+
+    {
+        std::lock_guard<std::mutex> lock(m_fileStatesMutex);
+        auto it = m_fileStates.find(path);
+        if (it != m_fileStates.end() && it->second.size == state.size && it->second.mtime == state.mtime) {
+            state.contentHash = it->second.contentHash;
+            return true;
+        }
+    }
+
+    std::ifstream ifs(path, std::ios::binary);
+    if (!ifs)
+        return false;
+
+    std::string contents(state.size, '\0');
+    ifs.read(&contents[0], contents.size());
+    state.contentHash = hash(contents.data(), ifs.gcount());
+
+    std::lock_guard<std::mutex> lock(m_fileStatesMutex);
+    m_fileStates[path] = state;
+    return true;
+}
+
+bool ExtractionCache::isUpToDate(const std::string &path, const FileState &cached)
+{
+    FileState current;
+    if (!readFileState(path, current, false))
+        return false;
+
+    if (current.size != cached.size)
+        return false;
+    if (current.mtime == cached.mtime)
+        return true;
+
+    // touched but maybe not modified, compare the contents
+    if (!readFileState(path, current, true))
+        return false;
+
+    return current.contentHash == cached.contentHash;
+}
+
+std::string ExtractionCache::toHex(std::uint64_t value)
+{
+    std::stringstream ss;
+    ss << std::hex << value;
+    return ss.str();
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <clang-c/Index.h>
+
+#include "splash.h"
+
+// Persistent cache of the models extracted from each translation unit.
+// An entry stays valid as long as the compile arguments and the content
+// of the unit and of every file it includes are unchanged.
+class ExtractionCache
+{
+public:
+    ExtractionCache(std::string directory, std::string toolVersion, bool rebuild);
+
+    bool lookup(const TranslationUnitInput &input, std::vector<Model> &models);
+    // extraDependencies are files read by the parse without being included
+    // by the unit, such as the headers of a shared PCH. Nothing is stored if
+    // a dependency was modified after parseStart, the time the parse began:
+    // its content may not be the one the models were extracted from.
+    void store(const TranslationUnitInput &input, CXTranslationUnit translationUnit,
+               const std::vector<Model> &models, std::filesystem::file_time_type parseStart,
+               const std::vector<std::string> &extraDependencies = {});
+
+    // Drops the file states read so far for paths, after they changed
+    void forget(const std::vector<std::string> &paths);
+
+    static std::uint64_t hash(const char *data, std::size_t size, std::uint64_t seed = 14695981039346656037ull);
+
+private:
+    class FileState {
+    public:
+        FileState() {}
+
+        std::uint64_t size {0};
+        std::int64_t mtime {0};
+        std::uint64_t contentHash {0};
+    };
+
+    std::string entryPath(const TranslationUnitInput &input) const;
+    std::uint64_t argumentsHash(const TranslationUnitInput &input) const;
+    // The content hash memoized for path is reused while its size and mtime
+    // are unchanged
+    bool readFileState(const std::string &path, FileState &state, bool withContent);
+    bool isUpToDate(const std::string &path, const FileState &cached);
+    static std::string toHex(std::uint64_t value);
+
+    std::string m_directory;
+    std::string m_toolVersion;
+    bool m_rebuild;
+    // headers are shared by many units, hash each of them only once per run
+    std::unordered_map<std::string, FileState> m_fileStates;
+    std::mutex m_fileStatesMutex;
+};
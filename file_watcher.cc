@@ -0,0 +1,106 @@
+#include "file_watcher.h"
+
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <stdexcept>
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+#ifdef __linux__
+
+FileWatcher::FileWatcher() :
+    m_fd {inotify_init1(IN_NONBLOCK | IN_CLOEXEC)}
+{
+    if (m_fd < 0)
+        throw std::runtime_error(std::string("cannot initialize inotify: ") + std::strerror(errno));
+}
+
+FileWatcher::~FileWatcher()
+{
+    close(m_fd);
+}
+
+void FileWatcher::watchDirectory(const std::string &directory)
+{
+    // a directory that cannot be watched is not tried again
+    if (!m_directories.insert(directory).second)
+        return;
+
+    // editors either rewrite a file or move a new version over it
+    const int wd = inotify_add_watch(m_fd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+    if (wd < 0)
+        throw std::runtime_error("cannot watch " + directory + ": " + std::strerror(errno));
+
+    if (static_cast<std::size_t>(wd) >= m_watchDirectories.size())
+        m_watchDirectories.resize(wd + 1);
+    m_watchDirectories[wd] = directory;
+    m_watched++;
+}
+
+std::vector<std::string> FileWatcher::wait(const volatile std::sig_atomic_t &stop, std::chrono::milliseconds settle)
+{
+    std::unordered_set<std::string> changed;
+
+    // wake up regularly to notice stop
+    while (!stop && !poll(std::chrono::milliseconds(200), changed)) {}
+    while (!stop && poll(settle, changed)) {}
+
+    return {changed.begin(), changed.end()};
+}
+
+bool FileWatcher::poll(std::chrono::milliseconds timeout, std::unordered_set<std::string> &changed)
+{
+    pollfd pfd {m_fd, POLLIN, 0};
+    if (::poll(&pfd, 1, static_cast<int>(timeout.count())) <= 0)
+        return false;
+
+    alignas(inotify_event) char buffer[16 * 1024];
+    bool any = false;
+    for (;;) {
+        const ssize_t length = read(m_fd, buffer, sizeof(buffer));
+        if (length <= 0)
+            break;
+
+        for (ssize_t offset = 0; offset < length; ) {
+            const auto *event = reinterpret_cast<const inotify_event *>(buffer + offset);
+            offset += sizeof(inotify_event) + event->len;
+
+            if (event->len == 0 || event->wd < 0 || static_cast<std::size_t>(event->wd) >= m_watchDirectories.size())
+                continue;
+            changed.insert((fs::path(m_watchDirectories[event->wd]) / event->name).string());
+            any = true;
+        }
+    }
+
+    return any;
+}
+
+#else
+
+FileWatcher::FileWatcher()
+{
+    throw std::runtime_error("watching files is only supported on Linux");
+}
+
+FileWatcher::~FileWatcher() {}
+
+void FileWatcher::watchDirectory(const std::string &) {}
+
+std::vector<std::string> FileWatcher::wait(const volatile std::sig_atomic_t &, std::chrono::milliseconds)
+{
+    return {};
+}
+
+bool FileWatcher::poll(std::chrono::milliseconds, std::unordered_set<std::string> &)
+{
+    return false;
+}
+
+#endif
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <chrono>
+#include <csignal>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+// Reports the files written or replaced in a set of watched directories.
+// Built on inotify, so it is only available on Linux.
+class FileWatcher
+{
+public:
+    static constexpr bool isSupported =
+#ifdef __linux__
+        true;
+#else
+        false;
+#endif
+
+    FileWatcher();
+    ~FileWatcher();
+
+    // Paths are canonical, as the directory a change is reported for.
+    // Throws std::runtime_error if inotify refuses it, for instance when
+    // the watches of the user are exhausted.
+    void watchDirectory(const std::string &directory);
+
+    // Blocks until some files change or stop is set, and returns the
+    // canonical paths of the changed files. Changes are gathered until the
+    // directories are quiet for settle, editors often write a file in steps.
+    std::vector<std::string> wait(const volatile std::sig_atomic_t &stop,
+                                  std::chrono::milliseconds settle = std::chrono::milliseconds(50));
+
+    // Directories watched, without those inotify refused
+    std::size_t directories() const { return m_watched; }
+
+private:
+    bool poll(std::chrono::milliseconds timeout, std::unordered_set<std::string> &changed);
+
+    int m_fd {-1};
+    std::unordered_set<std::string> m_directories;
+    std::size_t m_watched {0};
+    // inotify watch descriptor to directory
+    std::vector<std::string> m_watchDirectories;
+};
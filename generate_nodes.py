@@ -47,10 +47,13 @@ class NodeGenerator:
                 f.write(node_metacode)
 
     def _import_ir(self) -> List:
-        with open(self.input_file, 'r') as f:
-            file_contents = f.read()
+        if self.input_file.endswith('.spir'):
+            import splash_ir
+            deserialized = splash_ir.load(self.input_file)
+        else:
+            with open(self.input_file, 'r') as f:
+                deserialized = json.loads(f.read())
 
-        deserialized = json.loads(file_contents)
         # filter out models that do not provide attributes
         deserialized = [d for d in deserialized if len(d['attributes']) > 0]
 
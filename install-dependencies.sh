@@ -14,10 +14,11 @@ case "$ID" in
       cmake        \
       gcc          \
       clang        \
-      jq           \
       llvm-dev     \
       libclang-dev \
-      make
+      libzstd-dev  \
+      make         \
+      zlib1g-dev
     ;;
 
   fedora | centos)
@@ -28,10 +29,11 @@ case "$ID" in
       cxxopts-devel \
       gcc           \
       clang         \
-      jq            \
       llvm-devel    \
       clang-devel   \
-      make
+      libzstd-devel \
+      make          \
+      zlib-devel
     ;;
 
   *)
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// C interface of libsplash, used by the splash_session.py binding.
+//
+// A session collects inputs, extracts their models in-process and exposes
+// them as views into its string pool: nothing is copied or serialized, and
+// every SplashString stays valid until the next run or the session is
+// destroyed. Sessions share no state, several may run concurrently from
+// different threads, but a session must only be used by one at a time.
+//
+// Functions returning int return 0 on success and -1 on failure, with the
+// reason in splash_session_error.
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct SplashSession SplashSession;
+
+// Not NUL terminated
+typedef struct SplashString {
+    const char *data;
+    size_t size;
+} SplashString;
+
+typedef enum SplashAttributeField {
+    SPLASH_ATTRIBUTE_NAME = 0,
+    SPLASH_ATTRIBUTE_DESCRIPTION = 1,
+    SPLASH_ATTRIBUTE_TYPE = 2,
+    SPLASH_ATTRIBUTE_INITIAL_VALUE = 3,
+    SPLASH_ATTRIBUTE_CHECKER = 4,
+    SPLASH_ATTRIBUTE_FLAGS = 5
+} SplashAttributeField;
+
+typedef enum SplashAttributeList {
+    SPLASH_ATTRIBUTE_ACCESSOR = 0,
+    SPLASH_ATTRIBUTE_CHECKER_ARGUMENTS = 1
+} SplashAttributeList;
+
+SplashSession *splash_session_create(void);
+void splash_session_destroy(SplashSession *session);
+// Reason of the last failure, empty if there was none
+const char *splash_session_error(const SplashSession *session);
+// Warnings and progress messages, such as models defined twice, inputs
+// without TypeId or the compiler diagnostics of a parse, in the order they
+// were reported since the session was created or cleared. libsplash never
+// prints them.
+size_t splash_session_diagnostic_count(const SplashSession *session);
+const char *splash_session_diagnostic(const SplashSession *session, size_t i);
+void splash_session_clear_diagnostics(SplashSession *session);
+
+// Flags of the sources added afterwards with splash_session_add_input
+int splash_session_load_compile_commands(SplashSession *session, const char *path);
+void splash_session_add_extra_argument(SplashSession *session, const char *argument);
+// An AST file for .ast and .pch paths, otherwise a source file with its
+// compile command, if any, and the extra arguments
+int splash_session_add_input(SplashSession *session, const char *path);
+// A source file parsed with exactly these arguments
+int splash_session_add_source(SplashSession *session, const char *path,
+                              const char *const *arguments, size_t count);
+
+void splash_session_set_jobs(SplashSession *session, unsigned jobs);
+void splash_session_set_resolve_parents(SplashSession *session, int enabled);
+void splash_session_set_prescan(SplashSession *session, int enabled);
+// An empty or NULL directory disables the extraction cache
+void splash_session_set_cache(SplashSession *session, const char *directory);
+// JSON, compressed JSON or binary IR file written by splash_session_export,
+// before splash_session_run
+void splash_session_set_output(SplashSession *session, const char *path);
+
+// Extracts the models of every input added so far
+int splash_session_run(SplashSession *session);
+int splash_session_export(SplashSession *session);
+
+// Models of the last run, in the order of the JSON export. An index out of
+// range reads as an empty string, a count or a list size of 0
+size_t splash_model_count(const SplashSession *session);
+SplashString splash_model_name(const SplashSession *session, size_t model);
+// Empty for a model without parent
+SplashString splash_model_parent(const SplashSession *session, size_t model);
+
+// Attributes of a model, with those of its parents if they were resolved
+uint32_t splash_attribute_count(const SplashSession *session, size_t model);
+SplashString splash_attribute_field(const SplashSession *session, size_t model, uint32_t attribute,
+                                    SplashAttributeField field);
+uint32_t splash_attribute_list_size(const SplashSession *session, size_t model, uint32_t attribute,
+                                    SplashAttributeList list);
+SplashString splash_attribute_list_item(const SplashSession *session, size_t model, uint32_t attribute,
+                                        SplashAttributeList list, uint32_t i);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,70 @@
+#include "binary_ir.h"
+#include "model_index.h"
+#include "model_writer.h"
+#include "ryven_emitter.h"
+#include "splash.h"
+#include "splash_cli.h"
+#include "trace.h"
+
+#include <exception>
+#include <iostream>
+#include <string>
+
+int main(int argc, char** argv)
+{
+    if (argc > 1 && std::string(argv[1]) == "convert")
+        return SplashCli::convert(argc - 1, argv + 1);
+    if (argc > 1 && std::string(argv[1]) == "emit-ryven")
+        return SplashCli::emitRyven(argc - 1, argv + 1);
+    if (argc > 1 && std::string(argv[1]) == "query")
+        return SplashCli::query(argc - 1, argv + 1);
+    if (argc > 1 && std::string(argv[1]) == "serve")
+        return SplashCli::serve(argc - 1, argv + 1);
+
+    try {
+        auto s = SplashCli::fromUserInput(argc, argv, [](const std::string &message) {
+            std::cout << message << std::endl;
+        });
+        if (s == nullptr)
+            return 0;
+        s->run();
+        s->exportExtractedInformation();
+        s->writeStats();
+        s->watch();
+        delete s;
+        Trace::flush();
+    } catch (const CommandLineException &e) {
+        Trace::flush();
+        std::cerr << e.message << std::endl;
+        exit(1);
+    } catch (const TranslationUnitException &e) {
+        Trace::flush();
+        std::cerr << "Cannot create translation unit from " << e.astFilePath << "." << std::endl;
+        exit(1);
+    } catch (const ModelWriterException &e) {
+        Trace::flush();
+        std::cerr << "Cannot write " << e.outputPath << ": " << e.reason << "." << std::endl;
+        exit(1);
+    } catch (const BinaryIrException &e) {
+        Trace::flush();
+        std::cerr << "Cannot write " << e.path << ": " << e.reason << "." << std::endl;
+        exit(1);
+    } catch (const RyvenEmitterException &e) {
+        Trace::flush();
+        std::cerr << "Cannot write " << e.path << ": " << e.reason << "." << std::endl;
+        exit(1);
+    } catch (const ModelIndexException &e) {
+        Trace::flush();
+        std::cerr << "Cannot write " << e.path << ": " << e.reason << "." << std::endl;
+        exit(1);
+    } catch (const StatsException &e) {
+        Trace::flush();
+        std::cerr << "Cannot write " << e.path << ": " << e.reason << "." << std::endl;
+        exit(1);
+    } catch (const std::exception &e) {
+        // inotify, pipes or processes the system refused
+        Trace::flush();
+        std::cerr << "Error: " << e.what() << "." << std::endl;
+        exit(1);
+    }
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+// Models as extracted from a translation unit, a run merges them into a ModelTable
+class Attribute {
+public:
+    Attribute() {}
+
+    std::string name;
+    std::string description;
+    std::string type;
+    std::string initialValue;
+    std::vector<std::string> accessor;
+    std::string checker;
+    std::vector<std::string> checkerArguments;
+    std::string flags;
+};
+
+class Model {
+public:
+    Model(std::string n):
+        parent {""},
+        name {n},
+        attributes {},
+        usr {""},
+        qualifiedName {""},
+        file {""}
+    {}
+
+    std::string parent;
+    std::string name;
+    std::vector<Attribute> attributes;
+    // USR of the class, identifying a model across units, empty for the
+    // declaration of a GetTypeId defined elsewhere. Not exported.
+    std::string usr;
+    // Name of the class spelled like a SetParent<> type, as ns3::lte::Name,
+    // matched against the parents of other models. Not exported, empty for
+    // models read from JSON.
+    std::string qualifiedName;
+    // Header defining the GetTypeId inline, which many units include; empty
+    // when the input itself defines it. Not exported.
+    std::string file;
+};
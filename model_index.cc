@@ -0,0 +1,429 @@
+#include "model_index.h"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <unordered_map>
+#include <unordered_set>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "parent_resolver.h"
+
+// sections are 8 bytes aligned in the file
+static std::uint64_t align(std::uint64_t offset)
+{
+    return (offset + 7) & ~std::uint64_t(7);
+}
+
+// FNV-1a, stable across builds since it is part of the file format
+static std::uint64_t hashName(std::string_view name)
+{
+    std::uint64_t hash = 14695981039346656037ull;
+    for (unsigned char c : name) {
+        hash ^= c;
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+static std::string_view unqualified(const BinaryIrReader &ir, std::uint32_t model)
+{
+    return ParentResolver::unqualifiedName(ir.string(ir.model(model).name));
+}
+
+static std::vector<const IrAttribute *> collectAttributes(const BinaryIrReader &ir, const std::uint32_t *parents,
+                                                          std::uint32_t model)
+{
+    std::vector<const IrAttribute *> attributes;
+    std::unordered_set<std::string_view> names;
+
+    // a cyclic hierarchy stops once every model could have been visited
+    std::uint32_t steps = 0;
+    for (std::uint32_t m = model; m != ModelIndex::NONE && steps < ir.modelCount(); m = parents[m], steps++) {
+        const IrModel &record = ir.model(m);
+        for (std::uint32_t i = 0; i < record.attributeCount; i++) {
+            const IrAttribute &a = ir.attribute(record.firstAttribute + i);
+            if (names.insert(ir.string(a.name)).second)
+                attributes.push_back(&a);
+        }
+    }
+
+    return attributes;
+}
+
+// the file modification time, a rewritten IR of the same size is stale too
+static bool irIdentity(const std::string &irPath, std::uint64_t &size, std::int64_t &modified)
+{
+    std::error_code ec;
+    size = std::filesystem::file_size(irPath, ec);
+    if (ec)
+        return false;
+    modified = std::filesystem::last_write_time(irPath, ec).time_since_epoch().count();
+    return !ec;
+}
+
+std::string ModelIndex::serialize(const BinaryIrReader &ir, std::uint64_t irSize, std::int64_t irModified)
+{
+    const std::uint32_t numModels = ir.modelCount();
+
+    // one model per name, chosen as ParentResolver does: the first one,
+    // unless it is an empty declaration and a later one is not
+    std::unordered_map<std::string_view, std::uint32_t> byName;
+    byName.reserve(numModels);
+    for (std::uint32_t i = 0; i < numModels; i++) {
+        auto [it, inserted] = byName.emplace(unqualified(ir, i), i);
+        const IrModel &current = ir.model(it->second);
+        if (!inserted && current.parent.size == 0 && current.attributeCount == 0)
+            it->second = i;
+    }
+
+    std::vector<std::uint32_t> named;
+    for (std::uint32_t i = 0; i < numModels; i++) {
+        if (byName[unqualified(ir, i)] == i)
+            named.push_back(i);
+    }
+
+    // open addressing with linear probing, at most half full
+    std::uint32_t bucketCount = 8;
+    while (bucketCount < 2 * named.size())
+        bucketCount *= 2;
+    std::vector<std::uint32_t> buckets(bucketCount, NONE);
+    for (auto m : named) {
+        std::uint32_t b = hashName(unqualified(ir, m)) & (bucketCount - 1);
+        while (buckets[b] != NONE)
+            b = (b + 1) & (bucketCount - 1);
+        buckets[b] = m;
+    }
+
+    std::vector<std::uint32_t> names = named;
+    std::sort(names.begin(), names.end(), [&ir](std::uint32_t a, std::uint32_t b) {
+        return unqualified(ir, a) < unqualified(ir, b);
+    });
+
+    // parents are linked as ParentResolver links them, by qualified name first
+    ParentLookup lookup;
+    for (std::uint32_t i = 0; i < numModels; i++) {
+        const IrModel &record = ir.model(i);
+        lookup.add(i, ir.string(record.name), ir.string(record.qualifiedName),
+                   record.parent.size == 0 && record.attributeCount == 0);
+    }
+    std::vector<std::uint32_t> parents(numModels, NONE);
+    std::vector<std::vector<std::uint32_t>> childLists(numModels);
+    for (std::uint32_t i = 0; i < numModels; i++) {
+        const std::string_view parent = ir.string(ir.model(i).parent);
+        if (parent.empty())
+            continue;
+        const std::size_t found = lookup.find(parent);
+        if (found != ParentLookup::NONE && found != i) {
+            parents[i] = found;
+            childLists[found].push_back(i);
+        }
+    }
+    std::vector<IxRange> childRanges(numModels);
+    std::vector<std::uint32_t> children;
+    for (std::uint32_t i = 0; i < numModels; i++) {
+        childRanges[i] = {static_cast<std::uint32_t>(children.size()), static_cast<std::uint32_t>(childLists[i].size())};
+        children.insert(children.end(), childLists[i].begin(), childLists[i].end());
+    }
+
+    // sorted by type without namespaces, each with the models in IR order.
+    // ns3::DoubleValue and DoubleValue share an entry, spelled like the first.
+    std::map<std::string_view, std::pair<IrString, std::vector<std::uint32_t>>> typeModels;
+    for (std::uint32_t i = 0; i < numModels; i++) {
+        for (auto a : collectAttributes(ir, parents.data(), i)) {
+            const std::string_view type = ParentResolver::unqualifiedName(ir.string(a->type));
+            if (type.empty())
+                continue;
+            auto &entry = typeModels.try_emplace(type, a->type, std::vector<std::uint32_t>()).first->second;
+            if (entry.second.empty() || entry.second.back() != i)
+                entry.second.push_back(i);
+        }
+    }
+    std::vector<IxType> types;
+    std::vector<std::uint32_t> typeList;
+    for (auto &[type, entry] : typeModels) {
+        types.push_back({entry.first, {static_cast<std::uint32_t>(typeList.size()),
+                                       static_cast<std::uint32_t>(entry.second.size())}});
+        typeList.insert(typeList.end(), entry.second.begin(), entry.second.end());
+    }
+
+    IxHeader header {};
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.byteOrder = BinaryIr::BYTE_ORDER_MARK;
+    header.modelCount = numModels;
+    header.irSize = irSize;
+    header.irModified = irModified;
+    header.bucketCount = bucketCount;
+    header.nameCount = names.size();
+    header.typeCount = types.size();
+    header.childCount = children.size();
+    header.typeModelCount = typeList.size();
+    header.bucketsOffset = align(sizeof(IxHeader));
+    header.namesOffset = align(header.bucketsOffset + buckets.size() * sizeof(std::uint32_t));
+    header.parentsOffset = align(header.namesOffset + names.size() * sizeof(std::uint32_t));
+    header.childRangesOffset = align(header.parentsOffset + parents.size() * sizeof(std::uint32_t));
+    header.childrenOffset = align(header.childRangesOffset + childRanges.size() * sizeof(IxRange));
+    header.typesOffset = align(header.childrenOffset + children.size() * sizeof(std::uint32_t));
+    header.typeModelsOffset = align(header.typesOffset + types.size() * sizeof(IxType));
+
+    std::string data(header.typeModelsOffset + typeList.size() * sizeof(std::uint32_t), '\0');
+    auto put = [&data](std::uint64_t offset, const void *values, std::size_t size) {
+        if (size > 0)
+            std::memcpy(&data[offset], values, size);
+    };
+    put(0, &header, sizeof(header));
+    put(header.bucketsOffset, buckets.data(), buckets.size() * sizeof(std::uint32_t));
+    put(header.namesOffset, names.data(), names.size() * sizeof(std::uint32_t));
+    put(header.parentsOffset, parents.data(), parents.size() * sizeof(std::uint32_t));
+    put(header.childRangesOffset, childRanges.data(), childRanges.size() * sizeof(IxRange));
+    put(header.childrenOffset, children.data(), children.size() * sizeof(std::uint32_t));
+    put(header.typesOffset, types.data(), types.size() * sizeof(IxType));
+    put(header.typeModelsOffset, typeList.data(), typeList.size() * sizeof(std::uint32_t));
+    return data;
+}
+
+// through a temporary file, so a concurrent reader never maps half an index
+static bool writeIndex(const std::string &path, const std::string &data)
+{
+    const std::string temporary = BinaryIr::temporaryPath(path);
+    std::ofstream ofs(temporary, std::ios::binary);
+    if (!ofs)
+        return false;
+    ofs.write(data.data(), data.size());
+    ofs.close();
+
+    std::error_code ec;
+    if (ofs)
+        std::filesystem::rename(temporary, path, ec);
+    if (!ofs || ec) {
+        std::filesystem::remove(temporary, ec);
+        return false;
+    }
+    return true;
+}
+
+void ModelIndex::build(const std::string &irPath, const std::string &indexPath)
+{
+    std::uint64_t irSize;
+    std::int64_t irModified;
+    if (!irIdentity(irPath, irSize, irModified))
+        throw ModelIndexException(irPath, "cannot stat the binary IR");
+
+    BinaryIrReader ir(irPath);
+    if (!writeIndex(indexPath, serialize(ir, irSize, irModified)))
+        throw ModelIndexException(indexPath, "write failed");
+}
+
+ModelIndex::ModelIndex(const std::string &irPath) :
+    m_irPath {irPath},
+    m_ir {std::make_unique<BinaryIrReader>(irPath)}
+{
+    std::uint64_t irSize;
+    std::int64_t irModified;
+    if (!irIdentity(irPath, irSize, irModified))
+        throw ModelIndexException(irPath, "cannot stat the binary IR");
+
+    const std::string path = indexPath(irPath);
+    if (!map(path) || !validate(irSize, irModified)) {
+        unmap();
+        std::string data = serialize(*m_ir, irSize, irModified);
+        m_rebuilt = true;
+        if (!writeIndex(path, data) || !map(path) || !validate(irSize, irModified)) {
+            // a read-only directory, the index lives as long as the process
+            unmap();
+            m_buffer = std::move(data);
+            m_data = m_buffer.data();
+            m_size = m_buffer.size();
+        }
+    }
+
+    auto base = static_cast<const char *>(m_data);
+    const IxHeader &h = header();
+    m_buckets = reinterpret_cast<const std::uint32_t *>(base + h.bucketsOffset);
+    m_names = reinterpret_cast<const std::uint32_t *>(base + h.namesOffset);
+    m_parents = reinterpret_cast<const std::uint32_t *>(base + h.parentsOffset);
+    m_childRanges = reinterpret_cast<const IxRange *>(base + h.childRangesOffset);
+    m_children = reinterpret_cast<const std::uint32_t *>(base + h.childrenOffset);
+    m_types = reinterpret_cast<const IxType *>(base + h.typesOffset);
+    m_typeModels = reinterpret_cast<const std::uint32_t *>(base + h.typeModelsOffset);
+}
+
+ModelIndex::~ModelIndex()
+{
+    unmap();
+}
+
+bool ModelIndex::isStale() const
+{
+    std::uint64_t irSize;
+    std::int64_t irModified;
+    return !irIdentity(m_irPath, irSize, irModified) || irSize != header().irSize || irModified != header().irModified;
+}
+
+bool ModelIndex::map(const std::string &path)
+{
+#ifndef _WIN32
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    struct stat st;
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+        void *data = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data != MAP_FAILED) {
+            m_data = data;
+            m_size = st.st_size;
+            m_mapped = true;
+        }
+    }
+    close(fd);
+#endif
+
+    // no mmap, read the file instead
+    if (!m_mapped) {
+        std::ifstream ifs(path, std::ios::binary);
+        if (!ifs)
+            return false;
+
+        m_buffer.assign(std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>());
+        m_data = m_buffer.data();
+        m_size = m_buffer.size();
+    }
+    return true;
+}
+
+void ModelIndex::unmap()
+{
+#ifndef _WIN32
+    if (m_mapped)
+        munmap(const_cast<void *>(m_data), m_size);
+#endif
+    m_mapped = false;
+    m_buffer.clear();
+    m_data = nullptr;
+    m_size = 0;
+}
+
+bool ModelIndex::validate(std::uint64_t irSize, std::int64_t irModified) const
+{
+    if (m_size < sizeof(IxHeader) || std::memcmp(header().magic, MAGIC, sizeof(MAGIC)) != 0)
+        return false;
+
+    const IxHeader &h = header();
+    if (h.version != VERSION || h.byteOrder != BinaryIr::BYTE_ORDER_MARK ||
+        h.irSize != irSize || h.irModified != irModified || h.modelCount != m_ir->modelCount())
+        return false;
+
+    // every section must fit in the file, entries are then read unchecked
+    auto fits = [this](std::uint64_t offset, std::uint64_t count, std::uint64_t size) {
+        return offset % 8 == 0 && offset <= m_size && count <= (m_size - offset) / size;
+    };
+    const std::uint32_t n = h.modelCount;
+    if (h.bucketCount == 0 || (h.bucketCount & (h.bucketCount - 1)) != 0 || h.bucketCount <= n ||
+        !fits(h.bucketsOffset, h.bucketCount, sizeof(std::uint32_t)) ||
+        h.nameCount > n || !fits(h.namesOffset, h.nameCount, sizeof(std::uint32_t)) ||
+        !fits(h.parentsOffset, n, sizeof(std::uint32_t)) ||
+        !fits(h.childRangesOffset, n, sizeof(IxRange)) ||
+        !fits(h.childrenOffset, h.childCount, sizeof(std::uint32_t)) ||
+        !fits(h.typesOffset, h.typeCount, sizeof(IxType)) ||
+        !fits(h.typeModelsOffset, h.typeModelCount, sizeof(std::uint32_t)))
+        return false;
+
+    auto base = static_cast<const char *>(m_data);
+    auto section = [base](std::uint64_t offset) { return reinterpret_cast<const std::uint32_t *>(base + offset); };
+    auto validModel = [n](std::uint32_t m) { return m < n; };
+    auto validRange = [](const IxRange &r, std::uint32_t total) {
+        return r.first <= total && r.count <= total - r.first;
+    };
+
+    const std::uint32_t *buckets = section(h.bucketsOffset);
+    if (!std::all_of(buckets, buckets + h.bucketCount, [&](std::uint32_t m) { return m == NONE || validModel(m); }))
+        return false;
+    const std::uint32_t *names = section(h.namesOffset);
+    if (!std::all_of(names, names + h.nameCount, validModel))
+        return false;
+    const std::uint32_t *parents = section(h.parentsOffset);
+    if (!std::all_of(parents, parents + n, [&](std::uint32_t m) { return m == NONE || validModel(m); }))
+        return false;
+    auto childRanges = reinterpret_cast<const IxRange *>(base + h.childRangesOffset);
+    if (!std::all_of(childRanges, childRanges + n, [&](const IxRange &r) { return validRange(r, h.childCount); }))
+        return false;
+    const std::uint32_t *children = section(h.childrenOffset);
+    if (!std::all_of(children, children + h.childCount, validModel))
+        return false;
+    auto types = reinterpret_cast<const IxType *>(base + h.typesOffset);
+    for (std::uint32_t i = 0; i < h.typeCount; i++) {
+        if (std::uint64_t(types[i].type.offset) + types[i].type.size >= m_ir->stringsSize() ||
+            !validRange(types[i].models, h.typeModelCount))
+            return false;
+    }
+    const std::uint32_t *typeModels = section(h.typeModelsOffset);
+    return std::all_of(typeModels, typeModels + h.typeModelCount, validModel);
+}
+
+std::uint32_t ModelIndex::find(std::string_view name) const
+{
+    name = ParentResolver::unqualifiedName(name);
+    const std::uint32_t mask = header().bucketCount - 1;
+    for (std::uint32_t b = hashName(name) & mask, probes = 0; probes <= mask; b = (b + 1) & mask, probes++) {
+        const std::uint32_t m = m_buckets[b];
+        if (m == NONE)
+            break;
+        if (unqualified(*m_ir, m) == name)
+            return m;
+    }
+    return NONE;
+}
+
+std::vector<std::uint32_t> ModelIndex::withPrefix(std::string_view prefix, std::size_t limit) const
+{
+    prefix = ParentResolver::unqualifiedName(prefix);
+
+    const std::uint32_t *end = m_names + header().nameCount;
+    const std::uint32_t *first = std::lower_bound(m_names, end, prefix, [this](std::uint32_t m, std::string_view p) {
+        return unqualified(*m_ir, m) < p;
+    });
+
+    std::vector<std::uint32_t> models;
+    for (auto it = first; it != end && models.size() < limit; it++) {
+        const std::string_view name = unqualified(*m_ir, *it);
+        if (name.substr(0, prefix.size()) != prefix)
+            break;
+        models.push_back(*it);
+    }
+    return models;
+}
+
+std::vector<std::uint32_t> ModelIndex::withAttributeType(std::string_view type) const
+{
+    type = ParentResolver::unqualifiedName(type);
+
+    const IxType *end = m_types + header().typeCount;
+    const IxType *it = std::lower_bound(m_types, end, type, [this](const IxType &t, std::string_view value) {
+        return ParentResolver::unqualifiedName(m_ir->string(t.type)) < value;
+    });
+    if (it == end || ParentResolver::unqualifiedName(m_ir->string(it->type)) != type)
+        return {};
+    return {m_typeModels + it->models.first, m_typeModels + it->models.first + it->models.count};
+}
+
+std::vector<std::uint32_t> ModelIndex::children(std::uint32_t model) const
+{
+    const IxRange &range = m_childRanges[model];
+    return {m_children + range.first, m_children + range.first + range.count};
+}
+
+std::vector<const IrAttribute *> ModelIndex::effectiveAttributes(std::uint32_t model) const
+{
+    return collectAttributes(*m_ir, m_parents, model);
+}
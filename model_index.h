@@ -0,0 +1,139 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "binary_ir.h"
+
+// Lookup index of a binary IR, stored next to it (merged.spir.idx) and read
+// in place through mmap. Entries are in the byte order of the host that
+// wrote them, recorded by a byte order mark in the header; an index of the
+// other byte order is rebuilt like a stale one. Layout:
+//
+//   header | name buckets | sorted names | parents | children ranges |
+//   children | types | models of each type
+//
+// Models are referenced by their index in the IR and strings by their
+// reference in the IR string table. Names and attribute value types are
+// indexed without their namespaces, the way SetParent<> spells them is
+// resolved like ParentResolver.
+
+class ModelIndexException : std::exception
+{
+public:
+    ModelIndexException(std::string path, std::string reason):
+        path {path},
+        reason {reason}
+    {}
+
+    std::string path;
+    std::string reason;
+};
+
+struct IxHeader {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t modelCount;
+    // the IR the index was built from, a different one makes it stale
+    std::uint64_t irSize;
+    std::int64_t irModified;
+    std::uint32_t bucketCount;
+    // models that own their name, the others share it with an earlier one
+    std::uint32_t nameCount;
+    std::uint32_t typeCount;
+    std::uint32_t childCount;
+    std::uint32_t typeModelCount;
+    // BinaryIr::BYTE_ORDER_MARK as written by the host
+    std::uint32_t byteOrder;
+    std::uint64_t bucketsOffset;
+    std::uint64_t namesOffset;
+    std::uint64_t parentsOffset;
+    std::uint64_t childRangesOffset;
+    std::uint64_t childrenOffset;
+    std::uint64_t typesOffset;
+    std::uint64_t typeModelsOffset;
+};
+
+struct IxRange {
+    std::uint32_t first;
+    std::uint32_t count;
+};
+
+struct IxType {
+    IrString type;
+    // models with an attribute of the type, inherited ones included
+    IxRange models;
+};
+
+static_assert(sizeof(IxHeader) == 112, "IxHeader layout is part of the file format");
+static_assert(sizeof(IxRange) == 8, "IxRange layout is part of the file format");
+static_assert(sizeof(IxType) == 16, "IxType layout is part of the file format");
+
+class ModelIndex
+{
+public:
+    static constexpr char MAGIC[8] = {'S', 'P', 'L', 'A', 'S', 'H', 'I', 'X'};
+    // 2: value types keyed without their namespaces
+    // 3: byte order mark
+    static constexpr std::uint32_t VERSION = 3;
+    static constexpr std::uint32_t NONE = UINT32_MAX;
+
+    static std::string indexPath(const std::string &irPath) { return irPath + ".idx"; }
+    // Indexes the IR at irPath into indexPath
+    static void build(const std::string &irPath, const std::string &indexPath);
+
+    // Maps the IR and its index, which is rebuilt first if it is missing
+    // or stale. An index that cannot be written is kept in memory.
+    ModelIndex(const std::string &irPath);
+    ~ModelIndex();
+
+    ModelIndex(const ModelIndex &) = delete;
+    ModelIndex& operator=(const ModelIndex &) = delete;
+
+    bool rebuilt() const { return m_rebuilt; }
+    // The IR was rewritten since it was indexed
+    bool isStale() const;
+    const BinaryIrReader& ir() const { return *m_ir; }
+    std::uint32_t modelCount() const { return header().modelCount; }
+    std::string_view name(std::uint32_t model) const { return m_ir->string(m_ir->model(model).name); }
+
+    // With or without its namespaces, NONE if there is no such model
+    std::uint32_t find(std::string_view name) const;
+    // Sorted by name, at most limit of them
+    std::vector<std::uint32_t> withPrefix(std::string_view prefix, std::size_t limit = SIZE_MAX) const;
+    // With or without its namespaces, like find
+    std::vector<std::uint32_t> withAttributeType(std::string_view type) const;
+    std::uint32_t parent(std::uint32_t model) const { return m_parents[model]; }
+    std::vector<std::uint32_t> children(std::uint32_t model) const;
+
+    // Own attributes first, then those of each ancestor that a closer
+    // model does not redefine
+    std::vector<const IrAttribute *> effectiveAttributes(std::uint32_t model) const;
+
+private:
+    const IxHeader& header() const { return *static_cast<const IxHeader *>(m_data); }
+    bool map(const std::string &path);
+    void unmap();
+    bool validate(std::uint64_t irSize, std::int64_t irModified) const;
+    static std::string serialize(const BinaryIrReader &ir, std::uint64_t irSize, std::int64_t irModified);
+
+    std::string m_irPath;
+    std::unique_ptr<BinaryIrReader> m_ir;
+    bool m_rebuilt {false};
+    const void *m_data {nullptr};
+    std::size_t m_size {0};
+    bool m_mapped {false};
+    std::string m_buffer;
+    const std::uint32_t *m_buckets {nullptr};
+    const std::uint32_t *m_names {nullptr};
+    const std::uint32_t *m_parents {nullptr};
+    const IxRange *m_childRanges {nullptr};
+    const std::uint32_t *m_children {nullptr};
+    const IxType *m_types {nullptr};
+    const std::uint32_t *m_typeModels {nullptr};
+};
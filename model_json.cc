@@ -0,0 +1,94 @@
+#include "model_json.h"
+
+static boost::json::array stringsToJson(const std::vector<std::string> &strings)
+{
+    boost::json::array arr;
+    for (auto& str : strings)
+        arr.push_back(boost::json::string(str));
+    return arr;
+}
+
+// as_string().c_str() would stop at the NUL of a decoded "\0" literal
+static std::string jsonString(const boost::json::value &value)
+{
+    const boost::json::string &str = value.as_string();
+    return std::string(str.data(), str.size());
+}
+
+boost::json::array modelsToJson(const std::vector<Model> &models)
+{
+    using namespace boost::json;
+    array arr;
+
+    for (auto& m : models) {
+        object obj;
+        array attributes;
+
+        if (!m.parent.empty())
+            obj["parent"] = m.parent;
+
+        obj["name"] = m.name;
+        for (auto& a : m.attributes) {
+            object attribute;
+            attribute["name"] = a.name;
+            attribute["description"] = a.description;
+            attribute["type"] = a.type;
+            attribute["initialValue"] = a.initialValue;
+            attribute["accessor"] = stringsToJson(a.accessor);
+            attribute["checker"] = a.checker;
+            attribute["checkerArguments"] = stringsToJson(a.checkerArguments);
+
+            if (!a.flags.empty())
+                attribute["flags"] = a.flags;
+
+            attributes.push_back(attribute);
+        }
+        obj["attributes"] = attributes;
+
+        arr.push_back(obj);
+    }
+
+    return arr;
+}
+
+std::vector<Model> modelsFromJson(const boost::json::value &json)
+{
+    std::vector<Model> models;
+
+    for (auto& m : json.as_array()) {
+        auto& obj = m.as_object();
+        Model model {jsonString(obj.at("name"))};
+
+        if (auto parent = obj.if_contains("parent"))
+            model.parent = jsonString(*parent);
+
+        for (auto& a : obj.at("attributes").as_array()) {
+            auto& attrObj = a.as_object();
+            Attribute attribute;
+            attribute.name = jsonString(attrObj.at("name"));
+            attribute.description = jsonString(attrObj.at("description"));
+            attribute.type = jsonString(attrObj.at("type"));
+
+            // attribute metadata is missing from files written by older versions
+            if (auto initialValue = attrObj.if_contains("initialValue"))
+                attribute.initialValue = jsonString(*initialValue);
+            if (auto accessor = attrObj.if_contains("accessor")) {
+                for (auto& target : accessor->as_array())
+                    attribute.accessor.push_back(jsonString(target));
+            }
+            if (auto checker = attrObj.if_contains("checker"))
+                attribute.checker = jsonString(*checker);
+            if (auto checkerArguments = attrObj.if_contains("checkerArguments")) {
+                for (auto& arg : checkerArguments->as_array())
+                    attribute.checkerArguments.push_back(jsonString(arg));
+            }
+            if (auto flags = attrObj.if_contains("flags"))
+                attribute.flags = jsonString(*flags);
+            model.attributes.push_back(attribute);
+        }
+
+        models.push_back(model);
+    }
+
+    return models;
+}
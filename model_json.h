@@ -0,0 +1,11 @@
+#pragma once
+
+#include <vector>
+
+#include <boost/json.hpp>
+
+#include "model.h"
+
+// JSON representation of the extracted models, as exported by Splash.
+boost::json::array modelsToJson(const std::vector<Model> &models);
+std::vector<Model> modelsFromJson(const boost::json::value &json);
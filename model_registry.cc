@@ -0,0 +1,56 @@
+#include "model_registry.h"
+
+#include <algorithm>
+#include <functional>
+
+bool ModelRegistry::claim(const std::string &usr, const std::string &name, std::size_t unit, const std::string &file)
+{
+    // workers mostly claim different models, one lock per shard keeps them apart
+    Shard &shard = m_shards[std::hash<std::string>{}(usr) % SHARDS];
+    std::lock_guard<std::mutex> lock(shard.mutex);
+
+    auto [it, inserted] = shard.entries.try_emplace(usr);
+    Entry &entry = it->second;
+    if (inserted) {
+        entry.name = name;
+        entry.firstUnit = unit;
+        entry.files.emplace_back(unit, file);
+        return true;
+    }
+
+    auto sameFile = [&file](const auto &f) { return f.second == file; };
+    if (std::find_if(entry.files.begin(), entry.files.end(), sameFile) == entry.files.end())
+        entry.files.emplace_back(unit, file);
+
+    // a unit extracted again, in watch mode, keeps its models
+    if (unit <= entry.firstUnit) {
+        entry.firstUnit = unit;
+        return true;
+    }
+
+    m_duplicates++;
+    return false;
+}
+
+std::vector<ModelConflict> ModelRegistry::conflicts() const
+{
+    std::vector<ModelConflict> conflicts;
+    for (auto& shard : m_shards) {
+        for (auto& [usr, entry] : shard.entries) {
+            if (entry.files.size() < 2)
+                continue;
+
+            auto files = entry.files;
+            std::sort(files.begin(), files.end());
+            std::vector<std::string> paths;
+            for (auto& f : files)
+                paths.push_back(f.second);
+            conflicts.emplace_back(usr, entry.name, paths);
+        }
+    }
+
+    std::sort(conflicts.begin(), conflicts.end(), [](const ModelConflict &a, const ModelConflict &b) {
+        return a.name != b.name ? a.name < b.name : a.usr < b.usr;
+    });
+    return conflicts;
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// A class whose GetTypeId is defined in more than one input file
+class ModelConflict {
+public:
+    ModelConflict(std::string u, std::string n, std::vector<std::string> f):
+        usr {u},
+        name {n},
+        files {f}
+    {}
+
+    std::string usr;
+    std::string name;
+    // in input order, the models of the first one are kept
+    std::vector<std::string> files;
+};
+
+// Concurrent seen-set of the models extracted by the workers, keyed by the
+// USR of their class. The first unit in input order defining a model owns
+// it, so the kept models do not depend on the scheduling of the workers.
+class ModelRegistry
+{
+public:
+    ModelRegistry() {}
+
+    // True if unit is the first unit claiming usr so far: it has to
+    // extract the model, which no lower unit will
+    bool claim(const std::string &usr, const std::string &name, std::size_t unit, const std::string &file);
+
+    std::size_t duplicates() const { return m_duplicates; }
+    // sorted by model name, once every unit is extracted
+    std::vector<ModelConflict> conflicts() const;
+
+private:
+    class Entry {
+    public:
+        Entry() {}
+
+        std::string name;
+        std::size_t firstUnit {0};
+        // distinct files defining the model, with the unit of each
+        std::vector<std::pair<std::size_t, std::string>> files;
+    };
+
+    class Shard {
+    public:
+        std::mutex mutex;
+        std::unordered_map<std::string, Entry> entries;
+    };
+
+    static constexpr std::size_t SHARDS = 64;
+
+    std::array<Shard, SHARDS> m_shards;
+    std::atomic<std::size_t> m_duplicates {0};
+};
@@ -0,0 +1,210 @@
+#include "model_scanner.h"
+
+#include <cctype>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+static bool isIdentifierStart(char c)
+{
+    return std::isalpha(static_cast<unsigned char>(c)) || c == '_';
+}
+
+static bool isIdentifierChar(char c)
+{
+    return std::isalnum(static_cast<unsigned char>(c)) || c == '_';
+}
+
+ScanResult ModelScanner::scan(std::string_view source)
+{
+    ScanResult result;
+    const auto tokens = tokenize(source);
+
+    // the class of every open brace, empty for other blocks. The name after
+    // class or struct owns the next brace, unless a declaration ends first.
+    std::vector<std::string_view> scopes;
+    std::string_view pendingClass;
+    for (std::size_t i = 0; i < tokens.size(); i++) {
+        const std::string_view text = tokens[i].text;
+        if (tokens[i].kind == TokenKind::Punctuation) {
+            if (text == "{") {
+                scopes.push_back(pendingClass);
+                pendingClass = {};
+            } else if (text == "}") {
+                if (!scopes.empty())
+                    scopes.pop_back();
+            } else if (text == ";" || text == "(" || text == "=") {
+                pendingClass = {};
+            }
+            continue;
+        }
+        if (tokens[i].kind != TokenKind::Identifier)
+            continue;
+
+        if ((text == "class" || text == "struct") && i + 1 < tokens.size() &&
+            tokens[i + 1].kind == TokenKind::Identifier) {
+            pendingClass = tokens[i + 1].text;
+        } else if (text == "AddAttribute") {
+            result.addAttributeCalls++;
+        } else if (text == "GetTypeId") {
+            auto name = definedClass(tokens, i, scopes.empty() ? std::string_view {} : scopes.back());
+            if (!name.empty())
+                result.classes.emplace_back(name);
+        }
+    }
+
+    return result;
+}
+
+bool ModelScanner::scanFile(const std::string &path, ScanResult &result)
+{
+    std::ifstream ifs(path, std::ios::binary);
+    if (!ifs)
+        return false;
+
+    const std::string source {std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>()};
+    result = scan(source);
+    return true;
+}
+
+std::string_view ModelScanner::definedClass(const std::vector<Token> &tokens, std::size_t getTypeId,
+                                           std::string_view enclosingClass)
+{
+    // a definition is followed by "( [void] ) {", a call by anything else
+    std::size_t next = getTypeId + 1;
+    if (next >= tokens.size() || tokens[next].text != "(")
+        return {};
+    next++;
+    if (next < tokens.size() && tokens[next].text == "void")
+        next++;
+    if (next + 1 >= tokens.size() || tokens[next].text != ")" || tokens[next + 1].text != "{")
+        return {};
+
+    // defined inline in the body of its class
+    if (getTypeId == 0 || tokens[getTypeId - 1].kind != TokenKind::Scope)
+        return enclosingClass;
+
+    // preceded by "Class ::" or "Class <...> ::"
+    if (getTypeId < 2)
+        return {};
+    std::size_t name = getTypeId - 2;
+    if (tokens[name].text == ">") {
+        unsigned depth = 0;
+        for (;; name--) {
+            if (tokens[name].text == ">")
+                depth++;
+            else if (tokens[name].text == "<" && --depth == 0)
+                break;
+            if (name == 0)
+                return {};
+        }
+        if (name == 0)
+            return {};
+        name--;
+    }
+
+    return tokens[name].kind == TokenKind::Identifier ? tokens[name].text : std::string_view {};
+}
+
+std::vector<ModelScanner::Token> ModelScanner::tokenize(std::string_view source)
+{
+    std::vector<Token> tokens;
+    const std::size_t size = source.size();
+    bool lineStart = true;
+
+    for (std::size_t i = 0; i < size; ) {
+        const char c = source[i];
+
+        if (c == '\n') {
+            lineStart = true;
+            i++;
+            continue;
+        }
+        if (std::isspace(static_cast<unsigned char>(c))) {
+            i++;
+            continue;
+        }
+
+        if (c == '/' && i + 1 < size && source[i + 1] == '/') {
+            i = source.find('\n', i);
+            if (i == std::string_view::npos)
+                break;
+            continue;
+        }
+        if (c == '/' && i + 1 < size && source[i + 1] == '*') {
+            const auto end = source.find("*/", i + 2);
+            i = end == std::string_view::npos ? size : end + 2;
+            continue;
+        }
+
+        // preprocessor directives, with their continuation lines
+        if (c == '#' && lineStart) {
+            while (i < size && source[i] != '\n') {
+                if (source[i] == '\\' && i + 1 < size && source[i + 1] == '\n')
+                    i++;
+                i++;
+            }
+            continue;
+        }
+        lineStart = false;
+
+        if (isIdentifierStart(c)) {
+            std::size_t end = i + 1;
+            while (end < size && isIdentifierChar(source[end]))
+                end++;
+
+            // R"delimiter( ... )delimiter", possibly with an encoding prefix
+            if (end < size && source[end] == '"' && source[end - 1] == 'R') {
+                const auto open = source.find('(', end + 1);
+                if (open == std::string_view::npos)
+                    break;
+                const std::string close = ")" + std::string(source.substr(end + 1, open - end - 1)) + "\"";
+                const auto stop = source.find(close, open + 1);
+                tokens.emplace_back(TokenKind::Other, source.substr(i, 1));
+                i = stop == std::string_view::npos ? size : stop + close.size();
+                continue;
+            }
+
+            tokens.emplace_back(TokenKind::Identifier, source.substr(i, end - i));
+            i = end;
+            continue;
+        }
+
+        if (std::isdigit(static_cast<unsigned char>(c)) || (c == '.' && i + 1 < size && std::isdigit(static_cast<unsigned char>(source[i + 1])))) {
+            // pp-number, with digit separators and exponent signs
+            std::size_t end = i + 1;
+            while (end < size) {
+                const char d = source[end];
+                if (isIdentifierChar(d) || d == '.' || d == '\'')
+                    end++;
+                else if ((d == '+' || d == '-') && std::strchr("eEpP", source[end - 1]))
+                    end++;
+                else
+                    break;
+            }
+            tokens.emplace_back(TokenKind::Other, source.substr(i, end - i));
+            i = end;
+            continue;
+        }
+
+        if (c == '"' || c == '\'') {
+            std::size_t end = i + 1;
+            while (end < size && source[end] != c && source[end] != '\n')
+                end += source[end] == '\\' ? 2 : 1;
+            tokens.emplace_back(TokenKind::Other, source.substr(i, 1));
+            i = end + 1;
+            continue;
+        }
+
+        if (c == ':' && i + 1 < size && source[i + 1] == ':') {
+            tokens.emplace_back(TokenKind::Scope, source.substr(i, 2));
+            i += 2;
+            continue;
+        }
+
+        tokens.emplace_back(TokenKind::Punctuation, source.substr(i, 1));
+        i++;
+    }
+
+    return tokens;
+}
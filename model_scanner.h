@@ -0,0 +1,46 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+// What a lexical scan of a source file expects the full parse to extract
+class ScanResult {
+public:
+    ScanResult() {}
+
+    bool mayContainModels() const { return !classes.empty(); }
+
+    // classes whose GetTypeId is defined in the file, in order
+    std::vector<std::string> classes;
+    std::size_t addAttributeCalls {0};
+};
+
+// Hand-written scanner finding "Class::GetTypeId () {" definitions, and
+// "GetTypeId () {" ones in the body of "class Class {", in the text of a
+// main file, skipping comments, literals and preprocessor lines.
+// It neither includes headers nor expands macros, so it is orders of
+// magnitude cheaper than a parse but may miss a model defined by a macro.
+class ModelScanner
+{
+public:
+    static ScanResult scan(std::string_view source);
+    // False if the file cannot be read
+    static bool scanFile(const std::string &path, ScanResult &result);
+
+private:
+    enum class TokenKind { Identifier, Scope, Punctuation, Other };
+
+    class Token {
+    public:
+        Token(TokenKind k, std::string_view t) : kind {k}, text {t} {}
+
+        TokenKind kind;
+        std::string_view text;
+    };
+
+    static std::vector<Token> tokenize(std::string_view source);
+    // Empty if the GetTypeId at getTypeId is not defined there
+    static std::string_view definedClass(const std::vector<Token> &tokens, std::size_t getTypeId,
+                                         std::string_view enclosingClass);
+};
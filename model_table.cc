@@ -0,0 +1,102 @@
+#include "model_table.h"
+
+void ModelTable::append(const Model &model)
+{
+    m_names.push_back(m_strings.intern(model.name));
+    m_parents.push_back(m_strings.intern(model.parent));
+    m_qualifiedNames.push_back(m_strings.intern(model.qualifiedName));
+    m_firstAttributes.push_back(m_attributeRefs.size());
+    m_attributeCounts.push_back(model.attributes.size());
+
+    for (auto& a : model.attributes) {
+        AttributeRecord attribute;
+        attribute.name = m_strings.intern(a.name);
+        attribute.description = m_strings.intern(a.description);
+        attribute.type = m_strings.intern(a.type);
+        attribute.initialValue = m_strings.intern(a.initialValue);
+        attribute.checker = m_strings.intern(a.checker);
+        attribute.flags = m_strings.intern(a.flags);
+        attribute.firstAccessor = appendList(a.accessor);
+        attribute.accessorCount = a.accessor.size();
+        attribute.firstCheckerArgument = appendList(a.checkerArguments);
+        attribute.checkerArgumentCount = a.checkerArguments.size();
+
+        m_attributeRefs.push_back(m_attributes.size());
+        m_attributes.push_back(attribute);
+    }
+}
+
+std::uint32_t ModelTable::appendList(const std::vector<std::string> &strings)
+{
+    const auto first = static_cast<std::uint32_t>(m_listStrings.size());
+    for (auto& str : strings)
+        m_listStrings.push_back(m_strings.intern(str));
+    return first;
+}
+
+void ModelTable::inheritAttributes(const std::vector<std::size_t> &order, const std::vector<std::size_t> &parents)
+{
+    std::vector<std::uint32_t> refs;
+    std::vector<std::uint32_t> firsts(size());
+    std::vector<std::uint32_t> counts(size());
+    std::vector<bool> visited(size(), false);
+    refs.reserve(m_attributeRefs.size());
+
+    auto appendOwn = [&](std::size_t model) {
+        firsts[model] = refs.size();
+        refs.insert(refs.end(), m_attributeRefs.begin() + m_firstAttributes[model],
+                    m_attributeRefs.begin() + m_firstAttributes[model] + m_attributeCounts[model]);
+        visited[model] = true;
+    };
+
+    for (auto model : order) {
+        appendOwn(model);
+
+        // the parent range is already complete in refs
+        const std::size_t parent = parents[model];
+        if (parent != NO_PARENT) {
+            for (std::uint32_t i = 0; i < counts[parent]; i++) {
+                const std::uint32_t ref = refs[firsts[parent] + i];
+                refs.push_back(ref);
+            }
+        }
+        counts[model] = refs.size() - firsts[model];
+    }
+
+    // models left out of the order keep their own attributes only
+    for (std::size_t model = 0; model < size(); model++) {
+        if (!visited[model]) {
+            appendOwn(model);
+            counts[model] = refs.size() - firsts[model];
+        }
+    }
+
+    m_attributeRefs = std::move(refs);
+    m_firstAttributes = std::move(firsts);
+    m_attributeCounts = std::move(counts);
+}
+
+Model ModelTable::model(std::size_t model) const
+{
+    Model result {std::string(name(model))};
+    result.parent = parent(model);
+    result.qualifiedName = qualifiedName(model);
+
+    for (std::uint32_t i = 0; i < attributeCount(model); i++) {
+        const AttributeRecord &a = attribute(model, i);
+        Attribute attr;
+        attr.name = string(a.name);
+        attr.description = string(a.description);
+        attr.type = string(a.type);
+        attr.initialValue = string(a.initialValue);
+        attr.checker = string(a.checker);
+        attr.flags = string(a.flags);
+        for (std::uint32_t k = 0; k < a.accessorCount; k++)
+            attr.accessor.emplace_back(listString(a.firstAccessor + k));
+        for (std::uint32_t k = 0; k < a.checkerArgumentCount; k++)
+            attr.checkerArguments.emplace_back(listString(a.firstCheckerArgument + k));
+        result.attributes.push_back(std::move(attr));
+    }
+
+    return result;
+}
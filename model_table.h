@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+#include "model.h"
+#include "string_pool.h"
+
+// Attribute of a model, every string is an id in the table's pool
+class AttributeRecord {
+public:
+    StringId name;
+    StringId description;
+    StringId type;
+    StringId initialValue;
+    StringId checker;
+    StringId flags;
+    // ranges in the table's string lists
+    std::uint32_t firstAccessor;
+    std::uint32_t accessorCount;
+    std::uint32_t firstCheckerArgument;
+    std::uint32_t checkerArgumentCount;
+};
+
+// Models of a whole run as a structure of arrays. Strings are interned, so a
+// type or parent name shared by thousands of attributes is stored once, and a
+// model references its attributes by index, so inherited attributes are not
+// copied. Per unit Model vectors are merged in with append.
+class ModelTable
+{
+public:
+    ModelTable() {}
+
+    void append(const Model &model);
+
+    std::size_t size() const { return m_names.size(); }
+    bool empty() const { return m_names.empty(); }
+
+    std::string_view string(StringId id) const { return m_strings.get(id); }
+    std::string_view name(std::size_t model) const { return string(m_names[model]); }
+    std::string_view parent(std::size_t model) const { return string(m_parents[model]); }
+    std::string_view qualifiedName(std::size_t model) const { return string(m_qualifiedNames[model]); }
+    StringId nameId(std::size_t model) const { return m_names[model]; }
+    StringId parentId(std::size_t model) const { return m_parents[model]; }
+    StringId qualifiedNameId(std::size_t model) const { return m_qualifiedNames[model]; }
+
+    std::uint32_t attributeCount(std::size_t model) const { return m_attributeCounts[model]; }
+    const AttributeRecord& attribute(std::size_t model, std::uint32_t i) const
+    {
+        return m_attributes[m_attributeRefs[m_firstAttributes[model] + i]];
+    }
+    std::string_view listString(std::uint32_t i) const { return string(m_listStrings[i]); }
+    StringId listStringId(std::uint32_t i) const { return m_listStrings[i]; }
+
+    // Appends to each model the attributes of its parent, models are visited
+    // in order and every parent must come before its children
+    static constexpr std::size_t NO_PARENT = static_cast<std::size_t>(-1);
+    void inheritAttributes(const std::vector<std::size_t> &order, const std::vector<std::size_t> &parents);
+
+    Model model(std::size_t model) const;
+
+    const StringPool& strings() const { return m_strings; }
+
+private:
+    std::uint32_t appendList(const std::vector<std::string> &strings);
+
+    StringPool m_strings;
+
+    // model columns
+    std::vector<StringId> m_names;
+    std::vector<StringId> m_parents;
+    std::vector<StringId> m_qualifiedNames;
+    std::vector<std::uint32_t> m_firstAttributes;
+    std::vector<std::uint32_t> m_attributeCounts;
+
+    // attributes of model i are m_attributeRefs[m_firstAttributes[i] + k]
+    std::vector<std::uint32_t> m_attributeRefs;
+    std::vector<AttributeRecord> m_attributes;
+    std::vector<StringId> m_listStrings;
+};
@@ -0,0 +1,379 @@
+#include "model_writer.h"
+
+#include <filesystem>
+#include <vector>
+
+#include "binary_ir.h"
+
+#ifdef SPLASH_HAVE_ZLIB
+#include <zlib.h>
+#endif
+#ifdef SPLASH_HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+// the buffer is handed to the file or the encoder once it grows past this
+static const std::size_t FLUSH_THRESHOLD = 1 << 16;
+
+// Compresses the serialized models on their way to the file
+class ModelWriter::Encoder
+{
+public:
+    virtual ~Encoder() {}
+
+    // finish terminates the compressed stream, returns false on errors
+    virtual bool write(std::FILE *file, std::string_view data, bool finish) = 0;
+};
+
+#ifdef SPLASH_HAVE_ZLIB
+class ModelWriter::GzipEncoder : public ModelWriter::Encoder
+{
+public:
+    GzipEncoder()
+    {
+        // 15 window bits, +16 for a gzip header instead of a zlib one
+        m_ready = deflateInit2(&m_stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8,
+                               Z_DEFAULT_STRATEGY) == Z_OK;
+    }
+
+    ~GzipEncoder() override
+    {
+        if (m_ready)
+            deflateEnd(&m_stream);
+    }
+
+    bool write(std::FILE *file, std::string_view data, bool finish) override
+    {
+        if (!m_ready)
+            return false;
+
+        m_stream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data.data()));
+        m_stream.avail_in = data.size();
+
+        int ret;
+        do {
+            m_stream.next_out = m_out;
+            m_stream.avail_out = sizeof(m_out);
+            ret = deflate(&m_stream, finish ? Z_FINISH : Z_NO_FLUSH);
+            if (ret == Z_STREAM_ERROR)
+                return false;
+
+            const std::size_t size = sizeof(m_out) - m_stream.avail_out;
+            if (std::fwrite(m_out, 1, size, file) != size)
+                return false;
+        } while (m_stream.avail_out == 0 || (finish && ret != Z_STREAM_END));
+
+        return true;
+    }
+
+private:
+    z_stream m_stream {};
+    Bytef m_out[FLUSH_THRESHOLD];
+    bool m_ready {false};
+};
+#endif
+
+#ifdef SPLASH_HAVE_ZSTD
+class ModelWriter::ZstdEncoder : public ModelWriter::Encoder
+{
+public:
+    ZstdEncoder() :
+        m_stream {ZSTD_createCStream()},
+        m_out(ZSTD_CStreamOutSize())
+    {}
+
+    ~ZstdEncoder() override
+    {
+        ZSTD_freeCStream(m_stream);
+    }
+
+    bool write(std::FILE *file, std::string_view data, bool finish) override
+    {
+        if (m_stream == nullptr)
+            return false;
+
+        ZSTD_inBuffer in {data.data(), data.size(), 0};
+        std::size_t remaining;
+        do {
+            ZSTD_outBuffer out {m_out.data(), m_out.size(), 0};
+            remaining = ZSTD_compressStream2(m_stream, &out, &in, finish ? ZSTD_e_end : ZSTD_e_continue);
+            if (ZSTD_isError(remaining))
+                return false;
+
+            if (std::fwrite(m_out.data(), 1, out.pos, file) != out.pos)
+                return false;
+        } while (finish ? remaining != 0 : in.pos < in.size);
+
+        return true;
+    }
+
+private:
+    ZSTD_CStream *m_stream;
+    std::vector<char> m_out;
+};
+#endif
+
+ModelWriter::ModelWriter(const std::string &path, bool append) :
+    m_path {path}
+{
+    const Compression compression = compressionFromPath(path);
+    std::error_code ec;
+    const bool appendToExisting = append && fs::exists(path, ec) && fs::file_size(path, ec) > 0;
+
+    if (appendToExisting && compression != Compression::None)
+        throw ModelWriterException(path, "cannot append to a compressed output");
+
+    if (compression == Compression::Gzip) {
+#ifdef SPLASH_HAVE_ZLIB
+        m_encoder = std::make_unique<GzipEncoder>();
+#else
+        throw ModelWriterException(path, "splash was built without zlib, gzip output is unavailable");
+#endif
+    } else if (compression == Compression::Zstd) {
+#ifdef SPLASH_HAVE_ZSTD
+        m_encoder = std::make_unique<ZstdEncoder>();
+#else
+        throw ModelWriterException(path, "splash was built without zstd, zstd output is unavailable");
+#endif
+    }
+
+    if (appendToExisting) {
+        reopenArray();
+    } else {
+        // written aside and renamed on close, readers never see a partial array
+        m_temporaryPath = BinaryIr::temporaryPath(path);
+        m_file = std::fopen(m_temporaryPath.c_str(), "wb");
+        if (m_file == nullptr)
+            throw ModelWriterException(path, "cannot open the file for writing");
+        put('[');
+    }
+
+    m_buffer.reserve(FLUSH_THRESHOLD + FLUSH_THRESHOLD / 4);
+}
+
+ModelWriter::~ModelWriter()
+{
+    if (m_file == nullptr)
+        return;
+
+    // an export abandoned halfway leaves the previous output in place
+    if (!m_temporaryPath.empty()) {
+        std::fclose(m_file);
+        std::error_code ec;
+        fs::remove(m_temporaryPath, ec);
+        return;
+    }
+
+    try {
+        close();
+    } catch (const ModelWriterException &) {
+    }
+}
+
+void ModelWriter::reopenArray()
+{
+    // continue the array in place of its closing bracket
+    m_file = std::fopen(m_path.c_str(), "r+b");
+    if (m_file == nullptr)
+        throw ModelWriterException(m_path, "cannot open the file for appending");
+
+    long end = 0;
+    bool empty = false;
+    if (std::fseek(m_file, 0, SEEK_END) == 0)
+        end = std::ftell(m_file);
+
+    // last two non blank characters, "[]" is an empty array
+    char last[2] = {0, 0};
+    for (long pos = end - 1, found = 0; pos >= 0 && found < 2; pos--) {
+        std::fseek(m_file, pos, SEEK_SET);
+        int c = std::fgetc(m_file);
+        if (c == ' ' || c == '\n' || c == '\r' || c == '\t')
+            continue;
+        if (found == 0)
+            end = pos;
+        last[found++] = static_cast<char>(c);
+    }
+    empty = last[1] == '[';
+
+    if (last[0] != ']') {
+        std::fclose(m_file);
+        m_file = nullptr;
+        throw ModelWriterException(m_path, "the file does not hold a JSON array");
+    }
+
+    std::fclose(m_file);
+    std::error_code ec;
+    fs::resize_file(m_path, end, ec);
+    m_file = std::fopen(m_path.c_str(), "ab");
+    if (ec || m_file == nullptr)
+        throw ModelWriterException(m_path, "cannot open the file for appending");
+
+    m_empty = empty;
+}
+
+void ModelWriter::write(const ModelTable &models, std::size_t model)
+{
+    if (!m_empty)
+        put(',');
+    m_empty = false;
+
+    put('{');
+    if (!models.parent(model).empty()) {
+        put("\"parent\":");
+        putString(models.parent(model));
+        put(',');
+    }
+    put("\"name\":");
+    putString(models.name(model));
+
+    put(",\"attributes\":[");
+    for (std::uint32_t i = 0; i < models.attributeCount(model); i++) {
+        const AttributeRecord &a = models.attribute(model, i);
+        if (i > 0)
+            put(',');
+
+        put("{\"name\":");
+        putString(models.string(a.name));
+        put(",\"description\":");
+        putString(models.string(a.description));
+        put(",\"type\":");
+        putString(models.string(a.type));
+        put(",\"initialValue\":");
+        putString(models.string(a.initialValue));
+
+        put(",\"accessor\":[");
+        for (std::uint32_t j = 0; j < a.accessorCount; j++) {
+            if (j > 0)
+                put(',');
+            putString(models.listString(a.firstAccessor + j));
+        }
+        put("],\"checker\":");
+        putString(models.string(a.checker));
+
+        put(",\"checkerArguments\":[");
+        for (std::uint32_t j = 0; j < a.checkerArgumentCount; j++) {
+            if (j > 0)
+                put(',');
+            putString(models.listString(a.firstCheckerArgument + j));
+        }
+        put(']');
+
+        if (a.flags != StringPool::EMPTY) {
+            put(",\"flags\":");
+            putString(models.string(a.flags));
+        }
+        put('}');
+    }
+    put("]}");
+
+    if (m_buffer.size() >= FLUSH_THRESHOLD)
+        flush();
+}
+
+void ModelWriter::close()
+{
+    if (m_file == nullptr)
+        return;
+
+    put(']');
+
+    const bool written = m_encoder ? m_encoder->write(m_file, m_buffer, true)
+                                   : std::fwrite(m_buffer.data(), 1, m_buffer.size(), m_file) == m_buffer.size();
+    m_buffer.clear();
+
+    const bool closed = std::fclose(m_file) == 0;
+    m_file = nullptr;
+
+    bool renamed = true;
+    if (!m_temporaryPath.empty()) {
+        std::error_code ec;
+        if (written && closed)
+            fs::rename(m_temporaryPath, m_path, ec);
+        renamed = written && closed && !ec;
+        if (!renamed)
+            fs::remove(m_temporaryPath, ec);
+        m_temporaryPath.clear();
+    }
+
+    if (!written || !closed || !renamed)
+        throw ModelWriterException(m_path, "write failed");
+}
+
+ModelWriter::Compression ModelWriter::compressionFromPath(const std::string &path)
+{
+    const std::string extension = fs::path(path).extension().string();
+
+    if (extension == ".gz")
+        return Compression::Gzip;
+    if (extension == ".zst")
+        return Compression::Zstd;
+    return Compression::None;
+}
+
+bool ModelWriter::isSupported(Compression compression)
+{
+    switch (compression) {
+#ifdef SPLASH_HAVE_ZLIB
+        case Compression::Gzip: return true;
+#endif
+#ifdef SPLASH_HAVE_ZSTD
+        case Compression::Zstd: return true;
+#endif
+        case Compression::None: return true;
+        default:                return false;
+    }
+}
+
+void ModelWriter::put(std::string_view str)
+{
+    m_buffer.append(str);
+}
+
+void ModelWriter::put(char c)
+{
+    m_buffer.push_back(c);
+}
+
+void ModelWriter::putString(std::string_view str)
+{
+    appendString(m_buffer, str);
+}
+
+void ModelWriter::appendString(std::string &out, std::string_view str)
+{
+    static const char hex[] = "0123456789abcdef";
+
+    out.push_back('"');
+    for (char c : str) {
+        switch (c) {
+            case '"':  out.append("\\\""); break;
+            case '\\': out.append("\\\\"); break;
+            case '\b': out.append("\\b"); break;
+            case '\f': out.append("\\f"); break;
+            case '\n': out.append("\\n"); break;
+            case '\r': out.append("\\r"); break;
+            case '\t': out.append("\\t"); break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    out.append("\\u00");
+                    out.push_back(hex[(c >> 4) & 0xf]);
+                    out.push_back(hex[c & 0xf]);
+                } else {
+                    out.push_back(c);
+                }
+        }
+    }
+    out.push_back('"');
+}
+
+void ModelWriter::flush()
+{
+    const bool written = m_encoder ? m_encoder->write(m_file, m_buffer, false)
+                                   : std::fwrite(m_buffer.data(), 1, m_buffer.size(), m_file) == m_buffer.size();
+    m_buffer.clear();
+
+    if (!written)
+        throw ModelWriterException(m_path, "write failed");
+}
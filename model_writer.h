@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstdio>
+#include <exception>
+#include <memory>
+#include <string>
+#include <string_view>
+
+#include "model_table.h"
+
+class ModelWriterException : std::exception
+{
+public:
+    ModelWriterException(std::string path, std::string reason):
+        outputPath {path},
+        reason {reason}
+    {}
+
+    std::string outputPath;
+    std::string reason;
+};
+
+// Streams models into a JSON array one at a time, without building a JSON
+// document first. The output is the same as serializing modelsToJson.
+// Output paths ending in .gz or .zst are compressed when splash is built
+// with zlib or zstd.
+class ModelWriter
+{
+public:
+    enum class Compression { None, Gzip, Zstd };
+
+    // With append set, models are added to the array already in the file
+    ModelWriter(const std::string &path, bool append);
+    ~ModelWriter();
+
+    void write(const ModelTable &models, std::size_t model);
+    void close();
+
+    // Appends str to out as a quoted JSON string
+    static void appendString(std::string &out, std::string_view str);
+
+    static Compression compressionFromPath(const std::string &path);
+    static bool isSupported(Compression compression);
+
+private:
+    class Encoder;
+    class GzipEncoder;
+    class ZstdEncoder;
+
+    void put(std::string_view str);
+    void put(char c);
+    void putString(std::string_view str);
+    void flush();
+    void reopenArray();
+
+    std::string m_path;
+    // written in place of m_path by close, empty when appending
+    std::string m_temporaryPath;
+    std::FILE *m_file {nullptr};
+    std::unique_ptr<Encoder> m_encoder;
+    std::string m_buffer;
+    bool m_empty {true};
+};
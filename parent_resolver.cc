@@ -0,0 +1,119 @@
+#include "parent_resolver.h"
+
+#include <map>
+
+ParentResolver::ParentResolver(ModelTable &models) :
+    m_models {models}
+{
+}
+
+void ParentResolver::resolve()
+{
+    const std::size_t numModels = m_models.size();
+
+    ParentLookup lookup;
+    for (std::size_t i = 0; i < numModels; i++) {
+        lookup.add(i, m_models.name(i), m_models.qualifiedName(i),
+                   m_models.parent(i).empty() && m_models.attributeCount(i) == 0);
+    }
+
+    std::vector<std::vector<std::size_t>> children(numModels);
+    std::vector<std::size_t> parents(numModels, ModelTable::NO_PARENT);
+    std::vector<std::size_t> order;
+    std::map<std::string, std::vector<std::string>> unresolved;
+    order.reserve(numModels);
+
+    for (std::size_t i = 0; i < numModels; i++) {
+        const std::string_view parent = m_models.parent(i);
+        if (parent.empty()) {
+            order.push_back(i);
+            continue;
+        }
+
+        const std::size_t found = lookup.find(parent);
+        if (found == ParentLookup::NONE) {
+            unresolved[std::string(parent)].emplace_back(m_models.name(i));
+            order.push_back(i);
+        } else if (found != i) {
+            children[found].push_back(i);
+            parents[i] = found;
+        }
+    }
+
+    // breadth first from the roots, a parent always comes before its children
+    std::vector<bool> resolved(numModels, false);
+    for (std::size_t k = 0; k < order.size(); k++) {
+        resolved[order[k]] = true;
+        for (auto child : children[order[k]])
+            order.push_back(child);
+    }
+
+    m_models.inheritAttributes(order, parents);
+
+    m_unresolved.clear();
+    for (auto &[parent, names] : unresolved) {
+        m_unresolved.push_back({parent});
+        m_unresolved.back().children = std::move(names);
+    }
+
+    // never reached from a root, the model is its own ancestor
+    m_cyclic.clear();
+    for (std::size_t i = 0; i < numModels; i++) {
+        if (!resolved[i])
+            m_cyclic.emplace_back(m_models.name(i));
+    }
+}
+
+void ParentLookup::keep(std::unordered_map<std::string_view, Entry> &entries, std::string_view key,
+                        std::size_t model, std::string_view qualifiedName, bool empty)
+{
+    auto [it, inserted] = entries.try_emplace(key, Entry {model, empty, qualifiedName});
+    if (inserted)
+        return;
+
+    Entry &entry = it->second;
+    if (!qualifiedName.empty()) {
+        if (entry.qualifiedName.empty())
+            entry.qualifiedName = qualifiedName;
+        else if (entry.qualifiedName != qualifiedName)
+            entry.ambiguous = true;
+    }
+    if (entry.empty && !empty) {
+        entry.model = model;
+        entry.empty = false;
+    }
+}
+
+void ParentLookup::add(std::size_t model, std::string_view name, std::string_view qualifiedName, bool empty)
+{
+    if (!qualifiedName.empty())
+        keep(m_qualified, qualifiedName, model, qualifiedName, empty);
+    keep(m_unqualified, ParentResolver::unqualifiedName(name), model, qualifiedName, empty);
+}
+
+std::size_t ParentLookup::find(std::string_view parent) const
+{
+    auto qualified = m_qualified.find(parent);
+    if (qualified != m_qualified.end())
+        return qualified->second.model;
+
+    const std::string_view name = ParentResolver::unqualifiedName(parent);
+    auto it = m_unqualified.find(name);
+    if (it == m_unqualified.end() || it->second.ambiguous)
+        return NONE;
+    // a qualified parent names another class than the known one
+    if (name.size() != parent.size() && !it->second.qualifiedName.empty())
+        return NONE;
+    return it->second.model;
+}
+
+std::string_view ParentResolver::unqualifiedName(std::string_view name)
+{
+    // models are named after their class alone, parents are spelled with
+    // every enclosing namespace, as ns3::Name or ns3::lte::Name. The
+    // template arguments of a name keep their own qualification.
+    const auto scope = name.substr(0, name.find('<')).rfind("::");
+    if (scope != std::string_view::npos)
+        name.remove_prefix(scope + 2);
+    return name;
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "model_table.h"
+
+// Finds the model named by a SetParent<> type. A parent is matched against
+// the qualified names of the models first, ns3::a::Name never resolving to
+// ns3::b::Name, then against their names alone when a single class bears
+// that name and its qualified name is unknown, or the parent is spelled
+// without namespaces.
+class ParentLookup
+{
+public:
+    static constexpr std::size_t NONE = static_cast<std::size_t>(-1);
+
+    // Models are added in order: the first model of each name wins, unless
+    // it is an empty declaration and a later one is not
+    void add(std::size_t model, std::string_view name, std::string_view qualifiedName, bool empty);
+    std::size_t find(std::string_view parent) const;
+
+private:
+    class Entry {
+    public:
+        std::size_t model;
+        bool empty;
+        std::string_view qualifiedName;
+        // classes of different qualified names share the name
+        bool ambiguous {false};
+    };
+
+    static void keep(std::unordered_map<std::string_view, Entry> &entries, std::string_view key,
+                     std::size_t model, std::string_view qualifiedName, bool empty);
+
+    std::unordered_map<std::string_view, Entry> m_qualified;
+    std::unordered_map<std::string_view, Entry> m_unqualified;
+};
+
+// Links every model to the model named by its SetParent<> and appends the
+// inherited attributes, own attributes first, in a single pass from the
+// roots of the hierarchy down to the leaves.
+class ParentResolver
+{
+public:
+    // Models whose parent is not among the extracted ones
+    class UnresolvedParent {
+    public:
+        UnresolvedParent(std::string p) : parent {p} {}
+
+        std::string parent;
+        std::vector<std::string> children;
+    };
+
+    ParentResolver(ModelTable &models);
+
+    void resolve();
+
+    const std::vector<UnresolvedParent>& unresolvedParents() const { return m_unresolved; }
+    const std::vector<std::string>& cyclicModels() const { return m_cyclic; }
+
+    // name without its namespaces, ns3::lte::Name -> Name
+    static std::string_view unqualifiedName(std::string_view name);
+
+private:
+    ModelTable &m_models;
+    std::vector<UnresolvedParent> m_unresolved;
+    std::vector<std::string> m_cyclic;
+};
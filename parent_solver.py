@@ -97,11 +97,15 @@ class App:
         models = None
 
         # import
-        with open(self.__irs_file, 'r') as f:
-            models = json.loads(f.read())
+        if self.__irs_file.endswith('.spir'):
+            import splash_ir
+            models = splash_ir.load(self.__irs_file)
+        else:
+            with open(self.__irs_file, 'r') as f:
+                models = json.loads(f.read())
 
-            for m in models:
-                g.add_node(m['parent'].replace('ns3::', ''), m['name'], m['attributes'])
+        for m in models:
+            g.add_node(m['parent'].replace('ns3::', ''), m['name'], m['attributes'])
 
         # transform
         g.recover_orphans()
@@ -0,0 +1,345 @@
+#include "query_server.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+#include "model_writer.h"
+
+static void putNames(const ModelIndex &index, const std::vector<std::uint32_t> &models, std::string &out)
+{
+    out.push_back('[');
+    for (std::size_t i = 0; i < models.size(); i++) {
+        if (i > 0)
+            out.push_back(',');
+        ModelWriter::appendString(out, index.name(models[i]));
+    }
+    out.push_back(']');
+}
+
+static void putError(const std::string &message, std::string &out)
+{
+    out.append("{\"error\":");
+    ModelWriter::appendString(out, message);
+    out.push_back('}');
+}
+
+// Streamed from the IR records like ModelWriter, without a JSON document
+static void putModel(const ModelIndex &index, std::uint32_t model, std::string &out)
+{
+    const BinaryIrReader &ir = index.ir();
+    const IrModel &record = ir.model(model);
+
+    out.push_back('{');
+    if (record.parent.size > 0) {
+        out.append("\"parent\":");
+        ModelWriter::appendString(out, ir.string(record.parent));
+        out.push_back(',');
+    }
+    out.append("\"name\":");
+    ModelWriter::appendString(out, ir.string(record.name));
+
+    out.append(",\"attributes\":[");
+    const auto attributes = index.effectiveAttributes(model);
+    for (std::size_t i = 0; i < attributes.size(); i++) {
+        const IrAttribute &a = *attributes[i];
+        if (i > 0)
+            out.push_back(',');
+
+        out.append("{\"name\":");
+        ModelWriter::appendString(out, ir.string(a.name));
+        out.append(",\"description\":");
+        ModelWriter::appendString(out, ir.string(a.description));
+        out.append(",\"type\":");
+        ModelWriter::appendString(out, ir.string(a.type));
+        out.append(",\"initialValue\":");
+        ModelWriter::appendString(out, ir.string(a.initialValue));
+
+        out.append(",\"accessor\":[");
+        for (std::uint32_t j = 0; j < a.accessorCount; j++) {
+            if (j > 0)
+                out.push_back(',');
+            ModelWriter::appendString(out, ir.listString(a.firstAccessor + j));
+        }
+        out.append("],\"checker\":");
+        ModelWriter::appendString(out, ir.string(a.checker));
+
+        out.append(",\"checkerArguments\":[");
+        for (std::uint32_t j = 0; j < a.checkerArgumentCount; j++) {
+            if (j > 0)
+                out.push_back(',');
+            ModelWriter::appendString(out, ir.listString(a.firstCheckerArgument + j));
+        }
+        out.push_back(']');
+
+        if (a.flags.size > 0) {
+            out.append(",\"flags\":");
+            ModelWriter::appendString(out, ir.string(a.flags));
+        }
+        out.push_back('}');
+    }
+    out.append("]}");
+}
+
+void QueryServer::answer(const ModelIndex &index, std::string_view request, std::string &out)
+{
+    while (!request.empty() && (request.back() == '\r' || request.back() == ' '))
+        request.remove_suffix(1);
+    const auto space = request.find(' ');
+    const std::string_view kind = request.substr(0, space);
+    const std::string_view value = space == std::string_view::npos ? std::string_view {} : request.substr(space + 1);
+
+    if (kind == "prefix") {
+        putNames(index, index.withPrefix(value), out);
+    } else if (kind == "type") {
+        putNames(index, index.withAttributeType(value), out);
+    } else if (kind == "name" || kind == "children") {
+        const std::uint32_t model = index.find(value);
+        if (model == ModelIndex::NONE)
+            putError("unknown model " + std::string(value), out);
+        else if (kind == "children")
+            putNames(index, index.children(model), out);
+        else
+            putModel(index, model, out);
+    } else {
+        putError("unknown request " + std::string(kind), out);
+    }
+}
+
+#ifndef _WIN32
+
+static sockaddr_un socketAddress(const std::string &socketPath)
+{
+    sockaddr_un address {};
+    address.sun_family = AF_UNIX;
+    if (socketPath.size() >= sizeof(address.sun_path))
+        throw QueryServerException(socketPath, "socket path too long");
+    std::memcpy(address.sun_path, socketPath.c_str(), socketPath.size() + 1);
+    return address;
+}
+
+std::string QueryServer::ask(const std::string &socketPath, const std::string &request)
+{
+    const sockaddr_un address = socketAddress(socketPath);
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0)
+        throw QueryServerException(socketPath, "cannot create a socket");
+    if (connect(fd, reinterpret_cast<const sockaddr *>(&address), sizeof(address)) != 0) {
+        close(fd);
+        throw QueryServerException(socketPath, "no server is listening");
+    }
+
+    const std::string line = request + "\n";
+    std::size_t sent = 0;
+    while (sent < line.size()) {
+        const ssize_t n = write(fd, line.data() + sent, line.size() - sent);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0) {
+            close(fd);
+            throw QueryServerException(socketPath, "cannot send the request");
+        }
+        sent += n;
+    }
+    shutdown(fd, SHUT_WR);
+
+    std::string reply;
+    char chunk[64 * 1024];
+    while (reply.empty() || reply.back() != '\n') {
+        const ssize_t n = read(fd, chunk, sizeof(chunk));
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            break;
+        reply.append(chunk, n);
+    }
+    close(fd);
+
+    if (reply.empty() || reply.back() != '\n')
+        throw QueryServerException(socketPath, "connection closed before the answer");
+    reply.pop_back();
+    return reply;
+}
+
+QueryServer::QueryServer(const std::string &irPath, const std::string &socketPath) :
+    m_irPath {irPath},
+    m_socketPath {socketPath},
+    m_index {std::make_unique<ModelIndex>(irPath)}
+{
+    const sockaddr_un address = socketAddress(socketPath);
+    m_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (m_fd < 0)
+        throw QueryServerException(socketPath, "cannot create a socket");
+
+    // a socket left behind by a server that is gone is replaced
+    if (bind(m_fd, reinterpret_cast<const sockaddr *>(&address), sizeof(address)) != 0) {
+        if (errno != EADDRINUSE) {
+            close(m_fd);
+            throw QueryServerException(socketPath, std::strerror(errno));
+        }
+        int probe = socket(AF_UNIX, SOCK_STREAM, 0);
+        const bool listening = connect(probe, reinterpret_cast<const sockaddr *>(&address), sizeof(address)) == 0;
+        close(probe);
+        if (listening) {
+            close(m_fd);
+            throw QueryServerException(socketPath, "another server is listening");
+        }
+        unlink(socketPath.c_str());
+        if (bind(m_fd, reinterpret_cast<const sockaddr *>(&address), sizeof(address)) != 0) {
+            close(m_fd);
+            throw QueryServerException(socketPath, std::strerror(errno));
+        }
+    }
+
+    if (listen(m_fd, SOMAXCONN) != 0) {
+        close(m_fd);
+        unlink(socketPath.c_str());
+        throw QueryServerException(socketPath, std::strerror(errno));
+    }
+    fcntl(m_fd, F_SETFL, fcntl(m_fd, F_GETFL) | O_NONBLOCK);
+}
+
+QueryServer::~QueryServer()
+{
+    for (auto& client : m_clients)
+        close(client.fd);
+    close(m_fd);
+    unlink(m_socketPath.c_str());
+}
+
+void QueryServer::reloadIfStale()
+{
+    if (!m_index->isStale())
+        return;
+
+    // the IR is replaced by a rename, the old mapping stays readable
+    try {
+        m_index = std::make_unique<ModelIndex>(m_irPath);
+        m_reloads++;
+    } catch (const BinaryIrException &) {
+    } catch (const ModelIndexException &) {
+    }
+}
+
+bool QueryServer::receive(Client &client)
+{
+    char chunk[4096];
+    const ssize_t n = read(client.fd, chunk, sizeof(chunk));
+    if (n < 0)
+        return errno == EINTR || errno == EAGAIN;
+    if (n == 0) {
+        client.eof = true;
+        return true;
+    }
+    client.input.append(chunk, n);
+
+    std::size_t start = 0;
+    for (auto end = client.input.find('\n'); end != std::string::npos; end = client.input.find('\n', start)) {
+        answer(*m_index, std::string_view(client.input).substr(start, end - start), client.output);
+        client.output.push_back('\n');
+        m_requests++;
+        start = end + 1;
+    }
+    client.input.erase(0, start);
+    return true;
+}
+
+bool QueryServer::send(Client &client)
+{
+    const ssize_t n = write(client.fd, client.output.data(), client.output.size());
+    if (n < 0)
+        return errno == EINTR || errno == EAGAIN;
+    client.output.erase(0, n);
+    return true;
+}
+
+void QueryServer::serve(const volatile std::sig_atomic_t &stop)
+{
+    // a client gone before its answer must not stop the server.
+    // The disposition of the caller is restored afterwards.
+    const auto previousSigpipe = std::signal(SIGPIPE, SIG_IGN);
+    try {
+        answerClients(stop);
+    } catch (...) {
+        std::signal(SIGPIPE, previousSigpipe);
+        throw;
+    }
+    std::signal(SIGPIPE, previousSigpipe);
+}
+
+void QueryServer::answerClients(const volatile std::sig_atomic_t &stop)
+{
+    using Clock = std::chrono::steady_clock;
+    // a stat per half second, not per request
+    constexpr auto RELOAD_PERIOD = std::chrono::milliseconds(500);
+    auto lastCheck = Clock::now();
+
+    std::vector<pollfd> fds;
+    while (!stop) {
+        fds.assign(1, {m_fd, POLLIN, 0});
+        for (auto& client : m_clients)
+            fds.push_back({client.fd, static_cast<short>((client.eof ? 0 : POLLIN) | (client.output.empty() ? 0 : POLLOUT)), 0});
+
+        if (poll(fds.data(), fds.size(), RELOAD_PERIOD.count()) < 0 && errno != EINTR)
+            throw QueryServerException(m_socketPath, "cannot wait for clients");
+
+        if (Clock::now() - lastCheck >= RELOAD_PERIOD) {
+            reloadIfStale();
+            lastCheck = Clock::now();
+        }
+
+        // fds and m_clients match up to the clients accepted below
+        for (std::size_t c = 0; c < m_clients.size(); c++) {
+            Client &client = m_clients[c];
+            const short events = fds[c + 1].revents;
+            bool alive = !(events & (POLLERR | POLLNVAL));
+            if (alive && (events & (POLLIN | POLLHUP)) && !client.eof)
+                alive = receive(client);
+            if (alive && !client.output.empty())
+                alive = send(client);
+            if (!alive || (client.eof && client.output.empty())) {
+                close(client.fd);
+                client.fd = -1;
+            }
+        }
+        m_clients.erase(std::remove_if(m_clients.begin(), m_clients.end(), [](const Client &c) { return c.fd < 0; }),
+                        m_clients.end());
+
+        if (fds[0].revents & POLLIN) {
+            for (int fd; (fd = accept(m_fd, nullptr, nullptr)) >= 0; ) {
+                fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+                m_clients.emplace_back(fd);
+            }
+        }
+    }
+}
+
+#else
+
+std::string QueryServer::ask(const std::string &socketPath, const std::string &)
+{
+    throw QueryServerException(socketPath, "sockets are not supported on this platform");
+}
+
+QueryServer::QueryServer(const std::string &irPath, const std::string &socketPath) :
+    m_irPath {irPath},
+    m_socketPath {socketPath}
+{
+    throw QueryServerException(socketPath, "sockets are not supported on this platform");
+}
+
+QueryServer::~QueryServer() {}
+
+void QueryServer::serve(const volatile std::sig_atomic_t &)
+{
+}
+
+#endif
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <csignal>
+#include <exception>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "model_index.h"
+
+class QueryServerException : std::exception
+{
+public:
+    QueryServerException(std::string path, std::string reason):
+        socketPath {path},
+        reason {reason}
+    {}
+
+    std::string socketPath;
+    std::string reason;
+};
+
+// Answers model lookups on a Unix domain socket from the index of a binary
+// IR. A request is one line, "<kind> <value>", and its answer one JSON line:
+//
+//   name Drone        the model with its effective attributes
+//   prefix Dr         names of the models starting with Dr, sorted
+//   type DoubleValue  names of the models with a DoubleValue attribute
+//   children Object   names of the models whose parent is Object
+//
+// An unknown model or request is answered with {"error": "..."}. The index
+// is reopened when the IR is rewritten. Only available on POSIX systems.
+class QueryServer
+{
+public:
+    static constexpr bool isSupported =
+#ifdef _WIN32
+        false;
+#else
+        true;
+#endif
+
+    // Appends the answer to request to out, without the newline
+    static void answer(const ModelIndex &index, std::string_view request, std::string &out);
+    // Sends request to the server listening on socketPath, returns the answer
+    static std::string ask(const std::string &socketPath, const std::string &request);
+
+    QueryServer(const std::string &irPath, const std::string &socketPath);
+    ~QueryServer();
+
+    // Answers clients until stop is set
+    void serve(const volatile std::sig_atomic_t &stop);
+
+    const ModelIndex& index() const { return *m_index; }
+    std::size_t requests() const { return m_requests; }
+    std::size_t reloads() const { return m_reloads; }
+
+private:
+    class Client {
+    public:
+        Client(int f) : fd {f} {}
+
+        int fd;
+        std::string input;
+        std::string output;
+        // the client sent all its requests, it is closed once answered
+        bool eof {false};
+    };
+
+    void answerClients(const volatile std::sig_atomic_t &stop);
+    void reloadIfStale();
+    // False once the client is gone
+    bool receive(Client &client);
+    bool send(Client &client);
+
+    std::string m_irPath;
+    std::string m_socketPath;
+    std::unique_ptr<ModelIndex> m_index;
+    int m_fd {-1};
+    std::vector<Client> m_clients;
+    std::size_t m_requests {0};
+    std::size_t m_reloads {0};
+};
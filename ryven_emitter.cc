@@ -0,0 +1,319 @@
+#include "ryven_emitter.h"
+
+#include <algorithm>
+#include <exception>
+#include <fstream>
+#include <iterator>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+namespace fs = std::filesystem;
+
+static const std::string_view NODE_NAME_SLOT = "%NODE_NAME%";
+static const std::string_view POPULATE_DICTIONARY_SLOT = "%POPULATE_DICTIONARY%";
+
+MetacodeTemplate::MetacodeTemplate(std::string_view text)
+{
+    std::size_t pos = 0;
+
+    while (pos < text.size()) {
+        const std::size_t nodeName = text.find(NODE_NAME_SLOT, pos);
+        const std::size_t populate = text.find(POPULATE_DICTIONARY_SLOT, pos);
+        const std::size_t next = std::min(nodeName, populate);
+
+        m_segments.emplace_back(std::string(text.substr(pos, next - pos)), Slot::None);
+        m_literalSize += m_segments.back().text.size();
+        if (next == std::string_view::npos)
+            break;
+
+        if (next == nodeName) {
+            m_segments.emplace_back("", Slot::NodeName);
+            pos = next + NODE_NAME_SLOT.size();
+        } else {
+            m_segments.emplace_back("", Slot::PopulateDictionary);
+            pos = next + POPULATE_DICTIONARY_SLOT.size();
+        }
+    }
+}
+
+std::string MetacodeTemplate::render(std::string_view nodeName, std::string_view populateDictionary) const
+{
+    std::string result;
+    result.reserve(m_literalSize + nodeName.size() + populateDictionary.size());
+
+    for (auto& segment : m_segments) {
+        switch (segment.slot) {
+            case Slot::None:               result += segment.text; break;
+            case Slot::NodeName:           result += nodeName; break;
+            case Slot::PopulateDictionary: result += populateDictionary; break;
+        }
+    }
+
+    return result;
+}
+
+RyvenEmitter::RyvenEmitter(const ModelTable &models, std::string packageName, std::string outputDirectory,
+                           std::string_view metacodeTemplate) :
+    m_models {models},
+    m_packageName {packageName},
+    m_packageDirectory {fs::path(outputDirectory) / packageName},
+    m_template {metacodeTemplate},
+    m_typeMap {
+        {"DoubleValue", "float"},
+        {"TimeValue", "float"},
+        {"BooleanValue", "bool"},
+        {"UintegerValue", "int"}
+    }
+{}
+
+void RyvenEmitter::loadTypeMap(const std::string &path)
+{
+    std::ifstream ifs(path);
+    if (!ifs)
+        throw RyvenEmitterException(path, "cannot open the type map");
+
+    std::string line;
+    unsigned lineNumber = 0;
+    while (std::getline(ifs, line)) {
+        lineNumber++;
+        line = line.substr(0, line.find('#'));
+
+        std::istringstream fields(line);
+        std::string type, conversion, extra;
+        if (!(fields >> type))
+            continue;
+        if (!(fields >> conversion) || (fields >> extra))
+            throw RyvenEmitterException(path, "line " + std::to_string(lineNumber) +
+                                              " is not \"<value type> <python conversion>\"");
+
+        m_typeMap[std::string(unqualifiedType(type))] = conversion == "-" ? "" : conversion;
+    }
+}
+
+void RyvenEmitter::emit(unsigned jobs)
+{
+    // models without attributes have no node, a repeated name keeps the last model
+    std::vector<std::size_t> described;
+    std::unordered_map<std::string, std::size_t> byModule;
+    std::vector<std::string> modules;
+    for (std::size_t m = 0; m < m_models.size(); m++) {
+        if (m_models.attributeCount(m) == 0)
+            continue;
+
+        described.push_back(m);
+        auto [it, inserted] = byModule.insert_or_assign(moduleName(m_models.name(m)), m);
+        if (inserted)
+            modules.push_back(it->first);
+    }
+    m_nodes = modules.size();
+
+    std::error_code ec;
+    fs::create_directories(m_packageDirectory / "nodes", ec);
+    if (ec)
+        throw RyvenEmitterException(m_packageDirectory.string(), ec.message());
+
+    removeStaleNodes(modules);
+    writeIfChanged(m_packageDirectory / (m_packageName + ".rpc"), packageDescription(described));
+
+    std::atomic<std::size_t> next {0};
+    std::exception_ptr failure;
+    std::mutex failureMutex;
+
+    auto worker = [&] {
+        for (auto i = next++; i < modules.size(); i = next++) {
+            try {
+                const std::string &module = modules[i];
+                writeIfChanged(m_packageDirectory / "nodes" / module / (module + "___METACODE.py"),
+                               metacode(byModule.at(module)));
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(failureMutex);
+                if (!failure)
+                    failure = std::current_exception();
+                next = modules.size();
+            }
+        }
+    };
+
+    std::vector<std::thread> workers;
+    const std::size_t numWorkers = std::min<std::size_t>(std::max(jobs, 1u), std::max<std::size_t>(modules.size(), 1));
+    for (std::size_t i = 1; i < numWorkers; i++)
+        workers.emplace_back(worker);
+    worker();
+
+    for (auto& w : workers)
+        w.join();
+
+    if (failure)
+        std::rethrow_exception(failure);
+}
+
+std::string RyvenEmitter::moduleName(std::string_view modelName) const
+{
+    return m_packageName + "___" + std::string(modelName) + "0";
+}
+
+std::string RyvenEmitter::metacode(std::size_t model) const
+{
+    std::string populate;
+
+    for (std::uint32_t i = 0; i < m_models.attributeCount(model); i++) {
+        const AttributeRecord &a = m_models.attribute(model, i);
+        const std::string input = "self.input(" + std::to_string(i) + ")";
+        const std::string_view type = conversion(m_models.string(a.type));
+
+        if (i > 0)
+            populate += "\n        ";
+        populate += "if " + input + ": d[\"attributes\"].append({\"name\": \"";
+        populate += m_models.string(a.name);
+        populate += "\", \"value\": ";
+        populate += type.empty() ? input : std::string(type) + "(" + input + ")";
+        populate += "})";
+    }
+
+    return m_template.render("\"ns3::" + std::string(m_models.name(model)) + "\"", populate);
+}
+
+// JSON string as Python's json.dumps writes it, with non ASCII characters escaped
+static void putPythonJsonString(std::string &out, std::string_view str)
+{
+    static const char hex[] = "0123456789abcdef";
+    auto putCodeUnit = [&out](unsigned unit) {
+        out += "\\u";
+        for (int shift = 12; shift >= 0; shift -= 4)
+            out += hex[(unit >> shift) & 0xf];
+    };
+
+    out += '"';
+    for (std::size_t i = 0; i < str.size(); i++) {
+        const unsigned char c = str[i];
+        switch (c) {
+            case '"':  out += "\\\""; continue;
+            case '\\': out += "\\\\"; continue;
+            case '\n': out += "\\n"; continue;
+            case '\r': out += "\\r"; continue;
+            case '\t': out += "\\t"; continue;
+            case '\b': out += "\\b"; continue;
+            case '\f': out += "\\f"; continue;
+        }
+
+        if (c < 0x20 || c == 0x7f) {
+            putCodeUnit(c);
+        } else if (c < 0x80) {
+            out += static_cast<char>(c);
+        } else {
+            // decode a UTF-8 sequence, malformed bytes are escaped one by one
+            const int length = c >= 0xf0 ? 4 : c >= 0xe0 ? 3 : c >= 0xc0 ? 2 : 1;
+            unsigned code = length == 1 ? c : c & (0x3f >> (length - 1));
+            bool valid = length > 1 && i + length <= str.size();
+            for (int k = 1; valid && k < length; k++) {
+                const unsigned char cont = str[i + k];
+                valid = (cont & 0xc0) == 0x80;
+                code = (code << 6) | (cont & 0x3f);
+            }
+
+            if (!valid) {
+                putCodeUnit(c);
+            } else if (code >= 0x10000) {
+                code -= 0x10000;
+                putCodeUnit(0xd800 + (code >> 10));
+                putCodeUnit(0xdc00 + (code & 0x3ff));
+                i += length - 1;
+            } else {
+                putCodeUnit(code);
+                i += length - 1;
+            }
+        }
+    }
+    out += '"';
+}
+
+std::string RyvenEmitter::packageDescription(const std::vector<std::size_t> &models) const
+{
+    std::string out = "{\"type\": \"Ryven nodes package\", \"nodes\": [";
+
+    for (std::size_t n = 0; n < models.size(); n++) {
+        const std::size_t m = models[n];
+        const std::string module = moduleName(m_models.name(m));
+
+        if (n > 0)
+            out += ", ";
+        out += "{\"title\": ";
+        putPythonJsonString(out, m_models.name(m));
+        out += ", \"description\": \"\", \"type\": \"\", \"module name\": ";
+        putPythonJsonString(out, module);
+        out += ", \"class name\": ";
+        putPythonJsonString(out, m_models.name(m));
+        out += ", \"design style\": \"extended\", \"color\": \"#d50000\", \"has main widget\": false, "
+               "\"custom input widgets\": [], \"inputs\": [";
+
+        for (std::uint32_t i = 0; i < m_models.attributeCount(m); i++) {
+            if (i > 0)
+                out += ", ";
+            out += "{\"type\": \"data\", \"label\": ";
+            putPythonJsonString(out, m_models.string(m_models.attribute(m, i).name));
+            out += ", \"has widget\": false}";
+        }
+
+        out += "], \"outputs\": [{\"type\": \"data\", \"label\": \"\"}]}";
+    }
+
+    out += "]}";
+    return out;
+}
+
+std::string_view RyvenEmitter::conversion(std::string_view type) const
+{
+    auto it = m_typeMap.find(std::string(unqualifiedType(type)));
+    return it == m_typeMap.end() ? std::string_view() : std::string_view(it->second);
+}
+
+void RyvenEmitter::writeIfChanged(const fs::path &path, const std::string &content)
+{
+    std::error_code ec;
+    if (fs::file_size(path, ec) == content.size() && !ec) {
+        std::ifstream ifs(path, std::ios::binary);
+        std::string current((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
+        if (current == content) {
+            m_unchanged++;
+            return;
+        }
+    }
+
+    fs::create_directories(path.parent_path(), ec);
+    std::ofstream ofs(path, std::ios::binary | std::ios::trunc);
+    ofs << content;
+    ofs.close();
+    if (!ofs)
+        throw RyvenEmitterException(path.string(), "write failed");
+
+    m_written++;
+}
+
+void RyvenEmitter::removeStaleNodes(const std::vector<std::string> &modules)
+{
+    // node directories of this package whose model is gone
+    const std::string prefix = m_packageName + "___";
+    std::vector<std::string> sorted = modules;
+    std::sort(sorted.begin(), sorted.end());
+
+    std::error_code ec;
+    for (auto& entry : fs::directory_iterator(m_packageDirectory / "nodes", ec)) {
+        const std::string name = entry.path().filename().string();
+        if (!entry.is_directory() || name.compare(0, prefix.size(), prefix) != 0)
+            continue;
+
+        if (!std::binary_search(sorted.begin(), sorted.end(), name)) {
+            fs::remove_all(entry.path(), ec);
+            m_removed++;
+        }
+    }
+}
+
+std::string_view RyvenEmitter::unqualifiedType(std::string_view type)
+{
+    constexpr std::string_view prefix = "ns3::";
+    if (type.substr(0, prefix.size()) == prefix)
+        type.remove_prefix(prefix.size());
+    return type;
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <atomic>
+#include <exception>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "model_table.h"
+
+class RyvenEmitterException : std::exception
+{
+public:
+    RyvenEmitterException(std::string path, std::string reason):
+        path {path},
+        reason {reason}
+    {}
+
+    std::string path;
+    std::string reason;
+};
+
+// metacode_template.py split once into literal text and substitution slots
+class MetacodeTemplate
+{
+public:
+    MetacodeTemplate(std::string_view text);
+
+    std::string render(std::string_view nodeName, std::string_view populateDictionary) const;
+
+private:
+    enum class Slot { None, NodeName, PopulateDictionary };
+
+    class Segment {
+    public:
+        Segment(std::string t, Slot s) : text {t}, slot {s} {}
+
+        std::string text;
+        Slot slot;
+    };
+
+    std::vector<Segment> m_segments;
+    std::size_t m_literalSize {0};
+};
+
+// Writes an Airflow (Ryven) nodes package: the .rpc package description and
+// one METACODE node per model with attributes. Nodes are written by a pool of
+// threads, and only the files whose content changed are touched so that
+// Airflow does not reload the others.
+class RyvenEmitter
+{
+public:
+    RyvenEmitter(const ModelTable &models, std::string packageName, std::string outputDirectory,
+                 std::string_view metacodeTemplate);
+
+    // Lines of "<value type> <python conversion>", '#' starts a comment and
+    // a "-" conversion passes the input unchanged
+    void loadTypeMap(const std::string &path);
+
+    void emit(unsigned jobs);
+
+    std::size_t nodes() const { return m_nodes; }
+    std::size_t writtenFiles() const { return m_written; }
+    std::size_t unchangedFiles() const { return m_unchanged; }
+    std::size_t removedNodes() const { return m_removed; }
+
+private:
+    std::string moduleName(std::string_view modelName) const;
+    std::string metacode(std::size_t model) const;
+    std::string packageDescription(const std::vector<std::size_t> &models) const;
+    std::string_view conversion(std::string_view type) const;
+    void writeIfChanged(const std::filesystem::path &path, const std::string &content);
+    void removeStaleNodes(const std::vector<std::string> &modules);
+
+    static std::string_view unqualifiedType(std::string_view type);
+
+    const ModelTable &m_models;
+    std::string m_packageName;
+    std::filesystem::path m_packageDirectory;
+    MetacodeTemplate m_template;
+    // unqualified value type to python conversion
+    std::unordered_map<std::string, std::string> m_typeMap;
+
+    std::size_t m_nodes {0};
+    std::atomic<std::size_t> m_written {0};
+    std::atomic<std::size_t> m_unchanged {0};
+    std::size_t m_removed {0};
+};
@@ -0,0 +1,209 @@
+#include "shared_pch.h"
+
+#include <algorithm>
+#include <fstream>
+
+#ifdef _WIN32
+#include <process.h>
+#define getpid _getpid
+#else
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+SharedPch::SharedPch(const std::string &directory, DiagnosticHandler diagnose) :
+    m_directory {fs::path(directory) / ("splash-pch-" + std::to_string(getpid()))},
+    m_diagnose {diagnose}
+{}
+
+SharedPch::~SharedPch()
+{
+    std::error_code ec;
+    fs::remove_all(m_directory, ec);
+}
+
+bool SharedPch::parseMode(const std::string &name, PchMode &mode)
+{
+    if (name == "none")     { mode = PchMode::None; return true; }
+    if (name == "preamble") { mode = PchMode::Preamble; return true; }
+    if (name == "umbrella") { mode = PchMode::Umbrella; return true; }
+    return false;
+}
+
+void SharedPch::addInput(const std::string &path, const std::vector<std::string> &arguments)
+{
+    std::string key;
+    for (auto& a : arguments) {
+        key += a;
+        key += '\0';
+    }
+
+    auto [it, inserted] = m_groupOfArguments.emplace(key, m_groups.size());
+    if (inserted)
+        m_groups.push_back(std::make_unique<Group>(arguments));
+
+    m_groups[it->second]->sources.push_back(path);
+    m_groupOfSource[path] = it->second;
+}
+
+void SharedPch::plan()
+{
+    for (auto& group : m_groups) {
+        // a PCH pays off only when it is loaded more than once
+        if (group->sources.size() < 2)
+            continue;
+
+        std::vector<std::string> order;
+        std::unordered_map<std::string, std::size_t> count;
+        for (auto& source : group->sources) {
+            for (auto& header : sharedIncludes(source)) {
+                if (count[header]++ == 0)
+                    order.push_back(header);
+            }
+        }
+
+        for (auto& header : order) {
+            if (count[header] * 2 >= group->sources.size())
+                group->headers.push_back(header);
+        }
+    }
+}
+
+std::vector<std::string> SharedPch::arguments(CXIndex index, const std::string &path)
+{
+    auto it = m_groupOfSource.find(path);
+    if (it == m_groupOfSource.end() || m_groups[it->second]->headers.empty())
+        return {};
+
+    Group &group = *m_groups[it->second];
+    std::call_once(group.built, [this, index, &it] { build(index, it->second); });
+    if (group.pchPath.empty())
+        return {};
+
+    return {"-include-pch", group.pchPath};
+}
+
+std::vector<std::string> SharedPch::dependencies(const std::string &path) const
+{
+    auto it = m_groupOfSource.find(path);
+    if (it == m_groupOfSource.end() || m_groups[it->second]->pchPath.empty())
+        return {};
+
+    return m_groups[it->second]->dependencies;
+}
+
+void SharedPch::build(CXIndex index, std::size_t g)
+{
+    Group &group = *m_groups[g];
+    const fs::path umbrellaPath = m_directory / ("umbrella-" + std::to_string(g) + ".h");
+    const fs::path pchPath = m_directory / ("umbrella-" + std::to_string(g) + ".pch");
+
+    std::error_code ec;
+    fs::create_directories(m_directory, ec);
+    std::ofstream umbrella(umbrellaPath);
+    for (auto& header : group.headers)
+        umbrella << "#include " << header << "\n";
+    umbrella.close();
+    if (!umbrella) {
+        m_diagnose("Warning: cannot write " + umbrellaPath.string() + ", parsing without shared PCH.");
+        return;
+    }
+
+    std::vector<const char *> args;
+    for (auto& a : group.arguments)
+        args.push_back(a.c_str());
+    args.push_back("-x");
+    args.push_back("c++-header");
+
+    // only declarations of the main file are explored, header bodies are not needed
+    CXTranslationUnit translationUnit = nullptr;
+    const unsigned options = CXTranslationUnit_Incomplete |
+                             CXTranslationUnit_ForSerialization |
+                             CXTranslationUnit_SkipFunctionBodies;
+    const auto err = clang_parseTranslationUnit2(index, umbrellaPath.string().c_str(), args.data(), args.size(),
+                                                 nullptr, 0, options, &translationUnit);
+
+    // a PCH with errors would silently hide declarations from every input
+    bool failed = err != CXError_Success;
+    for (unsigned i = 0; !failed && i < clang_getNumDiagnostics(translationUnit); i++) {
+        CXDiagnostic diagnostic = clang_getDiagnostic(translationUnit, i);
+        failed = clang_getDiagnosticSeverity(diagnostic) >= CXDiagnostic_Error;
+        clang_disposeDiagnostic(diagnostic);
+    }
+
+    if (!failed) {
+        // the umbrella header itself is private to this run, with an empty include stack
+        clang_getInclusions(translationUnit, [](CXFile includedFile, CXSourceLocation *, unsigned depth, CXClientData clientData) {
+            if (depth == 0)
+                return;
+            CXString fileName = clang_getFileName(includedFile);
+            static_cast<std::vector<std::string> *>(clientData)->push_back(clang_getCString(fileName));
+            clang_disposeString(fileName);
+        }, &group.dependencies);
+    }
+
+    if (!failed)
+        failed = clang_saveTranslationUnit(translationUnit, pchPath.string().c_str(),
+                                           clang_defaultSaveOptions(translationUnit)) != CXSaveError_None;
+    if (translationUnit)
+        clang_disposeTranslationUnit(translationUnit);
+
+    if (failed) {
+        m_diagnose("Warning: cannot precompile the " + std::to_string(group.headers.size()) + " common header(s) of " +
+                   std::to_string(group.sources.size()) + " input(s), parsing them without shared PCH.");
+        return;
+    }
+
+    group.pchPath = pchPath.string();
+}
+
+std::vector<std::string> SharedPch::sharedIncludes(const std::string &sourcePath)
+{
+    // include directives at the top of the file, before any declaration.
+    // Quoted headers found next to the source are private to it.
+    std::vector<std::string> includes;
+    std::ifstream ifs(sourcePath);
+    const fs::path sourceDirectory = fs::path(sourcePath).parent_path();
+
+    std::string line;
+    bool inComment = false;
+    while (std::getline(ifs, line)) {
+        line.erase(0, line.find_first_not_of(" \t\r"));
+
+        if (inComment) {
+            auto end = line.find("*/");
+            if (end == std::string::npos)
+                continue;
+            inComment = false;
+            line.erase(0, line.find_first_not_of(" \t\r", end + 2));
+        }
+        if (line.empty() || line.rfind("//", 0) == 0)
+            continue;
+        if (line.rfind("/*", 0) == 0) {
+            inComment = line.find("*/", 2) == std::string::npos;
+            continue;
+        }
+        if (line[0] != '#')
+            break;
+
+        line.erase(0, line.find_first_not_of(" \t", 1));
+        if (line.rfind("include", 0) != 0)
+            continue;
+
+        line.erase(0, line.find_first_not_of(" \t", 7));
+        const char close = line.empty() ? 0 : line[0] == '"' ? '"' : line[0] == '<' ? '>' : 0;
+        const auto end = close ? line.find(close, 1) : std::string::npos;
+        if (end == std::string::npos)
+            continue;
+
+        const std::string name = line.substr(1, end - 1);
+        std::error_code ec;
+        if (close == '"' && fs::exists(sourceDirectory / name, ec))
+            continue;
+
+        includes.push_back(line.substr(0, end + 1));
+    }
+
+    return includes;
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <clang-c/Index.h>
+
+#include "diagnostic.h"
+
+// How the headers of source inputs are precompiled before parsing them.
+enum class PchMode {
+    // no precompilation, every header is parsed with its unit
+    None,
+    // a preamble per unit, reused when the same unit is parsed again
+    Preamble,
+    // one umbrella PCH of the common headers per set of compile flags
+    Umbrella
+};
+
+// Umbrella precompiled headers shared by the source inputs compiled with the
+// same flags. The headers included by at least half of the inputs of a group
+// are precompiled once, on the first parse that needs them, and every input
+// of the group is then parsed with -include-pch.
+class SharedPch
+{
+public:
+    // PCH files are written in a private subdirectory of directory, removed
+    // with the SharedPch. diagnose may be called from several threads.
+    SharedPch(const std::string &directory, DiagnosticHandler diagnose);
+    ~SharedPch();
+
+    // Registers every source input, then plan() picks the common headers
+    void addInput(const std::string &path, const std::vector<std::string> &arguments);
+    void plan();
+
+    // Arguments to add to the parse of an input, built on first use. Empty if
+    // the input has no common header or its PCH could not be built.
+    std::vector<std::string> arguments(CXIndex index, const std::string &path);
+    // Headers precompiled for an input, once its PCH is built
+    std::vector<std::string> dependencies(const std::string &path) const;
+
+    std::size_t groups() const { return m_groups.size(); }
+
+    // none, preamble or umbrella
+    static bool parseMode(const std::string &name, PchMode &mode);
+
+private:
+    class Group {
+    public:
+        Group(std::vector<std::string> args) : arguments {args} {}
+
+        std::vector<std::string> arguments;
+        std::vector<std::string> sources;
+        // include directives of the umbrella header, as written in the sources
+        std::vector<std::string> headers;
+        std::once_flag built;
+        std::string pchPath;
+        // every file read to build the PCH
+        std::vector<std::string> dependencies;
+    };
+
+    void build(CXIndex index, std::size_t group);
+
+    static std::vector<std::string> sharedIncludes(const std::string &sourcePath);
+
+    std::filesystem::path m_directory;
+    DiagnosticHandler m_diagnose;
+    std::vector<std::unique_ptr<Group>> m_groups;
+    std::unordered_map<std::string, std::size_t> m_groupOfArguments;
+    std::unordered_map<std::string, std::size_t> m_groupOfSource;
+};
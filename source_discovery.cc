@@ -0,0 +1,198 @@
+#include "source_discovery.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <thread>
+#include <unordered_set>
+
+namespace fs = std::filesystem;
+
+SourceDiscovery::SourceDiscovery(std::vector<std::string> includes, std::vector<std::string> excludes, unsigned jobs) :
+    m_includes {includes},
+    m_excludes {excludes},
+    m_jobs {std::max(jobs, 1u)}
+{}
+
+std::vector<std::string> SourceDiscovery::find(const std::string &root)
+{
+    std::error_code ec;
+    const fs::path rootPath = fs::canonical(root, ec);
+    if (ec || !fs::is_directory(rootPath, ec))
+        throw SourceDiscoveryException(root, "not a directory");
+
+    std::mutex mutex;
+    std::condition_variable wakeUp;
+    std::deque<fs::path> pending {rootPath};
+    // directories reached through a symbolic link may be met twice
+    std::unordered_set<std::string> visited {rootPath.string()};
+    std::vector<std::string> found;
+    unsigned busy = 0;
+
+    auto walk = [&] {
+        std::vector<fs::path> directories;
+        std::vector<std::string> files;
+
+        for (;;) {
+            fs::path directory;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wakeUp.wait(lock, [&] { return !pending.empty() || busy == 0; });
+                if (pending.empty())
+                    return;
+                directory = std::move(pending.front());
+                pending.pop_front();
+                busy++;
+            }
+
+            directories.clear();
+            files.clear();
+            std::error_code ec;
+            for (fs::directory_iterator it(directory, ec), end; !ec && it != end; it.increment(ec)) {
+                const fs::path &path = it->path();
+                const std::string name = path.filename().string();
+                const std::string relativePath = path.lexically_relative(rootPath).generic_string();
+
+                // follows symbolic links, like find -L
+                std::error_code statError;
+                const auto status = fs::status(path, statError);
+                if (statError)
+                    continue;
+
+                if (fs::is_directory(status)) {
+                    if (!isExcluded(name, relativePath))
+                        directories.push_back(path);
+                } else if (fs::is_regular_file(status)) {
+                    if (!isIncluded(name, relativePath) || isExcluded(name, relativePath))
+                        continue;
+
+                    m_scanned++;
+                    if (!m_requiredText.empty() && !fileContains(path.string())) {
+                        m_filtered++;
+                        continue;
+                    }
+                    files.push_back(path.string());
+                }
+            }
+
+            std::lock_guard<std::mutex> lock(mutex);
+            for (auto& d : directories) {
+                const auto canonical = fs::canonical(d, ec);
+                if (!ec && visited.insert(canonical.string()).second)
+                    pending.push_back(d);
+            }
+            found.insert(found.end(), files.begin(), files.end());
+            busy--;
+            wakeUp.notify_all();
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (unsigned i = 1; i < m_jobs; i++)
+        workers.emplace_back(walk);
+    walk();
+    for (auto& w : workers)
+        w.join();
+
+    // the walk order depends on scheduling, the inputs order must not
+    std::sort(found.begin(), found.end());
+    return found;
+}
+
+bool SourceDiscovery::isIncluded(std::string_view name, std::string_view relativePath) const
+{
+    for (auto& pattern : m_includes) {
+        if (matches(pattern, pattern.find('/') == std::string::npos ? name : relativePath))
+            return true;
+    }
+
+    return false;
+}
+
+bool SourceDiscovery::isExcluded(std::string_view name, std::string_view relativePath) const
+{
+    for (auto& pattern : m_excludes) {
+        if (matches(pattern, pattern.find('/') == std::string::npos ? name : relativePath))
+            return true;
+    }
+
+    return false;
+}
+
+bool SourceDiscovery::matches(std::string_view pattern, std::string_view path)
+{
+    for (std::size_t p = 0, s = 0; ; p++, s++) {
+        if (p == pattern.size())
+            return s == path.size();
+
+        if (pattern[p] == '*') {
+            const bool crossesDirectories = p + 1 < pattern.size() && pattern[p + 1] == '*';
+            const auto rest = pattern.substr(p + (crossesDirectories ? 2 : 1));
+            // "**/" also matches no directory at all
+            if (crossesDirectories && !rest.empty() && rest[0] == '/' && matches(rest.substr(1), path.substr(s)))
+                return true;
+
+            // globs are short, trying every split is cheap enough
+            for (std::size_t k = s; k <= path.size(); k++) {
+                if (matches(rest, path.substr(k)))
+                    return true;
+                if (k < path.size() && path[k] == '/' && !crossesDirectories)
+                    return false;
+            }
+            return false;
+        }
+
+        if (s == path.size())
+            return false;
+        if (pattern[p] == '?' ? path[s] == '/' : pattern[p] != path[s])
+            return false;
+    }
+}
+
+bool SourceDiscovery::contains(std::string_view haystack, std::string_view needle)
+{
+    if (needle.empty())
+        return true;
+
+    // memchr jumps to the candidates of the first character with SIMD loads
+    const char *data = haystack.data();
+    const char *end = data + haystack.size();
+    while (static_cast<std::size_t>(end - data) >= needle.size()) {
+        data = static_cast<const char *>(std::memchr(data, needle[0], end - data - needle.size() + 1));
+        if (data == nullptr)
+            return false;
+        if (std::memcmp(data + 1, needle.data() + 1, needle.size() - 1) == 0)
+            return true;
+        data++;
+    }
+
+    return false;
+}
+
+bool SourceDiscovery::fileContains(const std::string &path) const
+{
+    std::ifstream ifs(path, std::ios::binary);
+    if (!ifs)
+        return false;
+
+    // scan by blocks, keeping the tail of the previous one for a match
+    // spanning two blocks
+    const std::size_t overlap = m_requiredText.size() - 1;
+    std::vector<char> buffer(64 * 1024 + overlap);
+    std::size_t kept = 0;
+    for (;;) {
+        ifs.read(buffer.data() + kept, buffer.size() - kept);
+        const std::size_t size = kept + ifs.gcount();
+        if (contains(std::string_view(buffer.data(), size), m_requiredText))
+            return true;
+        if (!ifs)
+            return false;
+
+        kept = std::min(overlap, size);
+        std::memmove(buffer.data(), buffer.data() + size - kept, kept);
+    }
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <atomic>
+#include <exception>
+#include <string>
+#include <string_view>
+#include <vector>
+
+class SourceDiscoveryException : std::exception
+{
+public:
+    SourceDiscoveryException(std::string path, std::string reason):
+        path {path},
+        reason {reason}
+    {}
+
+    std::string path;
+    std::string reason;
+};
+
+// Finds the source files of a directory tree, like find -L with -name
+// patterns, walking the directories with a pool of threads. Patterns
+// without a '/' match the file or directory name, the others match the
+// path relative to the root, where "**" also matches across directories.
+class SourceDiscovery
+{
+public:
+    SourceDiscovery(std::vector<std::string> includes, std::vector<std::string> excludes, unsigned jobs);
+
+    // Keeps only the files containing text, which is read with a memchr scan
+    void setRequiredText(std::string text) { m_requiredText = text; }
+
+    // Sorted paths of the files of root matching an include pattern and no
+    // exclude pattern. Excluded directories are not walked.
+    std::vector<std::string> find(const std::string &root);
+
+    std::size_t scannedFiles() const { return m_scanned; }
+    std::size_t filteredFiles() const { return m_filtered; }
+
+    static bool matches(std::string_view pattern, std::string_view path);
+    static bool contains(std::string_view haystack, std::string_view needle);
+
+private:
+    bool isIncluded(std::string_view name, std::string_view relativePath) const;
+    bool isExcluded(std::string_view name, std::string_view relativePath) const;
+    bool fileContains(const std::string &path) const;
+
+    std::vector<std::string> m_includes;
+    std::vector<std::string> m_excludes;
+    unsigned m_jobs;
+    std::string m_requiredText;
+    std::atomic<std::size_t> m_scanned {0};
+    std::atomic<std::size_t> m_filtered {0};
+};
@@ -1,358 +1,397 @@
 #include "splash.h"
 
 #include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <chrono>
+#include <csignal>
+#include <filesystem>
 #include <fstream>
-#include <iostream>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
 
 #include <boost/json/src.hpp>
-#include <cxxopts.hpp>
 
-#define VERSION "v0.1.0"
-#define DEBUG() (std::cout << __FUNCTION__ << std::endl)
-
-Splash* Splash::m_instance;
-
-Splash::Splash(std::string inputPath, std::string outputPath, bool debug) :
-    m_astFilePath {inputPath},
-    m_outputFilePath {outputPath},
-    // create index w/ excludeDeclsFromPCH = 1, displayDiagnostics=1.
-    m_index {clang_createIndex(1, 1)},
+#include "binary_ir.h"
+#include "extraction_cache.h"
+#include "file_watcher.h"
+#include "metacode_template.h"
+#include "model_index.h"
+#include "model_json.h"
+#include "model_scanner.h"
+#include "model_writer.h"
+#include "parent_resolver.h"
+#include "ryven_emitter.h"
+#include "trace.h"
+#include "worker_pool.h"
+
+// Work of the static helpers on the calling thread, collected by extractUnit
+static thread_local std::size_t t_predicateCalls = 0;
+static thread_local std::size_t t_sourceBytes = 0;
+
+Splash::Splash(std::vector<TranslationUnitInput> inputs, SplashOptions options) :
+    m_inputs {inputs},
+    m_outputFilePath {options.outputPath},
+    m_appendOutput {options.appendOutput},
+    // create index w/ excludeDeclsFromPCH = 1, displayDiagnostics for the CLI.
+    // The index is shared by every translation unit loaded by the first worker.
+    m_index {clang_createIndex(1, options.printClangDiagnostics)},
     m_models {},
-    m_debug {debug}
+    m_jobs {options.jobs},
+    m_cache {},
+    m_cachedUnits {0},
+    m_pruneTraversal {options.pruneTraversal},
+    m_resolveParents {options.resolveParents},
+    m_visitedCursors {0},
+    m_prunedSubtrees {0},
+    m_registry {},
+    m_pchMode {options.pchMode},
+    m_sharedPch {},
+    m_watch {options.watch},
+    m_prescan {options.prescan},
+    m_isolate {options.isolate},
+    m_unitTimeout {options.unitTimeout},
+    m_ryvenOutput {options.ryvenOutput},
+    m_workerIndexes {},
+    m_unitModels {},
+    m_translationUnits {},
+    m_unitWorkers {},
+    m_unitDependencies {},
+    m_statsPath {options.statsPath},
+    m_stats {},
+    m_diagnosticHandler {options.diagnosticHandler},
+    m_printClangDiagnostics {options.printClangDiagnostics},
+    m_nextUnit {0},
+    m_failed {false}
 {
-    if (m_debug) DEBUG();
-    m_translationUnit = clang_createTranslationUnit(m_index, m_astFilePath.c_str());
-    if (m_translationUnit == NULL)
-        throw TranslationUnitException();
+    if (!options.cacheDirectory.empty())
+        m_cache = std::make_unique<ExtractionCache>(options.cacheDirectory, VERSION, options.rebuildCache);
+
+    if (m_pchMode == PchMode::Umbrella) {
+        // next to the cache when there is one, the PCH files are large
+        m_sharedPch = std::make_unique<SharedPch>(!options.cacheDirectory.empty()
+            ? options.cacheDirectory
+            : std::filesystem::temp_directory_path().string(),
+            [this](const std::string &message) { diagnose(message); });
+        for (auto& input : m_inputs) {
+            if (input.kind == TranslationUnitInput::Kind::Source)
+                m_sharedPch->addInput(input.path, input.arguments);
+        }
+        m_sharedPch->plan();
+    }
 }
 
 Splash::~Splash()
 {
-    // Guard against multiple calls of this Singleton
-    static auto disposed = false;
-    if (disposed)
-        return;
-
-    disposed = true;
-
-    clang_disposeTranslationUnit(m_translationUnit);
+    // units first, they belong to the indexes
+    for (auto translationUnit : m_translationUnits) {
+        if (translationUnit)
+            clang_disposeTranslationUnit(translationUnit);
+    }
+    for (std::size_t i = 1; i < m_workerIndexes.size(); i++)
+        clang_disposeIndex(m_workerIndexes[i]);
     clang_disposeIndex(m_index);
 }
 
-void Splash::printExtractedInformation()
+void Splash::diagnose(const std::string &message) const
 {
-    if (isDebugEnabled()) DEBUG();
-
-    std::cout << "Found " << m_models.size() << " model(s)." << std::endl;
-
-    for (auto& m : m_models) {
-        std::cout << "Model: " << m.name << std::endl;
-
-        for (auto& a : m.attributes) {
-            std::cout << "  Attribute: " << std::endl
-                      << "    Name: " << a.name << std::endl
-                      << "    Description: " << a.description << std::endl
-                      << "    Type: " << a.type << std::endl
-                      << std::endl;
-        }
-    }
+    std::lock_guard<std::mutex> lock(m_diagnosticMutex);
+    if (m_diagnosticHandler)
+        m_diagnosticHandler(message);
 }
 
 void Splash::exportExtractedInformation()
 {
-    if (isDebugEnabled()) {
-        DEBUG();
-        std::cout << "Exporting " << m_models.size() << " model(s)." << std::endl;
-    }
-
-    using namespace boost::json;
-    array arr;
+    SPLASH_TRACE(TraceLevel::Info, "exporting " << m_models.size() << " model(s) to " << m_outputFilePath);
 
     if (m_models.empty()) {
-        std::cout << "Warning: no TypeId found in " << m_astFilePath << std::endl;
+        diagnose("Warning: no TypeId found in any of the " + std::to_string(m_inputs.size()) + " input(s).");
         return;
     }
 
-    for (auto& m : m_models) {
-        object obj;
-        array attributes;
-
-        if (!m.parent.empty())
-            obj["parent"] = m.parent;
-
-        obj["name"] = m.name;
-        for (auto& a : m.attributes) {
-            attributes.push_back({
-                {"name", a.name},
-                {"description", a.description},
-                {"type", a.type}
-            });
-        }
-        obj["attributes"] = attributes;
-
-        arr.push_back(obj);
+    Stopwatch exportTime(Stopwatch::Clock::Process);
+    if (BinaryIr::isBinaryIrPath(m_outputFilePath)) {
+        BinaryIr::write(m_outputFilePath, m_models);
+        ModelIndex::build(m_outputFilePath, ModelIndex::indexPath(m_outputFilePath));
+    } else {
+        // stream models one by one instead of building the whole JSON document
+        ModelWriter writer(m_outputFilePath, m_appendOutput);
+        for (std::size_t m = 0; m < m_models.size(); m++)
+            writer.write(m_models, m);
+        writer.close();
     }
+    if (m_ryvenOutput.enabled())
+        emitRyvenNodes();
+    m_stats.recordPhase("export", exportTime.elapsed());
+}
 
-
-    std::ofstream ofs(m_outputFilePath);
-    ofs << arr;
-    ofs.close();
+void Splash::emitRyvenNodes()
+{
+    // unchanged nodes are not rewritten, so only the edited models reload in Airflow
+    RyvenEmitter emitter(m_models, m_ryvenOutput.package, m_ryvenOutput.directory, METACODE_TEMPLATE);
+    if (!m_ryvenOutput.typeMap.empty())
+        emitter.loadTypeMap(m_ryvenOutput.typeMap);
+    emitter.emit(std::max(m_jobs, 1u));
+
+    diagnose("Emitted " + std::to_string(emitter.nodes()) + " node(s) into " + m_ryvenOutput.directory + ": " +
+             std::to_string(emitter.writtenFiles()) + " file(s) written, " + std::to_string(emitter.unchangedFiles()) +
+             " unchanged, " + std::to_string(emitter.removedNodes()) + " stale node(s) removed.");
 }
 
-void Splash::extractModel(const CXCursor &cursor)
+void Splash::writeStats()
 {
-    if (isDebugEnabled()) DEBUG();
+    if (m_statsPath.empty())
+        return;
 
+    m_stats.write(m_statsPath);
+    diagnose("Wrote run statistics to " + m_statsPath + ".");
+}
+
+void Splash::extractModel(const CXCursor &cursor, std::vector<Model> &models)
+{
     auto modelName = getParentObjectName(cursor);
-    m_models.push_back({modelName});
+    models.push_back({modelName});
 }
 
-void Splash::exctractArgument(const CXCursor &cursor, unsigned int level)
+void Splash::exctractArgument(const CXCursor &cursor, VisitorContext *context)
 {
-    if (isDebugEnabled()) DEBUG();
-    CXCursor arg;
-    CXCursorKind argCurKind;
-    const unsigned int expectedNumOfArguments = 3;
+    // AddAttribute(name, help, [flags,] initialValue, accessor, checker, ...)
+    const int numArguments = clang_Cursor_getNumArguments(cursor);
+    const bool hasFlags = numArguments > 5 && isIntegerExpression(clang_Cursor_getArgument(cursor, 2));
+    const int valueIndex = hasFlags ? 3 : 2;
+    auto &attributes = context->models.back().attributes;
+    const auto numAttributes = attributes.size();
+
+    for (int i : {0, 1, valueIndex}) {
+        CXCursor arg = clang_Cursor_getArgument(cursor, i);
+
+        VisitorContext argContext = *context;
+        argContext.level = context->level + 1;
+        clang_visitChildren(arg, argumentExtractorCallback, &argContext);
+    }
 
-    for (int i = 0; i < expectedNumOfArguments; i++) {
-        arg = clang_Cursor_getArgument(cursor, i);
-        argCurKind = clang_getCursorKind(cursor);
-        //inspectCursor(arg);
+    // the name was not a literal, there is no attribute to complete
+    if (attributes.size() == numAttributes)
+        return;
+
+    context->counters.attributes++;
+    auto &attribute = attributes.back();
+    attribute.initialValue = getConstructorArguments(clang_Cursor_getArgument(cursor, valueIndex));
+    if (hasFlags)
+        attribute.flags = getExpressionText(clang_Cursor_getArgument(cursor, 2));
 
-        int cd = level + 1;
-        clang_visitChildren(arg, argumentExtractorCallback, &cd);
+    if (valueIndex + 1 < numArguments) {
+        CXCursor accessor = findFunctionCall(clang_Cursor_getArgument(cursor, valueIndex + 1));
+        if (!clang_Cursor_isNull(accessor))
+            attribute.accessor = getCallArguments(accessor);
+    }
+
+    if (valueIndex + 2 < numArguments) {
+        CXCursor checker = findFunctionCall(clang_Cursor_getArgument(cursor, valueIndex + 2));
+        if (!clang_Cursor_isNull(checker)) {
+            attribute.checker = getExpressionText(getFirstChild(checker));
+            attribute.checkerArguments = getCallArguments(checker);
+        }
     }
 }
 
-Splash* Splash::getInstance(std::string inputPath = "", std::string outputPath = "", bool debug = false)
+bool Splash::isIntegerExpression(const CXCursor &cursor)
 {
-    if (m_instance == nullptr)
-        m_instance = new Splash(inputPath, outputPath, debug);
-
-    return m_instance;
+    CXTypeKind kind = clang_getCanonicalType(clang_getCursorType(cursor)).kind;
+    return (kind >= CXType_Bool && kind <= CXType_Int128) || kind == CXType_Enum;
 }
 
-bool Splash::isDebugEnabled()
+bool Splash::isFunctionCall(const CXCursor &cursor)
 {
-    return Splash::getInstance()->m_debug;
+    return clang_getCursorKind(cursor) == CXCursor_CallExpr &&
+           clang_getCursorKind(clang_getCursorReferenced(cursor)) == CXCursor_FunctionDecl;
 }
 
-bool Splash::isNamespace(const CXCursor &cursor, std::string namespaceName)
+CXCursor Splash::findFunctionCall(const CXCursor &cursor)
 {
-    if (isDebugEnabled()) DEBUG();
-
-    CXCursorKind curKind = clang_getCursorKind(cursor);
-    CXString spell = clang_getCursorSpelling(cursor);
-    std::string spellText = clang_getCString(spell);
-    const bool flag = curKind == CXCursorKind::CXCursor_Namespace &&
-                      spellText.compare(namespaceName) == 0;
-    clang_disposeString(spell);
+    // Make*Accessor and Make*Checker calls hide below conversions to Ptr<>,
+    // skip constructor calls until a free function is called
+    if (isFunctionCall(cursor))
+        return cursor;
+
+    CXCursor call = clang_getNullCursor();
+    clang_visitChildren(cursor, [](CXCursor c, CXCursor, CXClientData clientData) {
+        if (isFunctionCall(c)) {
+            *static_cast<CXCursor *>(clientData) = c;
+            return CXChildVisit_Break;
+        }
+        return CXChildVisit_Recurse;
+    }, &call);
 
-    return flag;
+    return call;
 }
 
-bool Splash::isMethod(const CXCursor &cursor, std::string methodName)
+std::vector<std::string> Splash::getCallArguments(const CXCursor &call)
 {
-    if (isDebugEnabled()) DEBUG();
-    CXCursorKind curKind = clang_getCursorKind(cursor);
-    CXString spell = clang_getCursorSpelling(cursor);
-    std::string spellText = clang_getCString(spell);
-    const bool flag = curKind == CXCursorKind::CXCursor_CXXMethod &&
-                      spellText.compare(methodName) == 0;
+    std::vector<std::string> arguments;
+    const int numArguments = clang_Cursor_getNumArguments(call);
 
-    clang_disposeString(spell);
+    for (int i = 0; i < numArguments; i++) {
+        CXCursor arg = clang_Cursor_getArgument(call, i);
 
-    return flag;
-}
-
-bool Splash::isTypeReference(const CXCursor &cursor)
-{
-    if (isDebugEnabled()) DEBUG();
-    CXCursorKind curKind = clang_getCursorKind(cursor);
-    const bool flag = curKind == CXCursorKind::CXCursor_TypeRef;
+        // default arguments have no source text
+        if (clang_Range_isNull(clang_getCursorExtent(arg)))
+            break;
+        arguments.push_back(getExpressionValue(arg));
+    }
 
-    return flag;
+    return arguments;
 }
 
-bool Splash::hasParent(const CXCursor &parent, std::string targetParent)
+std::string Splash::getExpressionValue(const CXCursor &cursor)
 {
-    if (isDebugEnabled()) DEBUG();
-    CXString parentName = clang_getCursorSpelling(parent);
-    const bool flag = targetParent.compare(clang_getCString(parentName)) == 0;
+    std::string text = getExpressionText(cursor);
+    std::string value;
 
-    return flag;
+    return unescapeLiteral(text, value) ? value : text;
 }
 
-bool Splash::isDecl(const CXCursor &cursor, std::string typeDecl, std::string parentName)
+std::string Splash::getConstructorArguments(const CXCursor &cursor)
 {
-    if (isDebugEnabled()) DEBUG();
-    CXCursorKind curKind = clang_getCursorKind(cursor);
-    CXType type = clang_getCursorType(cursor);
-    CXString typeName = clang_getTypeSpelling(type);
-    std::string typeNameStr = clang_getCString(typeName);
-    CXCursor semanticParent = clang_getCursorSemanticParent(cursor);
-    CXString semanticParentName = clang_getCursorSpelling(semanticParent);
-    std::string semanticParentNameStr = clang_getCString(semanticParentName);
+    // DoubleValue(12.5) -> 12.5, anything else is kept as written
+    std::string text = getExpressionText(cursor);
+    auto open = text.find('(');
+    if (open == std::string::npos || text.back() != ')')
+        return text;
+
+    // the parenthesis must close at the end, as in Foo(a) but not in Foo(a) + Bar(b)
+    int depth = 0;
+    for (std::size_t i = open; i + 1 < text.size(); i++) {
+        depth += text[i] == '(' ? 1 : text[i] == ')' ? -1 : 0;
+        if (depth == 0)
+            return text;
+    }
 
-    const bool flag = clang_isDeclaration(curKind) &&
-                      typeNameStr.compare(typeDecl) == 0 &&
-                      semanticParentNameStr.compare(parentName) == 0;
+    auto first = text.find_first_not_of(" \t\n", open + 1);
+    auto last = text.find_last_not_of(" \t\n", text.size() - 2);
+    if (first == std::string::npos || first > last)
+        return "";
 
-    clang_disposeString(typeName);
-    clang_disposeString(semanticParentName);
-    return flag;
+    std::string arguments = text.substr(first, last - first + 1);
+    std::string value;
+    return unescapeLiteral(arguments, value) ? value : arguments;
 }
 
-bool Splash::isCallExpr(const CXCursor &cursor, std::string exprReturnType, std::string name)
+bool Splash::equals(CXString str, std::string_view target)
 {
-    if (isDebugEnabled()) DEBUG();
-    CXCursorKind curKind = clang_getCursorKind(cursor);
-    CXString curKindName = clang_getCursorKindSpelling(curKind);
-    std::string curKindNameStr = clang_getCString(curKindName);
-    CXType type = clang_getCursorType(cursor);
-    CXString typeName = clang_getTypeSpelling(type);
-    std::string typeNameStr = clang_getCString(typeName);
-    CXString spell = clang_getCursorSpelling(cursor);
-    std::string spellStr = clang_getCString(spell);
-
+    // compare in place and release the string, whatever the outcome
+    const char *cstr = clang_getCString(str);
+    const bool flag = cstr != nullptr && target == cstr;
+    clang_disposeString(str);
 
-    const bool flag = clang_isExpression(curKind) &&
-                      curKindNameStr.compare("CallExpr") == 0 &&
-                      typeNameStr.compare(exprReturnType) == 0 &&
-                      spellStr.compare(name) == 0;
-
-    clang_disposeString(curKindName);
-    clang_disposeString(typeName);
-    clang_disposeString(spell);
     return flag;
 }
 
-bool Splash::isFromMainFile(const CXCursor &cursor)
+bool Splash::isNamespace(const CXCursor &cursor, std::string_view namespaceName)
 {
-    if (isDebugEnabled()) DEBUG();
-    CXSourceLocation loc = clang_getCursorLocation(cursor);
-    return clang_Location_isFromMainFile(loc);
+    t_predicateCalls++;
+    return clang_getCursorKind(cursor) == CXCursorKind::CXCursor_Namespace &&
+           equals(clang_getCursorSpelling(cursor), namespaceName);
 }
 
-void Splash::showSpell(const CXCursor &cursor)
+bool Splash::isMethod(const CXCursor &cursor, std::string_view methodName)
 {
-    if (isDebugEnabled()) DEBUG();
-    CXString spell = clang_getCursorSpelling(cursor);
-    std::cout << "  Text: " << clang_getCString(spell) << std::endl;
-    clang_disposeString(spell);
+    t_predicateCalls++;
+    return clang_getCursorKind(cursor) == CXCursorKind::CXCursor_CXXMethod &&
+           equals(clang_getCursorSpelling(cursor), methodName);
 }
 
-void Splash::showType(const CXCursor &cursor)
+bool Splash::isTypeReference(const CXCursor &cursor)
 {
-    if (isDebugEnabled()) DEBUG();
-    CXType type = clang_getCursorType(cursor);
-    CXString typeName = clang_getTypeSpelling(type);
-    CXTypeKind typeKind = type.kind;
-    CXString typeKindName = clang_getTypeKindSpelling(typeKind);
-    std::cout << "  Type: " << clang_getCString(typeName) << std::endl;
-    std::cout << "  TypeKind: " << clang_getCString(typeKindName) << std::endl;
-    clang_disposeString(typeName);
-    clang_disposeString(typeKindName);
+    t_predicateCalls++;
+    CXCursorKind curKind = clang_getCursorKind(cursor);
+    const bool flag = curKind == CXCursorKind::CXCursor_TypeRef;
+
+    return flag;
 }
 
-void Splash::showParent(const CXCursor &cursor, const CXCursor &parent)
+bool Splash::hasParent(const CXCursor &parent, std::string_view targetParent)
 {
-    if (isDebugEnabled()) DEBUG();
-    CXCursor semaParent = clang_getCursorSemanticParent(cursor);
-    CXCursor lexParent  = clang_getCursorLexicalParent(cursor);
-    CXString parentName = clang_getCursorSpelling(parent);
-    CXString semaParentName = clang_getCursorSpelling(semaParent);
-    CXString lexParentName = clang_getCursorSpelling(lexParent);
-    std::cout << "  Parent: parent:" << clang_getCString(parentName)
-              << "  semantic:" << clang_getCString(semaParentName)
-              << "  lexical:" << clang_getCString(lexParentName)
-              << std::endl;
-
-    clang_disposeString(parentName);
-    clang_disposeString(semaParentName);
-    clang_disposeString(lexParentName);
+    t_predicateCalls++;
+    return equals(clang_getCursorSpelling(parent), targetParent);
 }
 
-void Splash::showLocation(const CXCursor &cursor)
+bool Splash::isDecl(const CXCursor &cursor, std::string_view typeDecl, std::string_view parentName)
 {
-    if (isDebugEnabled()) DEBUG();
-    CXSourceLocation loc = clang_getCursorLocation(cursor);
-    CXFile file;
-    unsigned line, column, offset;
-    clang_getSpellingLocation(loc, &file, &line, &column, &offset);
-    CXString fileName = clang_getFileName(file);
-    std::cout << "Location: " << clang_getCString(fileName) << ":"
-              << line << ":"
-              << column << ":"
-              << offset << std::endl;
-    clang_disposeString(fileName);
+    t_predicateCalls++;
+    // cheapest checks first, type and parent spellings are only built for declarations
+    return clang_isDeclaration(clang_getCursorKind(cursor)) &&
+           equals(clang_getTypeSpelling(clang_getCursorType(cursor)), typeDecl) &&
+           equals(clang_getCursorSpelling(clang_getCursorSemanticParent(cursor)), parentName);
 }
 
-void Splash::showUsr(const CXCursor &cursor)
+bool Splash::isCallExpr(const CXCursor &cursor, std::string_view exprReturnType, std::string_view name)
 {
-    if (isDebugEnabled()) DEBUG();
-    CXString usr = clang_getCursorUSR(cursor);
-    std::cout << "  USR: " << clang_getCString(usr) << std::endl;
-    clang_disposeString(usr);
+    t_predicateCalls++;
+    // the callee name is more selective than the return type, check it first
+    return clang_getCursorKind(cursor) == CXCursorKind::CXCursor_CallExpr &&
+           equals(clang_getCursorSpelling(cursor), name) &&
+           equals(clang_getTypeSpelling(clang_getCursorType(cursor)), exprReturnType);
 }
 
-void Splash::showCursorKind(const CXCursor &cursor)
+bool Splash::isFromMainFile(const CXCursor &cursor)
 {
-    if (isDebugEnabled()) DEBUG();
-    CXCursorKind curKind  = clang_getCursorKind(cursor);
-    CXString curKindName  = clang_getCursorKindSpelling(curKind);
-
-    const char *type;
-    if (clang_isAttribute(curKind))            type = "Attribute";
-    else if (clang_isDeclaration(curKind))     type = "Declaration";
-    else if (clang_isExpression(curKind))      type = "Expression";
-    else if (clang_isInvalid(curKind))         type = "Invalid";
-    else if (clang_isPreprocessing(curKind))   type = "Preprocessing";
-    else if (clang_isReference(curKind))       type = "Reference";
-    else if (clang_isStatement(curKind))       type = "Statement";
-    else if (clang_isTranslationUnit(curKind)) type = "TranslationUnit";
-    else if (clang_isUnexposed(curKind))       type = "Unexposed";
-    else                                       type = "Unknown";
-
-    std::cout << "  CursorKind: " << clang_getCString(curKindName);
-    std::cout << "  CursorKindType: " << type << std::endl;
-    clang_disposeString(curKindName);
+    t_predicateCalls++;
+    CXSourceLocation loc = clang_getCursorLocation(cursor);
+    return clang_Location_isFromMainFile(loc);
 }
 
-void Splash::showIncludedFile(const CXCursor &cursor)
+bool Splash::mayContainModels(const CXCursor &cursor, unsigned level)
 {
-    if (isDebugEnabled()) DEBUG();
-    CXFile included = clang_getIncludedFile(cursor);
-    if (included == 0)
-        return;
+    CXCursorKind curKind = clang_getCursorKind(cursor);
 
-    CXString includedFileName = clang_getFileName(included);
-    std::cout << " Included file: " << clang_getCString(includedFileName);
-    clang_disposeString(includedFileName);
+    switch (level) {
+        case 0:
+            // the ns3 namespaces of the unit, possibly inside an extern block
+            return curKind == CXCursor_LinkageSpec;
+        case 1:
+            // GetTypeId definitions of nested namespaces or of classes
+            return curKind == CXCursor_Namespace ||
+                   curKind == CXCursor_ClassDecl ||
+                   curKind == CXCursor_StructDecl ||
+                   curKind == CXCursor_ClassTemplate ||
+                   curKind == CXCursor_LinkageSpec;
+        case 2:
+            // statements of GetTypeId leading to the TypeId declaration
+            return clang_isStatement(curKind);
+        default:
+            // anything inside the TypeId declaration belongs to its call chain
+            return true;
+    }
 }
 
-void Splash::inspectCursor(const CXCursor &cursor)
+bool Splash::isTypeIdMethodCall(const CXCursor &cursor)
 {
-    if (isDebugEnabled()) DEBUG();
-    std::cout << "--- Cursor ---" << std::endl;
-    showSpell(cursor);
-    showCursorKind(cursor);
-    showType(cursor);
-    showLocation(cursor);
-    showUsr(cursor);
-    showIncludedFile(cursor);
+    if (clang_getCursorKind(cursor) != CXCursor_CallExpr)
+        return false;
+
+    CXCursor callee = getFirstChild(cursor);
+    return clang_getCursorKind(callee) == CXCursor_MemberRefExpr;
 }
 
-void Splash::inspectCursor(const CXCursor &cursor, const CXCursor &parent)
+CXCursor Splash::getFirstChild(const CXCursor &cursor)
 {
-    if (isDebugEnabled()) DEBUG();
-    inspectCursor(cursor);
-    showParent(cursor, parent);
+    CXCursor child = clang_getNullCursor();
+
+    clang_visitChildren(cursor, [](CXCursor c, CXCursor, CXClientData clientData) {
+        *static_cast<CXCursor *>(clientData) = c;
+        return CXChildVisit_Break;
+    }, &child);
+
+    return child;
 }
 
 std::string Splash::getParentObjectName(const CXCursor &cursor)
 {
-    if (isDebugEnabled()) DEBUG();
     CXCursor semanticParent = clang_getCursorSemanticParent(cursor);
     CXString semanticParentName = clang_getCursorSpelling(semanticParent);
     const std::string name {clang_getCString(semanticParentName)};
@@ -362,9 +401,33 @@ std::string Splash::getParentObjectName(const CXCursor &cursor)
     return name;
 }
 
+std::string Splash::getParentObjectUsr(const CXCursor &cursor)
+{
+    CXString usr = clang_getCursorUSR(clang_getCursorSemanticParent(cursor));
+    const std::string result {clang_getCString(usr)};
+
+    clang_disposeString(usr);
+
+    return result;
+}
+
+std::string Splash::getDefinitionFile(const CXCursor &cursor)
+{
+    CXFile file;
+    clang_getSpellingLocation(clang_getCursorLocation(cursor), &file, nullptr, nullptr, nullptr);
+    CXString fileName = clang_getFileName(file);
+    const char *name = clang_getCString(fileName);
+    std::string path = name != nullptr ? name : "";
+    clang_disposeString(fileName);
+
+    // units including the header with other flags spell it differently
+    std::error_code ec;
+    auto canonical = std::filesystem::weakly_canonical(path, ec);
+    return ec ? path : canonical.string();
+}
+
 std::string Splash::getTypeName(const CXCursor &cursor)
 {
-    if (isDebugEnabled()) DEBUG();
     CXType type = clang_getCursorType(cursor);
     CXString typeName = clang_getTypeSpelling(type);
     const std::string typeNameStr {clang_getCString(typeName)};
@@ -376,7 +439,11 @@ std::string Splash::getTypeName(const CXCursor &cursor)
 
 std::string Splash::getSourceCode(const CXCursor &cursor)
 {
-    if (isDebugEnabled()) DEBUG();
+    return stripLiteral(getExpressionText(cursor));
+}
+
+std::string Splash::getExpressionText(const CXCursor &cursor)
+{
     // Get source location to extract information
     CXSourceRange range = clang_getCursorExtent(cursor);
     CXSourceLocation startLoc = clang_getRangeStart(range);
@@ -387,8 +454,18 @@ std::string Splash::getSourceCode(const CXCursor &cursor)
 
     clang_getFileLocation(startLoc, &refFile, nullptr, nullptr, &startOffset);
     clang_getFileLocation(endLoc, nullptr, nullptr, nullptr, &endOffset);
+    // no file behind macro scratch space, and a range ending elsewhere has no text
+    if (refFile == nullptr || startOffset > endOffset)
+        return "";
+    t_sourceBytes += endOffset - startOffset;
+
+    // The translation unit already holds the file buffer, read it in place
+    std::size_t size = 0;
+    const char *contents = clang_getFileContents(clang_Cursor_getTranslationUnit(cursor), refFile, &size);
+    if (contents != nullptr && endOffset <= size) {
+        return std::string(contents + startOffset, endOffset - startOffset);
+    }
 
-    // TODO: Macro to get std::string from a Clang operation that returns CXString
     CXString fileName = clang_getFileName(refFile);
     std::string filePath = clang_getCString(fileName);
     clang_disposeString(fileName);
@@ -396,58 +473,189 @@ std::string Splash::getSourceCode(const CXCursor &cursor)
     return getSourceCodeText(filePath, startOffset, endOffset);
 }
 
+std::string Splash::getStringLiteral(const CXCursor &cursor)
+{
+    // The spelling of a literal is its value as clang sees it: adjacent literals
+    // joined and macros expanded, with quotes and escapes still in place.
+    // clang_Cursor_Evaluate gives nothing for a bare StringLiteral cursor.
+    CXString spelling = clang_getCursorSpelling(cursor);
+    std::string value;
+    bool decoded = unescapeLiteral(clang_getCString(spelling), value);
+    clang_disposeString(spelling);
+
+    return decoded ? value : getSourceCode(cursor);
+}
+
+bool Splash::unescapeLiteral(std::string_view spelling, std::string &value)
+{
+    // Skip encoding prefixes (L, u8, u, U); raw strings are left to the fallback
+    auto open = spelling.find('"');
+    if (open == std::string_view::npos || spelling.size() < open + 2 || spelling.back() != '"' ||
+        spelling.substr(0, open).find('R') != std::string_view::npos) {
+        return false;
+    }
+
+    std::string_view body = spelling.substr(open + 1, spelling.size() - open - 2);
+    value.clear();
+    value.reserve(body.size());
+
+    for (std::size_t i = 0; i < body.size(); i++) {
+        if (body[i] == '"') {
+            // more than one literal
+            return false;
+        } else if (body[i] != '\\') {
+            value += body[i];
+            continue;
+        }
+        if (++i == body.size()) {
+            return false;
+        }
+
+        char c = body[i];
+        switch (c) {
+            case 'a': value += '\a'; break;
+            case 'b': value += '\b'; break;
+            case 'f': value += '\f'; break;
+            case 'n': value += '\n'; break;
+            case 'r': value += '\r'; break;
+            case 't': value += '\t'; break;
+            case 'v': value += '\v'; break;
+            case 'x': {
+                unsigned code = 0;
+                while (i + 1 < body.size() && std::isxdigit(static_cast<unsigned char>(body[i + 1]))) {
+                    char d = body[++i];
+                    code = code * 16 + (std::isdigit(static_cast<unsigned char>(d)) ? d - '0' : std::tolower(d) - 'a' + 10);
+                }
+                value += static_cast<char>(code);
+                break;
+            }
+            default:
+                if (c >= '0' && c <= '7') {
+                    unsigned code = c - '0';
+                    for (int digits = 1; digits < 3 && i + 1 < body.size() && body[i + 1] >= '0' && body[i + 1] <= '7'; digits++) {
+                        code = code * 8 + (body[++i] - '0');
+                    }
+                    value += static_cast<char>(code);
+                } else {
+                    // \", \', \\ and \?
+                    value += c;
+                }
+        }
+    }
+
+    return true;
+}
+
 std::string Splash::getSourceCodeText(std::string filePath, unsigned int startOffset, unsigned int endOffset)
 {
-    if (isDebugEnabled()) DEBUG();
+    if (startOffset > endOffset)
+        return "";
+
     std::ifstream ifs(filePath);
-    unsigned int bufferSize = endOffset - startOffset + 1;
-    std::string contents(bufferSize, '\0');
+    std::string contents(endOffset - startOffset, '\0');
 
     ifs.seekg(startOffset);
-    ifs.read(&contents[0], bufferSize - 1);
-    ifs.close();
-
-    // cleanup string
-    contents.erase(std::remove(contents.begin(), contents.end(), '\"'), contents.end());
-    contents.erase(std::remove(contents.begin(), contents.end(), '\u0000'), contents.end());
+    ifs.read(&contents[0], contents.size());
+    // a file shorter than the range gives the bytes it has
+    contents.resize(ifs.gcount());
 
     return contents;
 }
 
-CXChildVisitResult Splash::explorerCallback(CXCursor cursor, CXCursor parent, CXClientData client_data)
+std::string Splash::stripLiteral(std::string_view text)
 {
-    if (isDebugEnabled()) DEBUG();
-    unsigned level = *(unsigned *)client_data;
-    unsigned next = level;
+    // Drop quotes and NUL bytes in a single pass
+    std::string stripped;
+    stripped.reserve(text.size());
 
-    // we are at the highest level of AST, check if we have an ns3 namespace
-    if (level == 0 && isFromMainFile(cursor) && isNamespace(cursor, "ns3")) {
-        //inspectCursor(cursor, parent);
+    for (char c : text) {
+        if (c != '\"' && c != '\0') {
+            stripped += c;
+        }
+    }
+
+    return stripped;
+}
+
+CXChildVisitResult Splash::explorerCallback(CXCursor cursor, CXCursor parent, CXClientData client_data)
+{
+    auto context = static_cast<VisitorContext *>(client_data);
+    unsigned level = context->level;
+    VisitorContext next = *context;
+    context->counters.visited++;
+
+    // we are at the highest level of AST, check if we have an ns3 namespace,
+    // of the main file or of a header that may define a GetTypeId inline
+    if (level == 0 && isNamespace(cursor, "ns3")) {
+        SPLASH_TRACE_CURSOR(TraceLevel::Debug, cursor, "enter-ns3");
         // visit children recursively
-        next = level + 1;
+        next.level = level + 1;
     } else if (level == 1 && isMethod(cursor, "GetTypeId")) {
-        //inspectCursor(cursor, parent)
-        Splash::getInstance()->extractModel(cursor);
+        const bool definition = clang_isCursorDefinition(cursor);
+        const bool fromMainFile = isFromMainFile(cursor);
+        // the declarations of the headers are the classes of other units
+        if (!definition && !fromMainFile)
+            return CXChildVisit_Continue;
+
+        SPLASH_TRACE_CURSOR(TraceLevel::Debug, cursor, "match-gettypeid");
+        context->counters.typeIdMatches++;
+
+        // a model already extracted by a lower unit is skipped before its
+        // attributes are visited. Only a definition owns its class: the
+        // in-class declaration of a GetTypeId defined further down the same
+        // file yields an empty model, which must not claim the class first.
+        // A header definition is claimed by the header, every unit including
+        // it defines the same model.
+        const std::string usr = definition ? getParentObjectUsr(cursor) : std::string();
+        const std::string file = fromMainFile ? std::string() : getDefinitionFile(cursor);
+        if (definition && context->registry &&
+            !context->registry->claim(usr, getParentObjectName(cursor), context->unit,
+                                      file.empty() ? *context->file : file) &&
+            context->skipClaimed) {
+            SPLASH_TRACE_CURSOR(TraceLevel::Debug, cursor, "skip-duplicate");
+            context->counters.duplicateModels++;
+            return CXChildVisit_Continue;
+        }
+        extractModel(cursor, context->models);
+        context->models.back().usr = usr;
+        // spelled like the SetParent<> types naming it
+        context->models.back().qualifiedName = getTypeName(clang_getCursorSemanticParent(cursor));
+        context->models.back().file = file;
 
         // visit children recursively
-        next = level + 1;
+        next.level = level + 1;
     } else if (level >= 2 && isDecl(cursor, "ns3::TypeId", "GetTypeId")) {
-        //inspectCursor(cursor, parent)
+        SPLASH_TRACE_CURSOR(TraceLevel::Debug, cursor, "match-typeid-decl");
         // visit children recursively
-        next = level + 1;
+        next.level = level + 1;
     } else if (level >= 3 && isTypeReference(cursor) && hasParent(parent, "SetParent")) {
-        //inspectCursor(cursor, parent);
+        SPLASH_TRACE_CURSOR(TraceLevel::Debug, cursor, "match-parent");
         const std::string parentName = getTypeName(cursor);
-        Splash::getInstance()->m_models.back().parent = parentName;
+        context->models.back().parent = parentName;
 
         // visit children recursively
-        next = level + 1;
+        next.level = level + 1;
     } else if (level >= 3 && isCallExpr(cursor, "ns3::TypeId", "AddAttribute")) {
-        //inspectCursor(cursor, parent)
-        exctractArgument(cursor, next);
+        SPLASH_TRACE_CURSOR(TraceLevel::Debug, cursor, "match-addattribute");
+        exctractArgument(cursor, &next);
 
         // visit children recursively
-        next = level + 1;
+        next.level = level + 1;
+    } else if (context->prune && !mayContainModels(cursor, level)) {
+        SPLASH_TRACE_CURSOR(TraceLevel::Cursor, cursor, "prune");
+        context->counters.pruned++;
+        return CXChildVisit_Continue;
+    } else {
+        SPLASH_TRACE_CURSOR(TraceLevel::Cursor, cursor, "recurse");
+    }
+
+    if (context->prune && level >= 3 && isTypeIdMethodCall(cursor)) {
+        // arguments of a TypeId call chain are either already extracted or
+        // irrelevant, only the callee leads to the rest of the chain
+        context->counters.pruned++;
+        CXCursor callee = getFirstChild(cursor);
+        explorerCallback(callee, cursor, &next);
+        return CXChildVisit_Continue;
     }
 
     clang_visitChildren(cursor, explorerCallback, &next);
@@ -456,16 +664,16 @@ CXChildVisitResult Splash::explorerCallback(CXCursor cursor, CXCursor parent, CX
 
 CXChildVisitResult Splash::argumentExtractorCallback(CXCursor cursor, CXCursor parent, CXClientData clientData)
 {
-    if (isDebugEnabled()) DEBUG();
     std::string str;
     CXType type;
     CXString typeName;
     CXCursorKind curKind = clang_getCursorKind(cursor);
-    auto attributeVec = &Splash::getInstance()->m_models.back().attributes;
+    auto context = static_cast<VisitorContext *>(clientData);
+    auto attributeVec = &context->models.back().attributes;
 
     switch(curKind) {
         case CXCursor_StringLiteral:
-            str = getSourceCode(cursor);
+            str = getStringLiteral(cursor);
 
             if (attributeVec->empty() || !attributeVec->back().type.empty()) {
                 attributeVec->push_back({});
@@ -476,6 +684,7 @@ CXChildVisitResult Splash::argumentExtractorCallback(CXCursor cursor, CXCursor p
             } else {
                 attributeVec->back().description = str;
             }
+            SPLASH_TRACE(TraceLevel::Debug, "attribute string " << str);
 
             return CXChildVisit_Break;
             break;
@@ -487,80 +696,777 @@ CXChildVisitResult Splash::argumentExtractorCallback(CXCursor cursor, CXCursor p
             clang_disposeString(typeName);
 
             attributeVec->back().type = str;
+            SPLASH_TRACE(TraceLevel::Debug, "attribute type " << str);
 
             return CXChildVisit_Break;
             break;
         default:
-            //inspectCursor(cursor);
             return CXChildVisit_Recurse;
     }
 }
 
 void Splash::run()
 {
-    if (isDebugEnabled()) DEBUG();
-    unsigned level = 0;
-    CXCursor cursor = clang_getTranslationUnitCursor(m_translationUnit);
+    m_unitModels.assign(m_inputs.size(), {});
+    if (m_watch) {
+        m_translationUnits.assign(m_inputs.size(), nullptr);
+        m_unitWorkers.assign(m_inputs.size(), 0);
+        m_unitDependencies.assign(m_inputs.size(), {});
+    }
 
-    clang_visitChildren(cursor, explorerCallback, &level);
+    std::vector<std::thread> workers;
+    const unsigned jobs = std::min<std::size_t>(std::max(m_jobs, 1u), m_inputs.size());
+    SPLASH_TRACE(TraceLevel::Info, "extracting " << m_inputs.size() << " unit(s) with " << jobs << " worker(s)");
+    m_stats.units.resize(m_inputs.size());
+    m_stats.jobs = jobs;
+    m_stats.isolated = m_isolate;
+    Stopwatch extraction(Stopwatch::Clock::Process);
+
+    // the calling thread is the first worker and reuses the session index,
+    // every additional worker owns a private one
+    m_workerIndexes.assign(1, m_index);
+    if (m_isolate) {
+        // worker processes, each with its copy of the session index
+        extractIsolated(jobs);
+    } else {
+        for (unsigned i = 1; i < jobs; i++)
+            m_workerIndexes.push_back(clang_createIndex(1, m_printClangDiagnostics));
+        for (unsigned i = 1; i < jobs; i++)
+            workers.emplace_back([this, i] { extractUnits(i); });
+        extractUnits(0);
+
+        for (auto& w : workers)
+            w.join();
+    }
+    // watch mode keeps them alive with their translation units
+    if (!m_watch) {
+        for (std::size_t i = 1; i < m_workerIndexes.size(); i++)
+            clang_disposeIndex(m_workerIndexes[i]);
+        m_workerIndexes.resize(1);
+    }
+    m_stats.recordPhase("extraction", extraction.elapsed());
+
+    if (m_failure)
+        std::rethrow_exception(m_failure);
+
+    // debug output, --stats records the same counters
+    SPLASH_TRACE(TraceLevel::Info, "visited " << m_visitedCursors << " cursor(s), pruned "
+                 << m_prunedSubtrees << " subtree(s)");
+
+    if (m_cache)
+        diagnose("Reused " + std::to_string(m_cachedUnits) + " of " + std::to_string(m_inputs.size()) +
+                 " unit(s) from cache.");
+
+    if (m_registry.duplicates() > 0)
+        diagnose("Skipped " + std::to_string(m_registry.duplicates()) + " model definition(s) extracted by another unit.");
+    reportConflicts();
+
+    std::size_t skippedUnits = 0;
+    for (std::size_t i = 0; i < m_unitModels.size(); i++) {
+        if (m_stats.units[i].skipped)
+            skippedUnits++;
+        else if (m_unitModels[i].empty() && m_stats.units[i].counters.duplicateModels == 0 &&
+                 !m_stats.units[i].failed)
+            diagnose("Warning: no TypeId found in " + m_inputs[i].path);
+    }
+    if (m_prescan)
+        diagnose("Skipped " + std::to_string(skippedUnits) + " of " + std::to_string(m_inputs.size()) +
+                 " unit(s) without GetTypeId definition.");
+
+    mergeUnits();
+}
+
+void Splash::reportConflicts()
+{
+    for (auto& conflict : m_registry.conflicts()) {
+        std::string message = "Warning: model " + conflict.name + " is defined in ";
+        for (std::size_t i = 0; i < conflict.files.size(); i++)
+            message += (i == 0 ? "" : i + 1 < conflict.files.size() ? ", " : " and ") + conflict.files[i];
+        diagnose(message + ", keeping the one of " + conflict.files.front() + ".");
+    }
+}
+
+void Splash::mergeUnits()
+{
+    // merge in input order so that the output does not depend on scheduling
+    Stopwatch merge(Stopwatch::Clock::Process);
+    m_models = ModelTable();
+    // units extract a model before a lower unit claims it, keep the first
+    // definition. A declaration, without USR, is only kept when its class is
+    // defined in none of the inputs.
+    std::unordered_set<std::string> definedNames;
+    for (auto& models : m_unitModels) {
+        for (auto& model : models) {
+            if (!model.usr.empty())
+                definedNames.insert(model.name);
+        }
+    }
+    std::unordered_set<std::string> kept;
+    for (auto& models : m_unitModels) {
+        for (auto& model : models) {
+            if (model.usr.empty() ? definedNames.count(model.name) == 0 : kept.insert(model.usr).second)
+                m_models.append(model);
+        }
+        // intern into the table and release the unit's own strings, unless
+        // they are merged again on the next update
+        if (!m_watch)
+            std::vector<Model>().swap(models);
+    }
+    m_stats.recordPhase("merge", merge.elapsed());
+
+    if (m_resolveParents) {
+        Stopwatch resolve(Stopwatch::Clock::Process);
+        resolveParents();
+        m_stats.recordPhase("resolveParents", resolve.elapsed());
+    }
+}
+
+void Splash::resolveParents()
+{
+    ParentResolver resolver(m_models);
+    resolver.resolve();
+
+    for (auto& unresolved : resolver.unresolvedParents()) {
+        std::string message = "Warning: parent " + unresolved.parent + " of ";
+        for (std::size_t i = 0; i < unresolved.children.size(); i++)
+            message += (i > 0 ? ", " : "") + unresolved.children[i];
+        diagnose(message + " not found, inheriting no attributes from it.");
+    }
+
+    for (auto& name : resolver.cyclicModels())
+        diagnose("Warning: " + name + " is its own ancestor, attributes not inherited.");
+}
+
+void Splash::extractUnits(unsigned worker)
+{
+    for (auto i = m_nextUnit++; i < m_inputs.size() && !m_failed; i = m_nextUnit++) {
+        try {
+            processUnit(worker, i);
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(m_failureMutex);
+            if (!m_failed.exchange(true))
+                m_failure = std::current_exception();
+        }
+    }
+}
+
+void Splash::processUnit(unsigned worker, std::size_t i)
+{
+    UnitStats &stats = m_stats.units[i];
+    stats.path = m_inputs[i].path;
+
+    // watch mode needs the translation unit of every input to reparse it
+    if (m_cache && !m_watch) {
+        Stopwatch lookup(m_stats.unitClock());
+        stats.cached = m_cache->lookup(m_inputs[i], m_unitModels[i]);
+        stats.cache = lookup.elapsed();
+    }
+    if (stats.cached) {
+        SPLASH_TRACE(TraceLevel::Info, "reused " << m_inputs[i].path << " from cache");
+        stats.models = m_unitModels[i].size();
+        for (auto& model : m_unitModels[i]) {
+            if (!model.usr.empty())
+                m_registry.claim(model.usr, model.name, i, model.file.empty() ? m_inputs[i].path : model.file);
+        }
+        m_cachedUnits++;
+        return;
+    }
+
+    SPLASH_TRACE(TraceLevel::Info, "extracting " << m_inputs[i].path);
+    m_unitModels[i] = extractUnit(worker, i, stats);
+    m_visitedCursors += stats.counters.visited;
+    m_prunedSubtrees += stats.counters.pruned;
+}
+
+// Compact encoding of the result of a unit sent back by a worker process
+static void putNumber(std::string &out, std::uint64_t value)
+{
+    out.append(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+static void putString(std::string &out, const std::string &str)
+{
+    putNumber(out, str.size());
+    out += str;
+}
+
+static void putPhase(std::string &out, const PhaseTime &time)
+{
+    out.append(reinterpret_cast<const char *>(&time.wall), sizeof(time.wall));
+    out.append(reinterpret_cast<const char *>(&time.cpu), sizeof(time.cpu));
+}
+
+static void putStrings(std::string &out, const std::vector<std::string> &strings)
+{
+    putNumber(out, strings.size());
+    for (auto& s : strings)
+        putString(out, s);
+}
+
+class PayloadReader {
+public:
+    PayloadReader(const std::string &p) : payload {p} {}
+
+    std::uint64_t number()
+    {
+        std::uint64_t value;
+        read(&value, sizeof(value));
+        return value;
+    }
+
+    std::string string()
+    {
+        const auto size = number();
+        if (size > payload.size() - offset)
+            throw std::runtime_error("truncated worker result");
+        offset += size;
+        return payload.substr(offset - size, size);
+    }
+
+    std::vector<std::string> strings()
+    {
+        std::vector<std::string> result(number());
+        for (auto& s : result)
+            s = string();
+        return result;
+    }
+
+    PhaseTime phase()
+    {
+        PhaseTime time;
+        read(&time.wall, sizeof(time.wall));
+        read(&time.cpu, sizeof(time.cpu));
+        return time;
+    }
+
+    void read(void *data, std::size_t size)
+    {
+        if (size > payload.size() - offset)
+            throw std::runtime_error("truncated worker result");
+        std::memcpy(data, payload.data() + offset, size);
+        offset += size;
+    }
+
+    const std::string &payload;
+    std::size_t offset {0};
+};
+
+static std::string encodeUnitResult(const std::vector<Model> &models, const UnitStats &stats)
+{
+    std::string out;
+    putNumber(out, stats.cached);
+    putNumber(out, stats.skipped);
+    putNumber(out, stats.expectedModels);
+    putPhase(out, stats.scan);
+    putPhase(out, stats.cache);
+    putPhase(out, stats.load);
+    putPhase(out, stats.traversal);
+    for (auto counter : {stats.counters.visited, stats.counters.pruned, stats.counters.predicateCalls,
+                         stats.counters.typeIdMatches, stats.counters.duplicateModels,
+                         stats.counters.attributes, stats.counters.sourceBytes})
+        putNumber(out, counter);
+
+    putNumber(out, models.size());
+    for (auto& model : models) {
+        putString(out, model.name);
+        putString(out, model.parent);
+        putString(out, model.usr);
+        putString(out, model.qualifiedName);
+        putString(out, model.file);
+        putNumber(out, model.attributes.size());
+        for (auto& a : model.attributes) {
+            putString(out, a.name);
+            putString(out, a.description);
+            putString(out, a.type);
+            putString(out, a.initialValue);
+            putStrings(out, a.accessor);
+            putString(out, a.checker);
+            putStrings(out, a.checkerArguments);
+            putString(out, a.flags);
+        }
+    }
+
+    return out;
+}
+
+static void decodeUnitResult(const std::string &payload, std::vector<Model> &models, UnitStats &stats)
+{
+    PayloadReader in(payload);
+    stats.cached = in.number();
+    stats.skipped = in.number();
+    stats.expectedModels = in.number();
+    stats.scan = in.phase();
+    stats.cache = in.phase();
+    stats.load = in.phase();
+    stats.traversal = in.phase();
+    for (auto counter : {&stats.counters.visited, &stats.counters.pruned, &stats.counters.predicateCalls,
+                         &stats.counters.typeIdMatches, &stats.counters.duplicateModels,
+                         &stats.counters.attributes, &stats.counters.sourceBytes})
+        *counter = in.number();
+
+    models.clear();
+    for (auto m = in.number(); m > 0; m--) {
+        Model model {in.string()};
+        model.parent = in.string();
+        model.usr = in.string();
+        model.qualifiedName = in.string();
+        model.file = in.string();
+        model.attributes.resize(in.number());
+        for (auto& a : model.attributes) {
+            a.name = in.string();
+            a.description = in.string();
+            a.type = in.string();
+            a.initialValue = in.string();
+            a.accessor = in.strings();
+            a.checker = in.string();
+            a.checkerArguments = in.strings();
+            a.flags = in.string();
+        }
+        models.push_back(std::move(model));
+    }
+    stats.models = models.size();
+}
+
+void Splash::extractIsolated(unsigned jobs)
+{
+    // built once here rather than by every worker process
+    if (m_sharedPch) {
+        for (auto& input : m_inputs) {
+            if (input.kind == TranslationUnitInput::Kind::Source)
+                m_sharedPch->arguments(m_index, input.path);
+        }
+    }
+
+    WorkerPool pool(jobs, m_unitTimeout, [this](std::size_t i) {
+        try {
+            processUnit(0, i);
+        } catch (const TranslationUnitException &e) {
+            throw std::runtime_error("cannot create translation unit from " + e.astFilePath);
+        }
+        return encodeUnitResult(m_unitModels[i], m_stats.units[i]);
+    });
+
+    std::size_t failed = 0;
+    pool.run(m_inputs.size(), [this](std::size_t i, std::string &payload) {
+        UnitStats &stats = m_stats.units[i];
+        stats.path = m_inputs[i].path;
+        decodeUnitResult(payload, m_unitModels[i], stats);
+
+        // the claims of the worker processes are lost with them
+        for (auto& model : m_unitModels[i]) {
+            if (!model.usr.empty())
+                m_registry.claim(model.usr, model.name, i, model.file.empty() ? m_inputs[i].path : model.file);
+        }
+        m_cachedUnits += stats.cached;
+        m_visitedCursors += stats.counters.visited;
+        m_prunedSubtrees += stats.counters.pruned;
+    }, [this, &failed](std::size_t i, const std::string &reason) {
+        UnitStats &stats = m_stats.units[i];
+        stats.path = m_inputs[i].path;
+        stats.failed = true;
+        stats.failure = reason;
+        failed++;
+        diagnose("Warning: extraction of " + m_inputs[i].path + " failed: " + reason + ".");
+    });
+
+    if (failed > 0)
+        diagnose("Extraction failed for " + std::to_string(failed) + " of " + std::to_string(m_inputs.size()) +
+                 " unit(s), " + std::to_string(pool.restarts()) + " worker process(es) restarted.");
 }
 
-Splash* Splash::fromUserInput(int argc, char** argv)
+std::vector<Model> Splash::extractUnit(unsigned worker, std::size_t unit, UnitStats &stats)
 {
-    cxxopts::Options options("Splash", "Transpiler for IoD Sim and Airflow interoperability.");
-    options.add_options()
-        ("ast_file_path", "AST File Path of IoD Sim.", cxxopts::value<std::string>())
-        ("output_file", "File path to write JSON output.", cxxopts::value<std::string>())
-        ("d,debug", "Show debug messages.")
-        ("v,version", "Show the version of the program.")
-        ("h,help", "Print help");
-    options.parse_positional({"ast_file_path", "output_file"});
-    options.show_positional_help();
+    const TranslationUnitInput &input = m_inputs[unit];
+
+    // AST files are already parsed, only sources are worth a scan
+    ScanResult scan;
+    if (m_prescan && input.kind == TranslationUnitInput::Kind::Source) {
+        Stopwatch scanTime(m_stats.unitClock());
+        const bool scanned = ModelScanner::scanFile(input.path, scan);
+        stats.scan = scanTime.elapsed();
+        stats.expectedModels = scan.classes.size();
+
+        // an unreadable file is left to clang to report
+        if (scanned && !scan.mayContainModels()) {
+            SPLASH_TRACE(TraceLevel::Info, "skipped " << input.path << ", no GetTypeId definition");
+            stats.skipped = true;
+            // watched for a GetTypeId to be added
+            if (m_watch)
+                m_unitDependencies[unit] = {std::filesystem::weakly_canonical(input.path).string()};
+            return {};
+        }
+    }
 
-    try {
-        auto result = options.parse(argc, argv);
-        bool debug = false;
+    Stopwatch load(m_stats.unitClock());
+    const auto parseStart = std::filesystem::file_time_type::clock::now();
+    CXTranslationUnit translationUnit = loadTranslationUnit(m_workerIndexes[worker], input);
+    stats.load = load.elapsed();
+    reportClangDiagnostics(translationUnit);
+
+    std::vector<Model> models = traverseUnit(unit, translationUnit, stats);
+    if (m_prescan && input.kind == TranslationUnitInput::Kind::Source)
+        reportScanGaps(unit, scan.classes, models);
+
+    if (m_cache) {
+        Stopwatch store(m_stats.unitClock());
+        m_cache->store(input, translationUnit, models, parseStart,
+                       m_sharedPch ? m_sharedPch->dependencies(input.path) : std::vector<std::string>());
+        stats.cache += store.elapsed();
+    }
 
-        if (result.count("help")) {
-            std::cerr << options.help() << std::endl;
-            exit(0);
+    if (m_watch) {
+        m_unitDependencies[unit] = unitDependencies(unit, translationUnit);
+        m_translationUnits[unit] = translationUnit;
+        m_unitWorkers[unit] = worker;
+    } else {
+        clang_disposeTranslationUnit(translationUnit);
+    }
+    return models;
+}
+
+std::vector<Model> Splash::traverseUnit(std::size_t unit, CXTranslationUnit translationUnit, UnitStats &stats)
+{
+    Stopwatch traversal(m_stats.unitClock());
+    t_predicateCalls = 0;
+    t_sourceBytes = 0;
+    std::vector<Model> models;
+    VisitorContext context {models, stats.counters, m_pruneTraversal, 0};
+    context.registry = &m_registry;
+    context.unit = unit;
+    context.file = &m_inputs[unit].path;
+    // watch mode keeps every model of a unit, as the owner may change on
+    // update, worker processes do not share their claims, and a cache entry
+    // must hold the whole unit: mergeUnits drops the duplicates
+    context.skipClaimed = !m_watch && !m_isolate && !m_cache;
+    CXCursor cursor = clang_getTranslationUnitCursor(translationUnit);
+    clang_visitChildren(cursor, explorerCallback, &context);
+    stats.counters.predicateCalls = t_predicateCalls;
+    stats.counters.sourceBytes = t_sourceBytes;
+    stats.models = models.size();
+    stats.traversal = traversal.elapsed();
+
+    return models;
+}
+
+void Splash::reportScanGaps(std::size_t unit, const std::vector<std::string> &expectedClasses,
+                            const std::vector<Model> &models) const
+{
+    // a GetTypeId defined outside namespace ns3 is seen by the scan only, one
+    // produced by a macro by the parse only
+    for (auto& name : expectedClasses) {
+        auto found = std::find_if(models.begin(), models.end(), [&name](const Model &m) { return m.name == name; });
+        if (found == models.end())
+            diagnose("Warning: expected model " + name + " in " + m_inputs[unit].path + ", none extracted.");
+    }
+    // the models of the headers are not scanned
+    for (auto& model : models) {
+        if (model.file.empty() &&
+            std::find(expectedClasses.begin(), expectedClasses.end(), model.name) == expectedClasses.end())
+            diagnose("Warning: model " + model.name + " in " + m_inputs[unit].path + " not expected by the scan.");
+    }
+}
+
+std::vector<std::string> Splash::unitDependencies(std::size_t unit, CXTranslationUnit translationUnit) const
+{
+    std::vector<std::string> dependencies;
+    if (m_inputs[unit].kind == TranslationUnitInput::Kind::Ast) {
+        dependencies.push_back(m_inputs[unit].path);
+    } else {
+        // the main file is reported as an inclusion with an empty stack
+        clang_getInclusions(translationUnit, [](CXFile includedFile, CXSourceLocation *, unsigned, CXClientData clientData) {
+            CXString fileName = clang_getFileName(includedFile);
+            static_cast<std::vector<std::string> *>(clientData)->push_back(clang_getCString(fileName));
+            clang_disposeString(fileName);
+        }, &dependencies);
+    }
+
+    // inotify reports the paths of the watched directories, compare canonical paths
+    for (auto& path : dependencies) {
+        std::error_code ec;
+        auto canonical = std::filesystem::canonical(path, ec);
+        if (!ec)
+            path = canonical.string();
+    }
+    return dependencies;
+}
+
+// set by the SIGINT and SIGTERM handlers to leave the watch loop
+static volatile std::sig_atomic_t s_stopWatching = 0;
+
+void Splash::watch()
+{
+    if (!m_watch)
+        return;
+
+    FileWatcher watcher;
+    // the files of a directory that cannot be watched are only missed
+    auto watchDirectoryOf = [this, &watcher](const std::string &path) {
+        try {
+            watcher.watchDirectory(std::filesystem::path(path).parent_path().string());
+        } catch (const std::runtime_error &e) {
+            diagnose(std::string("Warning: ") + e.what() + ", its changes are not reported.");
         }
+    };
+
+    std::unordered_map<std::string, std::vector<std::size_t>> dependents;
+    for (std::size_t i = 0; i < m_inputs.size(); i++) {
+        for (auto& path : m_unitDependencies[i]) {
+            auto& units = dependents[path];
+            if (units.empty() || units.back() != i)
+                units.push_back(i);
+            watchDirectoryOf(path);
+        }
+    }
 
-        if (result.count("version")) {
-            std::cout << VERSION << std::endl;
+    s_stopWatching = 0;
+    std::signal(SIGINT, [](int) { s_stopWatching = 1; });
+    std::signal(SIGTERM, [](int) { s_stopWatching = 1; });
+    diagnose("Watching " + std::to_string(dependents.size()) + " file(s) in " + std::to_string(watcher.directories()) +
+             " directory(ies), press Ctrl-C to stop.");
+
+    while (!s_stopWatching) {
+        const auto changed = watcher.wait(s_stopWatching);
+        if (changed.empty())
+            continue;
+
+        std::vector<std::size_t> units;
+        for (auto& path : changed) {
+            auto it = dependents.find(path);
+            if (it != dependents.end())
+                units.insert(units.end(), it->second.begin(), it->second.end());
+        }
+        std::sort(units.begin(), units.end());
+        units.erase(std::unique(units.begin(), units.end()), units.end());
+        if (units.empty())
+            continue;
+
+        // the hashes memoized by the cache are stale now
+        if (m_cache)
+            m_cache->forget(changed);
+
+        const auto start = std::chrono::steady_clock::now();
+        try {
+            updateUnits(units);
+            mergeUnits();
+            exportExtractedInformation();
+        } catch (const TranslationUnitException &e) {
+            // keep watching, the next save may fix it
+            diagnose("Cannot create translation unit from " + e.astFilePath + ".");
+            continue;
+        } catch (const ModelWriterException &e) {
+            diagnose("Cannot write " + e.outputPath + ": " + e.reason + ".");
+            continue;
+        } catch (const BinaryIrException &e) {
+            diagnose("Cannot write " + e.path + ": " + e.reason + ".");
+            continue;
+        } catch (const RyvenEmitterException &e) {
+            diagnose("Cannot write " + e.path + ": " + e.reason + ".");
+            continue;
         }
 
-        if (result.count("debug")) {
-            debug = true;
+        // an edit may include new headers
+        for (auto i : units) {
+            for (auto& path : m_unitDependencies[i]) {
+                auto& dependentUnits = dependents[path];
+                if (std::find(dependentUnits.begin(), dependentUnits.end(), i) == dependentUnits.end())
+                    dependentUnits.push_back(i);
+                watchDirectoryOf(path);
+            }
         }
 
-        if (!result.count("ast_file_path")) {
-            std::cerr << "AST File Path hasn't been specified." << std::endl;
-            exit(1);
+        const auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - start);
+        diagnose("Updated " + std::to_string(units.size()) + " unit(s) and " + std::to_string(m_models.size()) +
+                 " model(s) in " + std::to_string(elapsed.count()) + " ms.");
+    }
+
+    std::signal(SIGINT, SIG_DFL);
+    std::signal(SIGTERM, SIG_DFL);
+}
+
+void Splash::updateUnits(const std::vector<std::size_t> &units)
+{
+    // a translation unit stays with the worker, and the index, that created it
+    std::vector<std::vector<std::size_t>> unitsOfWorker(m_workerIndexes.size());
+    for (auto i : units)
+        unitsOfWorker[m_unitWorkers[i]].push_back(i);
+
+    auto update = [this](const std::vector<std::size_t> &workerUnits) {
+        for (auto i : workerUnits) {
+            if (m_failed)
+                return;
+            try {
+                UnitStats stats;
+                CXTranslationUnit &translationUnit = m_translationUnits[i];
+                SPLASH_TRACE(TraceLevel::Info, "reparsing " << m_inputs[i].path);
+
+                // an AST file is replaced as a whole, a source reuses its preamble
+                const auto parseStart = std::filesystem::file_time_type::clock::now();
+                if (translationUnit && m_inputs[i].kind == TranslationUnitInput::Kind::Source &&
+                    clang_reparseTranslationUnit(translationUnit, 0, nullptr,
+                                                 clang_defaultReparseOptions(translationUnit)) == 0) {
+                    reportClangDiagnostics(translationUnit);
+                    m_unitModels[i] = traverseUnit(i, translationUnit, stats);
+                    m_unitDependencies[i] = unitDependencies(i, translationUnit);
+                    if (m_cache)
+                        m_cache->store(m_inputs[i], translationUnit, m_unitModels[i], parseStart);
+                } else {
+                    // a failed reparse leaves the unit unusable
+                    if (translationUnit)
+                        clang_disposeTranslationUnit(translationUnit);
+                    translationUnit = nullptr;
+                    m_unitModels[i] = extractUnit(m_unitWorkers[i], i, stats);
+                }
+
+                if (m_unitModels[i].empty() && !stats.skipped)
+                    diagnose("Warning: no TypeId found in " + m_inputs[i].path);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(m_failureMutex);
+                if (!m_failed.exchange(true))
+                    m_failure = std::current_exception();
+            }
         }
-        if (!result.count("output_file")) {
-            std::cerr << "Output File Path hasn't been specified." << std::endl;
-            exit(1);
+    };
+
+    std::vector<std::thread> workers;
+    for (std::size_t w = 1; w < unitsOfWorker.size(); w++) {
+        if (!unitsOfWorker[w].empty())
+            workers.emplace_back(update, std::cref(unitsOfWorker[w]));
+    }
+    update(unitsOfWorker[0]);
+    for (auto& w : workers)
+        w.join();
+
+    if (m_failed) {
+        m_failed = false;
+        auto failure = m_failure;
+        m_failure = nullptr;
+        std::rethrow_exception(failure);
+    }
+}
+
+CXTranslationUnit Splash::loadTranslationUnit(CXIndex index, const TranslationUnitInput &input)
+{
+    CXTranslationUnit translationUnit = nullptr;
+
+    if (input.kind == TranslationUnitInput::Kind::Ast) {
+        translationUnit = clang_createTranslationUnit(index, input.path.c_str());
+    } else {
+        // Only GetTypeId definitions of the main file are explored, so function bodies
+        // of the included headers are skipped while building the preamble. KeepGoing
+        // lets a model be extracted even if some unrelated header fails to compile.
+        const unsigned preambleOptions = CXTranslationUnit_KeepGoing |
+                                         CXTranslationUnit_SkipFunctionBodies |
+                                         CXTranslationUnit_LimitSkipFunctionBodiesToPreamble |
+                                         CXTranslationUnit_PrecompiledPreamble |
+                                         CXTranslationUnit_CreatePreambleOnFirstParse;
+
+        std::vector<std::string> pchArguments;
+        if (m_pchMode == PchMode::Umbrella)
+            pchArguments = m_sharedPch->arguments(index, input.path);
+
+        if (!pchArguments.empty()) {
+            // the shared PCH already skipped the header bodies
+            translationUnit = parseSource(index, input, pchArguments, CXTranslationUnit_KeepGoing);
+            if (translationUnit && hasFatalDiagnostic(translationUnit)) {
+                SPLASH_TRACE(TraceLevel::Info, "shared PCH rejected by " << input.path);
+                clang_disposeTranslationUnit(translationUnit);
+                translationUnit = parseSource(index, input, {}, preambleOptions);
+            }
+        } else if (m_pchMode == PchMode::None) {
+            translationUnit = parseSource(index, input, {}, CXTranslationUnit_KeepGoing);
+        } else {
+            translationUnit = parseSource(index, input, {}, preambleOptions);
         }
+    }
 
-        std::string inputAstFilePath = result["ast_file_path"].as<std::string>();
-        std::string outputFilePath = result["output_file"].as<std::string>();
+    if (translationUnit == NULL)
+        throw TranslationUnitException(input.path);
 
-        return getInstance(inputAstFilePath, outputFilePath, debug);
-    } catch (cxxopts::option_not_exists_exception e) {
-        std::cerr << "Error: "<< e.what() << std::endl;
-        exit(1);
+    return translationUnit;
+}
+
+CXTranslationUnit Splash::parseSource(CXIndex index, const TranslationUnitInput &input,
+                                      const std::vector<std::string> &extraArguments, unsigned options)
+{
+    std::vector<const char *> args;
+    for (auto& a : input.arguments)
+        args.push_back(a.c_str());
+    for (auto& a : extraArguments)
+        args.push_back(a.c_str());
+
+    CXTranslationUnit translationUnit = nullptr;
+    const auto err = clang_parseTranslationUnit2(index, input.path.c_str(),
+                                                 args.data(), args.size(),
+                                                 nullptr, 0, options, &translationUnit);
+    return err == CXError_Success ? translationUnit : nullptr;
+}
+
+bool Splash::hasFatalDiagnostic(CXTranslationUnit translationUnit)
+{
+    for (unsigned i = 0; i < clang_getNumDiagnostics(translationUnit); i++) {
+        CXDiagnostic diagnostic = clang_getDiagnostic(translationUnit, i);
+        const bool fatal = clang_getDiagnosticSeverity(diagnostic) == CXDiagnostic_Fatal;
+        clang_disposeDiagnostic(diagnostic);
+        if (fatal)
+            return true;
     }
+
+    return false;
 }
 
-int main(int argc, char** argv)
+void Splash::reportClangDiagnostics(CXTranslationUnit translationUnit) const
 {
-    try {
-        auto s = Splash::fromUserInput(argc, argv);
-        s->run();
-        s->exportExtractedInformation();
-    } catch (TranslationUnitException e) {
-        std::cerr << "Cannot create translation unit." << std::endl;
-        exit(1);
+    if (m_printClangDiagnostics)
+        return;
+
+    for (unsigned i = 0; i < clang_getNumDiagnostics(translationUnit); i++) {
+        CXDiagnostic diagnostic = clang_getDiagnostic(translationUnit, i);
+        if (clang_getDiagnosticSeverity(diagnostic) >= CXDiagnostic_Warning) {
+            CXString text = clang_formatDiagnostic(diagnostic, clang_defaultDiagnosticDisplayOptions());
+            diagnose(clang_getCString(text));
+            clang_disposeString(text);
+        }
+        clang_disposeDiagnostic(diagnostic);
     }
 }
+
+TranslationUnitInput Splash::inputFromPath(const std::string &path,
+                                           const CompileDatabase *compileDatabase,
+                                           const std::vector<std::string> &extraArguments,
+                                           const DiagnosticHandler &diagnose)
+{
+    const auto extension = std::filesystem::path(path).extension();
+    if (extension == ".ast" || extension == ".pch")
+        return {TranslationUnitInput::Kind::Ast, path};
+
+    // compile commands may change the working directory, keep the path absolute
+    const auto sourcePath = CompileDatabase::normalizePath(path);
+    std::vector<std::string> arguments;
+    if (compileDatabase != nullptr) {
+        auto command = compileDatabase->find(path);
+        if (command != nullptr)
+            arguments = command->arguments;
+        else
+            diagnose("Warning: " + path + " is not in the compilation database.");
+    }
+    arguments.insert(arguments.end(), extraArguments.begin(), extraArguments.end());
+
+    return {TranslationUnitInput::Kind::Source, sourcePath, arguments};
+}
+
+void Splash::loadModels(const std::string &path, ModelTable &models)
+{
+    if (BinaryIr::isBinaryIr(path)) {
+        for (auto& model : BinaryIrReader(path).models())
+            models.append(model);
+        return;
+    }
+
+    std::ifstream ifs(path);
+    if (!ifs)
+        throw std::runtime_error("cannot open " + path);
+    std::string contents((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
+    for (auto& model : modelsFromJson(boost::json::parse(contents)))
+        models.append(model);
+}
@@ -1,81 +1,243 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
 #include <exception>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <string_view>
 #include <vector>
 
 #include <clang-c/Index.h>
 
+#include "compile_database.h"
+#include "diagnostic.h"
+#include "model.h"
+#include "model_registry.h"
+#include "model_table.h"
+#include "shared_pch.h"
+#include "stats.h"
+
 // Helper structures for Splash
 class TranslationUnitException : std::exception
-{};
+{
+public:
+    TranslationUnitException(std::string path):
+        astFilePath {path}
+    {}
+
+    std::string astFilePath;
+};
 
-class Attribute {
+// An input of a Splash session: either an AST file generated with
+// clang -emit-ast, or a source file parsed in memory with its own flags.
+class TranslationUnitInput {
 public:
-    Attribute() {}
+    enum class Kind { Ast, Source };
 
-    std::string name;
-    std::string description;
-    std::string type;
+    TranslationUnitInput(Kind k, std::string p, std::vector<std::string> args = {}):
+        kind {k},
+        path {p},
+        arguments {args}
+    {}
+
+    Kind kind;
+    std::string path;
+    std::vector<std::string> arguments;
 };
 
-class Model {
+class ExtractionCache;
+
+// Airflow (Ryven) nodes package refreshed after every export
+class RyvenOutput {
 public:
-    Model(std::string n):
-        parent {""},
-        name {n},
-        attributes {}
+    RyvenOutput() {}
+
+    bool enabled() const { return !directory.empty(); }
+
+    std::string directory;
+    std::string package;
+    std::string typeMap;
+};
+
+// Traversal state handed to libclang visitors through CXClientData.
+// Each worker owns its contexts, so no visitor touches shared state.
+class VisitorContext {
+public:
+    VisitorContext(std::vector<Model> &m, TraversalCounters &c, bool p, unsigned l):
+        models {m},
+        counters {c},
+        prune {p},
+        level {l}
     {}
 
-    std::string parent;
-    std::string name;
-    std::vector<Attribute> attributes;
+    std::vector<Model> &models;
+    TraversalCounters &counters;
+    bool prune;
+    unsigned level;
+    // every model is claimed in the registry, those owned by a lower unit
+    // are skipped with skipClaimed
+    ModelRegistry *registry {nullptr};
+    std::size_t unit {0};
+    const std::string *file {nullptr};
+    bool skipClaimed {false};
+};
+
+// Settings of a Splash session, from the command line or the C API
+class SplashOptions {
+public:
+    SplashOptions() {}
+
+    // JSON or binary IR file written by exportExtractedInformation
+    std::string outputPath;
+    bool appendOutput {false};
+    unsigned jobs {1};
+    // no extraction cache if empty
+    std::string cacheDirectory;
+    bool rebuildCache {false};
+    bool pruneTraversal {true};
+    bool resolveParents {false};
+    // no --stats sidecar if empty
+    std::string statsPath;
+    PchMode pchMode {PchMode::Preamble};
+    bool watch {false};
+    RyvenOutput ryvenOutput;
+    bool prescan {false};
+    bool isolate {false};
+    // zero lets every unit run for as long as it needs
+    std::chrono::milliseconds unitTimeout {0};
+    // warnings and progress messages are dropped without one
+    DiagnosticHandler diagnosticHandler;
+    // libclang prints the diagnostics of every parse on stderr, otherwise
+    // they are handed to diagnosticHandler
+    bool printClangDiagnostics {true};
 };
 
 class Splash
 {
 public:
+    Splash(std::vector<TranslationUnitInput> inputs, SplashOptions options);
     ~Splash();
 
-    void printExtractedInformation();
+    // Version of the extractor, part of the extraction cache keys
+    static constexpr const char *VERSION = "v0.1.0";
+
     void exportExtractedInformation();
-    static Splash* getInstance(std::string inputFilePath, std::string outputFilePath, bool debugMode);
-    static Splash* fromUserInput(int argc, char** argv);
+    // Writes the --stats sidecar, if one was requested
+    void writeStats();
+    // Adds a phase timed outside of the session, such as the command line
+    // setup, to the stats
+    void recordPhase(const std::string &name, PhaseTime time) { m_stats.recordPhase(name, time); }
+    // Appends the models of a JSON or binary IR file
+    static void loadModels(const std::string &path, ModelTable &models);
+    // An AST file for .ast and .pch paths, otherwise a source file parsed
+    // with its flags from compileDatabase, if any, and extraArguments
+    static TranslationUnitInput inputFromPath(const std::string &path,
+                                              const CompileDatabase *compileDatabase,
+                                              const std::vector<std::string> &extraArguments,
+                                              const DiagnosticHandler &diagnose);
     static CXChildVisitResult explorerCallback(CXCursor cursor, CXCursor parent, CXClientData client_data);
     static CXChildVisitResult argumentExtractorCallback(CXCursor cursor, CXCursor parent, CXClientData clientData);
 
     void run();
+    // Models of the last run, valid until the next one
+    const ModelTable& models() const { return m_models; }
+    // With --watch, keeps the translation units in memory and extracts
+    // again the units whose files change, until SIGINT or SIGTERM
+    void watch();
 
-private:
-    Splash(std::string astFilePath, std::string outputPath, bool debugMode);
-    void extractModel(const CXCursor &cursor);
-    static void exctractArgument(const CXCursor &cursor, unsigned int level);
-
-    static bool isDebugEnabled();
-    static bool isNamespace(const CXCursor &cursor, std::string namespaceName);
-    static bool isMethod(const CXCursor &cursor, std::string methodName);
+    // Cursor predicates, evaluated on every visited cursor. They compare
+    // libclang strings in place and never copy them into a std::string.
+    static bool isNamespace(const CXCursor &cursor, std::string_view namespaceName);
+    static bool isMethod(const CXCursor &cursor, std::string_view methodName);
     static bool isTypeReference(const CXCursor &cursor);
-    static bool hasParent(const CXCursor &parent, std::string targetParent);
-    static bool isDecl(const CXCursor &cursor, std::string typeDecl, std::string parentName);
-    static bool isCallExpr(const CXCursor &cursor, std::string exprReturnType, std::string name);
+    static bool hasParent(const CXCursor &parent, std::string_view targetParent);
+    static bool isDecl(const CXCursor &cursor, std::string_view typeDecl, std::string_view parentName);
+    static bool isCallExpr(const CXCursor &cursor, std::string_view exprReturnType, std::string_view name);
     static bool isFromMainFile(const CXCursor &cursor);
-    static void inspectCursor(const CXCursor &cursor);
-    static void inspectCursor(const CXCursor &cursor, const CXCursor &parent);
-    static void showSpell(const CXCursor &cursor);
-    static void showType(const CXCursor &cursor);
-    static void showLocation(const CXCursor &cursor);
-    static void showUsr(const CXCursor &cursor);
-    static void showCursorKind(const CXCursor &cursor);
-    static void showIncludedFile(const CXCursor &cursor);
-    static void showParent(const CXCursor &cursor, const CXCursor &parent);
+
+private:
+    // Hands message to the diagnostic handler, one worker at a time
+    void diagnose(const std::string &message) const;
+    void extractUnits(unsigned worker);
+    void processUnit(unsigned worker, std::size_t unit);
+    void extractIsolated(unsigned jobs);
+    void mergeUnits();
+    void reportConflicts();
+    void resolveParents();
+    void emitRyvenNodes();
+    std::vector<Model> extractUnit(unsigned worker, std::size_t unit, UnitStats &stats);
+    std::vector<Model> traverseUnit(std::size_t unit, CXTranslationUnit translationUnit, UnitStats &stats);
+    void reportScanGaps(std::size_t unit, const std::vector<std::string> &expectedClasses,
+                        const std::vector<Model> &models) const;
+    void updateUnits(const std::vector<std::size_t> &units);
+    std::vector<std::string> unitDependencies(std::size_t unit, CXTranslationUnit translationUnit) const;
+    CXTranslationUnit loadTranslationUnit(CXIndex index, const TranslationUnitInput &input);
+    static CXTranslationUnit parseSource(CXIndex index, const TranslationUnitInput &input,
+                                         const std::vector<std::string> &extraArguments, unsigned options);
+    static bool hasFatalDiagnostic(CXTranslationUnit translationUnit);
+    // Hands the warnings and errors of a parse to the diagnostic handler,
+    // unless libclang printed them
+    void reportClangDiagnostics(CXTranslationUnit translationUnit) const;
+    static void extractModel(const CXCursor &cursor, std::vector<Model> &models);
+    static void exctractArgument(const CXCursor &cursor, VisitorContext *context);
+
+    static bool equals(CXString str, std::string_view target);
+    static bool mayContainModels(const CXCursor &cursor, unsigned level);
+    static bool isTypeIdMethodCall(const CXCursor &cursor);
+    static CXCursor getFirstChild(const CXCursor &cursor);
     static std::string getParentObjectName(const CXCursor &cursor);
+    static std::string getParentObjectUsr(const CXCursor &cursor);
+    static std::string getDefinitionFile(const CXCursor &cursor);
     static std::string getTypeName(const CXCursor &cursor);
     static std::string getSourceCode(const CXCursor &cursor);
+    static std::string getExpressionText(const CXCursor &cursor);
+    static std::string getExpressionValue(const CXCursor &cursor);
+    static std::string getConstructorArguments(const CXCursor &cursor);
+    static bool isFunctionCall(const CXCursor &cursor);
+    static CXCursor findFunctionCall(const CXCursor &cursor);
+    static std::vector<std::string> getCallArguments(const CXCursor &call);
+    static bool isIntegerExpression(const CXCursor &cursor);
+    static std::string getStringLiteral(const CXCursor &cursor);
     static std::string getSourceCodeText(std::string filePath, unsigned int startOffset, unsigned int endOffset);
+    static std::string stripLiteral(std::string_view text);
+    static bool unescapeLiteral(std::string_view spelling, std::string &value);
 
-    static Splash* m_instance;
-    std::string m_astFilePath;
+    std::vector<TranslationUnitInput> m_inputs;
     std::string m_outputFilePath;
-    CXTranslationUnit m_translationUnit;
+    bool m_appendOutput;
     CXIndex m_index;
-    std::vector<Model> m_models;
-    bool m_debug;
+    ModelTable m_models;
+    unsigned m_jobs;
+    std::unique_ptr<ExtractionCache> m_cache;
+    std::atomic<std::size_t> m_cachedUnits;
+    bool m_pruneTraversal;
+    bool m_resolveParents;
+    std::atomic<std::size_t> m_visitedCursors;
+    std::atomic<std::size_t> m_prunedSubtrees;
+    ModelRegistry m_registry;
+    PchMode m_pchMode;
+    std::unique_ptr<SharedPch> m_sharedPch;
+    bool m_watch;
+    bool m_prescan;
+    bool m_isolate;
+    std::chrono::milliseconds m_unitTimeout;
+    RyvenOutput m_ryvenOutput;
+    // index of every worker, the first one is m_index
+    std::vector<CXIndex> m_workerIndexes;
+    // per input, kept between updates in watch mode
+    std::vector<std::vector<Model>> m_unitModels;
+    std::vector<CXTranslationUnit> m_translationUnits;
+    std::vector<unsigned> m_unitWorkers;
+    std::vector<std::vector<std::string>> m_unitDependencies;
+    std::string m_statsPath;
+    RunStats m_stats;
+    DiagnosticHandler m_diagnosticHandler;
+    mutable std::mutex m_diagnosticMutex;
+    bool m_printClangDiagnostics;
+    std::atomic<std::size_t> m_nextUnit;
+    std::atomic<bool> m_failed;
+    std::exception_ptr m_failure;
+    std::mutex m_failureMutex;
 };
@@ -8,6 +8,8 @@ if [ -z "$1" ]; then
     exit 1
 fi
 IODSIM_DIR=$1
+# pass --rebuild as second argument to ignore the extraction cache
+REBUILD=$2
 
 # check dependencies are OK
 SPLASH=$(find . -name splash -executable -type f)
@@ -16,67 +18,33 @@ if [ -z "$SPLASH" ]; then
     exit 1
 fi
 
-which clang &>/dev/null
-if [ "$?" -ne 0 ]; then
-    echo "Cannot find clang installed in your system. Make sure clang is installed and available in your PATH."
+COMPILE_COMMANDS="${IODSIM_DIR}/ns3/build/compile_commands.json"
+if [ ! -f "$COMPILE_COMMANDS" ]; then
+    echo "Cannot find ${COMPILE_COMMANDS}. Did you configure ns-3 with --enable-compile-commands or CMake?"
     exit 1
 fi
 
-which jq &>/dev/null
-if [ "$?" -ne 0 ]; then
-    echo "Cannot find jq installed in your system. Make sure jq is installed and available in your PATH."
-    exit 1
-fi
-
-# cleanup everything
-rm -rf {models,irs,packages}
+# cleanup everything but the extraction cache and the packages, which
+# emit-ryven only rewrites where they changed
+rm -rf irs
 # directory skeleton
-mkdir {models,irs,packages} 2>/dev/null
-
-# FILES=$(cat ${IODSIM_DIR}/ns3/build/compile_commands.json | jq -c '.[] | .file' | sed -e 's/^\"\.\.\///g' -e 's/\"$//g' | grep '^src/')
-# FILES_NUM=$(cat ${IODSIM_DIR}/ns3/build/compile_commands.json | jq -c '.[] | .file' | sed -e 's/^\"\.\.\///g' -e 's/\"$//g' | grep '^src/' | wc -l)
-# INCLUDE_FLAGS=$(cat ${IODSIM_DIR}/ns3/build/compile_commands.json | jq -c '.[] | .command' | grep -o '\-I[a-zA-Z0-9\/\.]* ' | sort | uniq | sed -e '/^-I\// ! s/-I/-I\$\{IODSIM_DIR\}\/ns3\/build\//g')
-
-FILES=$(find -L ${IODSIM_DIR}/ns3/src/ \
-             -type d \( -name examples -o -name test \) \
-             -prune -false \
-             -o -name "*-model.cc" \
-             -o -name "*-manager.cc" \
-             -o -name "*-mac.cc" \
-             -o -name "*application.cc" \
-             -o -name "*energy-source.cc")
-FILES_NUM=$(find -L ${IODSIM_DIR}/ns3/src/ \
-                 -type d \( -name examples -o -name test \) \
-                 -prune -false \
-                 -o -name "*-model.cc" \
-                 -o -name "*-manager.cc" \
-                 -o -name "*-mac.cc" \
-                 -o -name "*application.cc" \
-                 -o -name "*energy-source.cc" | wc -l)
-i=1
-for f in $FILES; do
-    #FPATH="${IODSIM_DIR}/ns3/${f}"
-    FPATH=$f
-    FNAME=${FPATH##*/}
-    FNAME_WITHOUT_EXT=${FNAME%.*}
-    PCH_MODEL_PATH="models/${FNAME_WITHOUT_EXT}.pch"
-    IR_MODEL_PATH="irs/${FNAME_WITHOUT_EXT}.json"
-
-    echo "[${i}/${FILES_NUM}] Transpiling ${FNAME}"
-    clang -x c++ \
-      -I${IODSIM_DIR}/ns3/build/ \
-      -emit-ast \
-      -o $PCH_MODEL_PATH \
-      $FPATH
-
-    $SPLASH $PCH_MODEL_PATH $IR_MODEL_PATH
-    i=$(($i + 1))
-done
-
-pushd irs &>/dev/null
-jq -s '.[0]=([.[]]|flatten)|.[0]' *.json > merged.json
-popd &>/dev/null
-
-./parent_solver.py irs/merged.json irs/merged-parent_solved.json
-
-./generate_nodes.py irs/merged-parent_solved.json packages/ -p iodsim
+mkdir {irs,packages} 2>/dev/null
+
+# a single splash session discovers the model sources, parses every one in
+# memory with its own flags from the compilation database and merges the
+# models. Sources without GetTypeId are skipped before reaching clang.
+$SPLASH -p $COMPILE_COMMANDS \
+        --discover ${IODSIM_DIR}/ns3/src \
+        --exclude examples \
+        --exclude test \
+        --prefilter \
+        --cache-dir cache \
+        $REBUILD \
+        --resolve-parents \
+        --pch umbrella \
+        --unit-timeout 300 \
+        -o irs/merged.json \
+        --stats irs/stats.json \
+        -j $(nproc)
+
+$SPLASH emit-ryven irs/merged.json packages -p iodsim -j $(nproc)
@@ -0,0 +1,250 @@
+#include "libsplash.h"
+
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "binary_ir.h"
+#include "compile_database.h"
+#include "model_index.h"
+#include "model_writer.h"
+#include "ryven_emitter.h"
+#include "splash.h"
+#include "stats.h"
+
+struct SplashSession {
+    std::vector<TranslationUnitInput> inputs;
+    std::unique_ptr<CompileDatabase> compileDatabase;
+    std::vector<std::string> extraArguments;
+    SplashOptions options;
+    std::unique_ptr<Splash> splash;
+    std::string error;
+    std::vector<std::string> diagnostics;
+};
+
+static SplashString view(std::string_view s)
+{
+    return {s.data(), s.size()};
+}
+
+// Runs f, turning the exceptions of splash into the session error
+template <typename F>
+static int guarded(SplashSession *session, F f)
+{
+    session->error.clear();
+    try {
+        f();
+        return 0;
+    } catch (const TranslationUnitException &e) {
+        session->error = "cannot create translation unit from " + e.astFilePath;
+    } catch (const CompileDatabaseException &e) {
+        session->error = "cannot read compilation database " + e.databasePath + ": " + e.reason;
+    } catch (const ModelWriterException &e) {
+        session->error = "cannot write " + e.outputPath + ": " + e.reason;
+    } catch (const BinaryIrException &e) {
+        session->error = "cannot write " + e.path + ": " + e.reason;
+    } catch (const RyvenEmitterException &e) {
+        session->error = "cannot write " + e.path + ": " + e.reason;
+    } catch (const ModelIndexException &e) {
+        session->error = "cannot write " + e.path + ": " + e.reason;
+    } catch (const StatsException &e) {
+        session->error = "cannot write " + e.path + ": " + e.reason;
+    } catch (const std::exception &e) {
+        session->error = e.what();
+    } catch (...) {
+        session->error = "unknown error";
+    }
+    return -1;
+}
+
+SplashSession *splash_session_create(void)
+{
+    try {
+        auto session = new SplashSession();
+        session->options.diagnosticHandler = [session](const std::string &message) {
+            session->diagnostics.push_back(message);
+        };
+        // the host process owns stderr, clang diagnostics are kept with the others
+        session->options.printClangDiagnostics = false;
+        return session;
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+void splash_session_destroy(SplashSession *session)
+{
+    delete session;
+}
+
+const char *splash_session_error(const SplashSession *session)
+{
+    return session->error.c_str();
+}
+
+size_t splash_session_diagnostic_count(const SplashSession *session)
+{
+    return session->diagnostics.size();
+}
+
+const char *splash_session_diagnostic(const SplashSession *session, size_t i)
+{
+    return i < session->diagnostics.size() ? session->diagnostics[i].c_str() : "";
+}
+
+void splash_session_clear_diagnostics(SplashSession *session)
+{
+    session->diagnostics.clear();
+}
+
+int splash_session_load_compile_commands(SplashSession *session, const char *path)
+{
+    return guarded(session, [&] {
+        session->compileDatabase = std::make_unique<CompileDatabase>(CompileDatabase::fromFile(path));
+    });
+}
+
+void splash_session_add_extra_argument(SplashSession *session, const char *argument)
+{
+    session->extraArguments.emplace_back(argument);
+}
+
+int splash_session_add_input(SplashSession *session, const char *path)
+{
+    return guarded(session, [&] {
+        session->inputs.push_back(Splash::inputFromPath(path, session->compileDatabase.get(), session->extraArguments,
+                                                     session->options.diagnosticHandler));
+    });
+}
+
+int splash_session_add_source(SplashSession *session, const char *path,
+                              const char *const *arguments, size_t count)
+{
+    return guarded(session, [&] {
+        std::vector<std::string> args(arguments, arguments + count);
+        session->inputs.emplace_back(TranslationUnitInput::Kind::Source, CompileDatabase::normalizePath(path), args);
+    });
+}
+
+void splash_session_set_jobs(SplashSession *session, unsigned jobs)
+{
+    session->options.jobs = jobs;
+}
+
+void splash_session_set_resolve_parents(SplashSession *session, int enabled)
+{
+    session->options.resolveParents = enabled != 0;
+}
+
+void splash_session_set_prescan(SplashSession *session, int enabled)
+{
+    session->options.prescan = enabled != 0;
+}
+
+void splash_session_set_cache(SplashSession *session, const char *directory)
+{
+    session->options.cacheDirectory = directory != nullptr ? directory : "";
+}
+
+void splash_session_set_output(SplashSession *session, const char *path)
+{
+    session->options.outputPath = path != nullptr ? path : "";
+}
+
+int splash_session_run(SplashSession *session)
+{
+    return guarded(session, [&] {
+        if (session->inputs.empty())
+            throw std::runtime_error("no input was added to the session");
+
+        // the views of the previous run die with it
+        session->splash.reset();
+        session->splash = std::make_unique<Splash>(session->inputs, session->options);
+        session->splash->run();
+    });
+}
+
+int splash_session_export(SplashSession *session)
+{
+    return guarded(session, [&] {
+        if (!session->splash)
+            throw std::runtime_error("the session has not run");
+        if (session->options.outputPath.empty())
+            throw std::runtime_error("no output was set with splash_session_set_output");
+        session->splash->exportExtractedInformation();
+    });
+}
+
+size_t splash_model_count(const SplashSession *session)
+{
+    return session->splash ? session->splash->models().size() : 0;
+}
+
+// indexes come from foreign callers, out of range ones read as empty
+static bool hasModel(const SplashSession *session, size_t model)
+{
+    return model < splash_model_count(session);
+}
+
+static bool hasAttribute(const SplashSession *session, size_t model, uint32_t attribute)
+{
+    return hasModel(session, model) && attribute < session->splash->models().attributeCount(model);
+}
+
+SplashString splash_model_name(const SplashSession *session, size_t model)
+{
+    if (!hasModel(session, model))
+        return {nullptr, 0};
+    return view(session->splash->models().name(model));
+}
+
+SplashString splash_model_parent(const SplashSession *session, size_t model)
+{
+    if (!hasModel(session, model))
+        return {nullptr, 0};
+    return view(session->splash->models().parent(model));
+}
+
+uint32_t splash_attribute_count(const SplashSession *session, size_t model)
+{
+    return hasModel(session, model) ? session->splash->models().attributeCount(model) : 0;
+}
+
+SplashString splash_attribute_field(const SplashSession *session, size_t model, uint32_t attribute,
+                                    SplashAttributeField field)
+{
+    if (!hasAttribute(session, model, attribute))
+        return {nullptr, 0};
+    const ModelTable &models = session->splash->models();
+    const AttributeRecord &a = models.attribute(model, attribute);
+    switch (field) {
+    case SPLASH_ATTRIBUTE_NAME: return view(models.string(a.name));
+    case SPLASH_ATTRIBUTE_DESCRIPTION: return view(models.string(a.description));
+    case SPLASH_ATTRIBUTE_TYPE: return view(models.string(a.type));
+    case SPLASH_ATTRIBUTE_INITIAL_VALUE: return view(models.string(a.initialValue));
+    case SPLASH_ATTRIBUTE_CHECKER: return view(models.string(a.checker));
+    case SPLASH_ATTRIBUTE_FLAGS: return view(models.string(a.flags));
+    }
+    return {nullptr, 0};
+}
+
+uint32_t splash_attribute_list_size(const SplashSession *session, size_t model, uint32_t attribute,
+                                    SplashAttributeList list)
+{
+    if (!hasAttribute(session, model, attribute))
+        return 0;
+    const AttributeRecord &a = session->splash->models().attribute(model, attribute);
+    return list == SPLASH_ATTRIBUTE_ACCESSOR ? a.accessorCount : a.checkerArgumentCount;
+}
+
+SplashString splash_attribute_list_item(const SplashSession *session, size_t model, uint32_t attribute,
+                                        SplashAttributeList list, uint32_t i)
+{
+    if (i >= splash_attribute_list_size(session, model, attribute, list))
+        return {nullptr, 0};
+    const ModelTable &models = session->splash->models();
+    const AttributeRecord &a = models.attribute(model, attribute);
+    return view(models.listString((list == SPLASH_ATTRIBUTE_ACCESSOR ? a.firstAccessor : a.firstCheckerArgument) + i));
+}
@@ -0,0 +1,540 @@
+#include "splash_cli.h"
+
+#include <algorithm>
+#include <chrono>
+#include <csignal>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <thread>
+
+#include <cxxopts.hpp>
+
+#include "binary_ir.h"
+#include "compile_database.h"
+#include "file_watcher.h"
+#include "metacode_template.h"
+#include "model_index.h"
+#include "model_writer.h"
+#include "query_server.h"
+#include "ryven_emitter.h"
+#include "shared_pch.h"
+#include "source_discovery.h"
+#include "stats.h"
+#include "trace.h"
+#include "worker_pool.h"
+
+std::vector<std::string> SplashCli::readManifest(const std::string &manifestPath)
+{
+    std::ifstream ifs(manifestPath);
+    if (!ifs)
+        throw ManifestException(manifestPath, "cannot open the file");
+
+    // one input path per line, blank lines and '#' comments are ignored
+    std::vector<std::string> paths;
+    std::string line;
+    while (std::getline(ifs, line)) {
+        line.erase(0, line.find_first_not_of(" \t\r"));
+        line.erase(line.find_last_not_of(" \t\r") + 1);
+
+        if (line.empty() || line[0] == '#')
+            continue;
+
+        paths.push_back(line);
+    }
+
+    return paths;
+}
+
+int SplashCli::convert(int argc, char** argv)
+{
+    cxxopts::Options options("Splash convert", "Convert extracted models between JSON and binary IR.");
+    options.add_options()
+        ("input", "JSON or binary IR file to read.", cxxopts::value<std::string>())
+        ("output", "File to write, binary IR if it ends in .spir, JSON otherwise.", cxxopts::value<std::string>())
+        ("h,help", "Print usage");
+    options.parse_positional({"input", "output"});
+    options.positional_help("INPUT OUTPUT");
+
+    try {
+        auto result = options.parse(argc, argv);
+        if (result.count("help") || !result.count("input") || !result.count("output")) {
+            std::cout << options.help() << std::endl;
+            return result.count("help") ? 0 : 1;
+        }
+
+        const auto input = result["input"].as<std::string>();
+        const auto output = result["output"].as<std::string>();
+
+        ModelTable models;
+        Splash::loadModels(input, models);
+
+        if (BinaryIr::isBinaryIrPath(output)) {
+            BinaryIr::write(output, models);
+            ModelIndex::build(output, ModelIndex::indexPath(output));
+        } else {
+            ModelWriter writer(output, false);
+            for (std::size_t m = 0; m < models.size(); m++)
+                writer.write(models, m);
+            writer.close();
+        }
+
+        std::cout << "Converted " << models.size() << " model(s)." << std::endl;
+        return 0;
+    } catch (const cxxopts::option_not_exists_exception &e) {
+        std::cerr << "Error: "<< e.what() << std::endl;
+        return 1;
+    } catch (const BinaryIrException &e) {
+        std::cerr << "Error: " << e.path << ": " << e.reason << std::endl;
+        return 1;
+    } catch (const ModelWriterException &e) {
+        std::cerr << "Error: " << e.outputPath << ": " << e.reason << std::endl;
+        return 1;
+    } catch (const ModelIndexException &e) {
+        std::cerr << "Error: " << e.path << ": " << e.reason << std::endl;
+        return 1;
+    } catch (const std::exception &e) {
+        // unreadable or malformed JSON input
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+}
+
+int SplashCli::query(int argc, char** argv)
+{
+    cxxopts::Options options("Splash query", "Look up models in the index of a binary IR, or ask a splash serve.");
+    options.add_options()
+        ("input", "Binary IR file, indexed next to it on first use.", cxxopts::value<std::string>())
+        ("socket", "Ask the server listening on this socket instead of reading INPUT.", cxxopts::value<std::string>())
+        ("n,name", "Model with its effective attributes, inherited ones included.", cxxopts::value<std::string>())
+        ("prefix", "Names of the models starting with the given prefix.", cxxopts::value<std::string>())
+        ("type", "Names of the models with an attribute of the given value type.", cxxopts::value<std::string>())
+        ("children", "Names of the models whose parent is the given model.", cxxopts::value<std::string>())
+        ("h,help", "Print usage");
+    options.parse_positional({"input"});
+    options.positional_help("INPUT");
+
+    try {
+        auto result = options.parse(argc, argv);
+
+        std::string request;
+        unsigned lookups = 0;
+        for (const char *kind : {"name", "prefix", "type", "children"}) {
+            if (result.count(kind)) {
+                request = std::string(kind) + " " + result[kind].as<std::string>();
+                lookups++;
+            }
+        }
+        if (result.count("help") || lookups != 1 || (!result.count("input") && !result.count("socket"))) {
+            std::cout << options.help() << std::endl;
+            return result.count("help") ? 0 : 1;
+        }
+
+        std::string answer;
+        if (result.count("socket")) {
+            answer = QueryServer::ask(result["socket"].as<std::string>(), request);
+        } else {
+            const auto input = result["input"].as<std::string>();
+            if (!BinaryIr::isBinaryIr(input)) {
+                std::cerr << "Error: " << input << " is not a binary IR, convert it with splash convert." << std::endl;
+                return 1;
+            }
+            QueryServer::answer(ModelIndex(input), request, answer);
+        }
+
+        std::cout << answer << std::endl;
+        return answer.rfind("{\"error\"", 0) == 0 ? 1 : 0;
+    } catch (const cxxopts::option_not_exists_exception &e) {
+        std::cerr << "Error: "<< e.what() << std::endl;
+        return 1;
+    } catch (const BinaryIrException &e) {
+        std::cerr << "Error: " << e.path << ": " << e.reason << std::endl;
+        return 1;
+    } catch (const ModelIndexException &e) {
+        std::cerr << "Error: " << e.path << ": " << e.reason << std::endl;
+        return 1;
+    } catch (const QueryServerException &e) {
+        std::cerr << "Error: " << e.socketPath << ": " << e.reason << std::endl;
+        return 1;
+    } catch (const std::exception &e) {
+        // missing or malformed option values, file system errors
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+}
+
+// set by the SIGINT and SIGTERM handlers to stop serving
+static volatile std::sig_atomic_t s_stopServing = 0;
+
+int SplashCli::serve(int argc, char** argv)
+{
+    cxxopts::Options options("Splash serve", "Answer model lookups of splash query and Airflow on a local socket.");
+    options.add_options()
+        ("input", "Binary IR file, reloaded when it is rewritten.", cxxopts::value<std::string>())
+        ("socket", "Unix domain socket to listen on.", cxxopts::value<std::string>())
+        ("h,help", "Print usage");
+    options.parse_positional({"input"});
+    options.positional_help("INPUT");
+
+    try {
+        auto result = options.parse(argc, argv);
+        if (result.count("help") || !result.count("input") || !result.count("socket")) {
+            std::cout << options.help() << std::endl;
+            return result.count("help") ? 0 : 1;
+        }
+        if (!QueryServer::isSupported) {
+            std::cerr << "Error: splash serve needs Unix domain sockets, not supported on this platform." << std::endl;
+            return 1;
+        }
+
+        const auto input = result["input"].as<std::string>();
+        const auto socketPath = result["socket"].as<std::string>();
+        QueryServer server(input, socketPath);
+        std::cout << (server.index().rebuilt() ? "Indexed " : "Loaded the index of ") << server.index().modelCount()
+                  << " model(s), serving " << input << " on " << socketPath << "." << std::endl;
+
+        s_stopServing = 0;
+        std::signal(SIGINT, [](int) { s_stopServing = 1; });
+        std::signal(SIGTERM, [](int) { s_stopServing = 1; });
+        server.serve(s_stopServing);
+        std::signal(SIGINT, SIG_DFL);
+        std::signal(SIGTERM, SIG_DFL);
+
+        std::cout << "Answered " << server.requests() << " request(s), reloaded the index "
+                  << server.reloads() << " time(s)." << std::endl;
+        return 0;
+    } catch (const cxxopts::option_not_exists_exception &e) {
+        std::cerr << "Error: "<< e.what() << std::endl;
+        return 1;
+    } catch (const BinaryIrException &e) {
+        std::cerr << "Error: " << e.path << ": " << e.reason << std::endl;
+        return 1;
+    } catch (const ModelIndexException &e) {
+        std::cerr << "Error: " << e.path << ": " << e.reason << std::endl;
+        return 1;
+    } catch (const QueryServerException &e) {
+        std::cerr << "Error: " << e.socketPath << ": " << e.reason << std::endl;
+        return 1;
+    } catch (const std::exception &e) {
+        // missing or malformed option values, file system errors
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+}
+
+Splash* SplashCli::fromUserInput(int argc, char** argv, DiagnosticHandler diagnose)
+{
+    cxxopts::Options options("Splash", "Transpiler for IoD Sim and Airflow interoperability.");
+    options.add_options()
+        ("ast_file_path", "AST File Path(s) or source files of IoD Sim.", cxxopts::value<std::vector<std::string>>())
+        ("o,output", "File path to write JSON output. "
+                     "May be omitted only when every input is an AST file, the last positional argument is used then. "
+                     "A .gz or .zst extension compresses it, a .spir extension writes binary IR.",
+                     cxxopts::value<std::string>())
+        ("append", "Add the models to the JSON array already in the output file.")
+        ("m,manifest", "File listing AST File Paths or source files, one per line.", cxxopts::value<std::string>())
+        ("discover", "Directory searched for source files, walked with -j threads and following symbolic links.",
+                     cxxopts::value<std::vector<std::string>>())
+        ("include", "Glob of the discovered files, matching the file name or, with a '/', the path "
+                    "relative to the --discover directory. Defaults to *.cc.",
+                    cxxopts::value<std::vector<std::string>>())
+        ("exclude", "Glob of the files and directories left out of the discovery.",
+                    cxxopts::value<std::vector<std::string>>())
+        ("prefilter", "Discover only the files containing GetTypeId, without parsing the others.")
+        ("prescan", "Scan every source input for GetTypeId definitions first, parse only the ones defining "
+                    "some, and report the models expected by the scan but not extracted.")
+        ("p,compile-commands", "compile_commands.json, or its directory, providing the flags to parse "
+                               "source files. Without explicit inputs every entry is parsed.",
+                               cxxopts::value<std::string>())
+        ("extra-arg", "Additional argument to append to the compiler command line of every source file.",
+                      cxxopts::value<std::vector<std::string>>())
+        ("cache-dir", "Directory of the incremental extraction cache. "
+                      "Unchanged inputs are not parsed again.", cxxopts::value<std::string>())
+        ("rebuild", "Ignore the cached extractions and refresh the whole cache.")
+        ("full-traversal", "Visit the whole AST instead of only the subtrees that may hold models.")
+        ("resolve-parents", "Append the attributes inherited through SetParent to every model.")
+        ("pch", "Precompilation of the headers of source files: preamble (one per file), umbrella "
+                "(one PCH of the common headers shared by the files with the same flags) or none.",
+                cxxopts::value<std::string>()->default_value("preamble"))
+        ("stats", "JSON file receiving the time of every phase and input, the traversal counters, "
+                  "the peak RSS and the slowest inputs.", cxxopts::value<std::string>())
+        ("watch", "Keep running after the export and extract again the inputs whose source or headers change, "
+                  "refreshing the output and the Ryven nodes. Linux only.")
+        ("ryven-output", "Base directory of an Airflow (Ryven) nodes package to refresh after every export.",
+                         cxxopts::value<std::string>())
+        ("ryven-package", "Package name of the Ryven nodes.", cxxopts::value<std::string>()->default_value("iodsim"))
+        ("ryven-type-map", "Type map of the Ryven nodes, see emit-ryven --type-map.", cxxopts::value<std::string>())
+        ("isolate", "Extract every input in a pool of -j worker processes. An input crashing its worker "
+                    "is reported failed and the worker is replaced, without stopping the others.")
+        ("unit-timeout", "Seconds an input may take to extract before its worker process is killed "
+                         "and it is reported failed. Implies --isolate.", cxxopts::value<unsigned>())
+        ("j,jobs", "Number of AST files to process in parallel.", cxxopts::value<unsigned>()->default_value("1"))
+        ("d,debug", "Write debug trace events to stderr. Same as --trace-level=debug.")
+        ("trace-level", "Trace verbosity: off, info, debug or cursor.", cxxopts::value<std::string>())
+        ("trace-file", "File receiving the JSON lines trace instead of stderr.", cxxopts::value<std::string>())
+        ("v,version", "Show the version of the program.")
+        ("h,help", "Print help");
+    options.parse_positional({"ast_file_path"});
+    options.positional_help("<ast_file_path>... [output_file]");
+    options.show_positional_help();
+
+    try {
+        Stopwatch setup(Stopwatch::Clock::Process);
+        auto result = options.parse(argc, argv);
+
+        if (result.count("help")) {
+            std::cerr << options.help() << std::endl;
+            return nullptr;
+        }
+
+        if (result.count("version")) {
+            std::cout << Splash::VERSION << std::endl;
+        }
+
+        TraceLevel traceLevel = TraceLevel::Off;
+        if (result.count("debug")) {
+            traceLevel = TraceLevel::Debug;
+        }
+        if (result.count("trace-level") && !Trace::parseLevel(result["trace-level"].as<std::string>(), traceLevel)) {
+            throw CommandLineException("Error: unknown --trace-level " + result["trace-level"].as<std::string>() +
+                                       ", expected off, info, debug or cursor.");
+        }
+        if (traceLevel != TraceLevel::Off && !Trace::compiledIn) {
+            diagnose("Warning: tracing is not compiled in this build. "
+                     "Configure with -DSPLASH_ENABLE_TRACING=ON to enable it.");
+        }
+        Trace::configure(traceLevel, result.count("trace-file") ? result["trace-file"].as<std::string>() : "");
+
+        std::vector<std::string> inputPaths;
+        if (result.count("ast_file_path")) {
+            inputPaths = result["ast_file_path"].as<std::vector<std::string>>();
+        }
+
+        // legacy invocation: splash <ast_file_path>... <output_file>, only
+        // when every other input is an AST file, so that a source file is
+        // never taken for the output and overwritten
+        auto isAstPath = [](const std::string &path) {
+            const auto extension = std::filesystem::path(path).extension();
+            return extension == ".ast" || extension == ".pch";
+        };
+        const bool legacyOutput = !result.count("compile-commands") && !result.count("manifest") &&
+                                  !result.count("discover") && inputPaths.size() >= 2 &&
+                                  std::all_of(inputPaths.begin(), inputPaths.end() - 1, isAstPath) &&
+                                  !isAstPath(inputPaths.back());
+
+        std::string outputFilePath;
+        if (result.count("output")) {
+            outputFilePath = result["output"].as<std::string>();
+        } else if (legacyOutput) {
+            outputFilePath = inputPaths.back();
+            inputPaths.pop_back();
+        }
+
+        if (result.count("manifest")) {
+            try {
+                auto manifestPaths = readManifest(result["manifest"].as<std::string>());
+                inputPaths.insert(inputPaths.end(), manifestPaths.begin(), manifestPaths.end());
+            } catch (const ManifestException &e) {
+                throw CommandLineException("Cannot read manifest file " + e.path + ": " + e.reason + ".");
+            }
+        }
+
+        if (result.count("discover")) {
+            auto includes = result.count("include") ? result["include"].as<std::vector<std::string>>()
+                                                    : std::vector<std::string> {"*.cc"};
+            auto excludes = result.count("exclude") ? result["exclude"].as<std::vector<std::string>>()
+                                                    : std::vector<std::string> {};
+            SourceDiscovery discovery(includes, excludes, std::max(result["jobs"].as<unsigned>(), 1u));
+            if (result.count("prefilter"))
+                discovery.setRequiredText("GetTypeId");
+
+            for (auto& root : result["discover"].as<std::vector<std::string>>()) {
+                try {
+                    auto discovered = discovery.find(root);
+                    inputPaths.insert(inputPaths.end(), discovered.begin(), discovered.end());
+                } catch (const SourceDiscoveryException &e) {
+                    throw CommandLineException("Cannot discover source files in " + e.path + ": " + e.reason + ".");
+                }
+            }
+            std::string message = "Discovered " + std::to_string(discovery.scannedFiles() - discovery.filteredFiles()) +
+                                  " source file(s)";
+            if (result.count("prefilter"))
+                message += ", skipped " + std::to_string(discovery.filteredFiles()) + " without GetTypeId";
+            diagnose(message + ".");
+        }
+
+        std::vector<std::string> extraArguments;
+        if (result.count("extra-arg")) {
+            extraArguments = result["extra-arg"].as<std::vector<std::string>>();
+        }
+
+        std::unique_ptr<CompileDatabase> compileDatabase;
+        if (result.count("compile-commands")) {
+            try {
+                auto db = CompileDatabase::fromFile(result["compile-commands"].as<std::string>());
+                compileDatabase = std::make_unique<CompileDatabase>(db);
+            } catch (const CompileDatabaseException &e) {
+                throw CommandLineException("Cannot read compilation database " + e.databasePath + ": " + e.reason);
+            }
+        }
+
+        std::vector<TranslationUnitInput> inputs;
+        for (auto& path : inputPaths) {
+            inputs.push_back(Splash::inputFromPath(path, compileDatabase.get(), extraArguments, diagnose));
+        }
+        // an empty discovery must not fall back to the whole database
+        if (inputs.empty() && compileDatabase && !result.count("discover")) {
+            for (auto& cmd : compileDatabase->commands())
+                inputs.push_back(Splash::inputFromPath(cmd.file, compileDatabase.get(), extraArguments, diagnose));
+        }
+
+        if (inputs.empty()) {
+            throw CommandLineException("AST File Path hasn't been specified.");
+        }
+        if (outputFilePath.empty()) {
+            throw CommandLineException("Output File Path hasn't been specified, set it with -o.");
+        }
+        const auto normalizedOutput = CompileDatabase::normalizePath(outputFilePath);
+        for (auto& input : inputs) {
+            if (CompileDatabase::normalizePath(input.path) == normalizedOutput) {
+                throw CommandLineException("Error: the output " + outputFilePath +
+                                           " is also an input, refusing to overwrite it.");
+            }
+        }
+
+        SplashOptions settings;
+        settings.outputPath = outputFilePath;
+        settings.jobs = result["jobs"].as<unsigned>();
+        if (result.count("cache-dir"))
+            settings.cacheDirectory = result["cache-dir"].as<std::string>();
+        settings.rebuildCache = result.count("rebuild") > 0;
+        settings.pruneTraversal = result.count("full-traversal") == 0;
+        settings.resolveParents = result.count("resolve-parents") > 0;
+        settings.prescan = result.count("prescan") > 0;
+
+        settings.appendOutput = result.count("append") > 0;
+        if (settings.appendOutput && BinaryIr::isBinaryIrPath(outputFilePath)) {
+            throw CommandLineException("Error: --append needs a JSON output.");
+        }
+        if (!ModelWriter::isSupported(ModelWriter::compressionFromPath(outputFilePath))) {
+            throw CommandLineException("Error: this build of splash cannot compress " + outputFilePath +
+                                       ", rebuild it with zlib or zstd available.");
+        }
+
+        if (result.count("stats"))
+            settings.statsPath = result["stats"].as<std::string>();
+
+        if (!SharedPch::parseMode(result["pch"].as<std::string>(), settings.pchMode)) {
+            throw CommandLineException("Error: unknown --pch mode " + result["pch"].as<std::string>() + ".");
+        }
+
+        settings.watch = result.count("watch") > 0;
+        if (settings.watch && !FileWatcher::isSupported) {
+            throw CommandLineException("Error: --watch is only supported on Linux.");
+        }
+        if (settings.watch && settings.appendOutput) {
+            throw CommandLineException("Error: --watch rewrites the whole output, it cannot be used with --append.");
+        }
+        if (settings.watch && settings.pchMode == PchMode::Umbrella) {
+            // an edited common header would leave every unit with a stale PCH,
+            // while a reparse rebuilds its own preamble
+            diagnose("Warning: --watch reparses with per-file preambles, ignoring --pch umbrella.");
+            settings.pchMode = PchMode::Preamble;
+        }
+
+        if (result.count("unit-timeout"))
+            settings.unitTimeout = std::chrono::seconds(result["unit-timeout"].as<unsigned>());
+        settings.isolate = result.count("isolate") > 0 || settings.unitTimeout.count() > 0;
+        if (settings.isolate && !WorkerPool::isSupported) {
+            throw CommandLineException("Error: --isolate and --unit-timeout need worker processes, "
+                                       "not supported on this platform.");
+        }
+        if (settings.isolate && settings.watch) {
+            throw CommandLineException("Error: --watch keeps the translation units in memory, "
+                                       "it cannot be used with --isolate.");
+        }
+
+        if (result.count("ryven-output")) {
+            settings.ryvenOutput.directory = result["ryven-output"].as<std::string>();
+            settings.ryvenOutput.package = result["ryven-package"].as<std::string>();
+            if (result.count("ryven-type-map"))
+                settings.ryvenOutput.typeMap = result["ryven-type-map"].as<std::string>();
+        }
+
+        settings.diagnosticHandler = diagnose;
+        auto splash = new Splash(inputs, settings);
+        splash->recordPhase("setup", setup.elapsed());
+        return splash;
+    } catch (const cxxopts::option_not_exists_exception &e) {
+        throw CommandLineException(std::string("Error: ") + e.what());
+    }
+}
+
+int SplashCli::emitRyven(int argc, char** argv)
+{
+    cxxopts::Options options("Splash emit-ryven", "Generate the Airflow (Ryven) nodes package of extracted models.");
+    options.add_options()
+        ("input", "JSON or binary IR file to read.", cxxopts::value<std::string>())
+        ("output_directory", "Base directory of the package.", cxxopts::value<std::string>())
+        ("p,package", "Package name.", cxxopts::value<std::string>())
+        ("type-map", "File of \"<value type> <python conversion>\" lines overriding the built-in ns3 value conversions.",
+         cxxopts::value<std::string>())
+        ("template", "Node template to use instead of the built-in metacode_template.py.", cxxopts::value<std::string>())
+        ("j,jobs", "Number of threads writing nodes (0 uses every hardware thread).", cxxopts::value<unsigned>()->default_value("0"))
+        ("h,help", "Print usage");
+    options.parse_positional({"input", "output_directory"});
+    options.positional_help("INPUT OUTPUT_DIRECTORY");
+
+    try {
+        auto result = options.parse(argc, argv);
+        if (result.count("help") || !result.count("input") || !result.count("output_directory") ||
+            !result.count("package")) {
+            std::cout << options.help() << std::endl;
+            return result.count("help") ? 0 : 1;
+        }
+
+        std::string metacodeTemplate = METACODE_TEMPLATE;
+        if (result.count("template")) {
+            const auto templatePath = result["template"].as<std::string>();
+            std::ifstream ifs(templatePath);
+            if (!ifs) {
+                std::cerr << "Error: cannot open " << templatePath << std::endl;
+                return 1;
+            }
+            metacodeTemplate.assign(std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>());
+        }
+
+        unsigned jobs = result["jobs"].as<unsigned>();
+        if (jobs == 0)
+            jobs = std::max(1u, std::thread::hardware_concurrency());
+
+        ModelTable models;
+        Splash::loadModels(result["input"].as<std::string>(), models);
+
+        const auto outputDirectory = result["output_directory"].as<std::string>();
+        RyvenEmitter emitter(models, result["package"].as<std::string>(), outputDirectory, metacodeTemplate);
+        if (result.count("type-map"))
+            emitter.loadTypeMap(result["type-map"].as<std::string>());
+        emitter.emit(jobs);
+
+        std::cout << "Emitted " << emitter.nodes() << " node(s) into " << outputDirectory << ": "
+                  << emitter.writtenFiles() << " file(s) written, " << emitter.unchangedFiles() << " unchanged, "
+                  << emitter.removedNodes() << " stale node(s) removed." << std::endl;
+        return 0;
+    } catch (const cxxopts::option_not_exists_exception &e) {
+        std::cerr << "Error: "<< e.what() << std::endl;
+        return 1;
+    } catch (const BinaryIrException &e) {
+        std::cerr << "Error: " << e.path << ": " << e.reason << std::endl;
+        return 1;
+    } catch (const RyvenEmitterException &e) {
+        std::cerr << "Error: " << e.path << ": " << e.reason << std::endl;
+        return 1;
+    } catch (const std::exception &e) {
+        // unreadable or malformed JSON input, filesystem errors
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+}
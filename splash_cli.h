@@ -0,0 +1,51 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "diagnostic.h"
+#include "splash.h"
+
+// Invalid command line, message is what splash prints before exiting with 1
+class CommandLineException : std::exception
+{
+public:
+    CommandLineException(std::string message):
+        message {message}
+    {}
+
+    std::string message;
+};
+
+class ManifestException : std::exception
+{
+public:
+    ManifestException(std::string path, std::string reason):
+        path {path},
+        reason {reason}
+    {}
+
+    std::string path;
+    std::string reason;
+};
+
+// Command line of the splash executable, parsed outside of libsplash so that
+// the library never prints nor exits
+class SplashCli
+{
+public:
+    // The session of the splash command line, reporting to diagnose, or
+    // nullptr once --help is printed. Throws CommandLineException.
+    static Splash* fromUserInput(int argc, char** argv, DiagnosticHandler diagnose);
+    // "splash convert INPUT OUTPUT", returns the exit status
+    static int convert(int argc, char** argv);
+    // "splash emit-ryven INPUT OUTPUT_DIRECTORY -p PACKAGE", returns the exit status
+    static int emitRyven(int argc, char** argv);
+    // "splash query INPUT --name NAME", returns the exit status
+    static int query(int argc, char** argv);
+    // "splash serve INPUT --socket PATH", returns the exit status
+    static int serve(int argc, char** argv);
+
+private:
+    static std::vector<std::string> readManifest(const std::string &manifestPath);
+};
@@ -0,0 +1,144 @@
+"""Reader of splash binary IR files (.spir).
+
+The file is mapped by libsplash_ir and its records are read in place through
+ctypes: nothing is parsed, only the strings that are accessed are decoded.
+"""
+import ctypes
+import os
+from typing import List
+
+# BinaryIr::VERSION and BinaryIr::BYTE_ORDER_MARK
+VERSION = 3
+BYTE_ORDER_MARK = 0x01020304
+
+class IrString(ctypes.Structure):
+    _fields_ = [('offset', ctypes.c_uint32), ('size', ctypes.c_uint32)]
+
+class IrHeader(ctypes.Structure):
+    _fields_ = [('magic', ctypes.c_char * 8),
+                ('version', ctypes.c_uint32),
+                ('byte_order', ctypes.c_uint32),
+                ('model_count', ctypes.c_uint32),
+                ('attribute_count', ctypes.c_uint32),
+                ('list_count', ctypes.c_uint32),
+                ('reserved', ctypes.c_uint32),
+                ('models_offset', ctypes.c_uint64),
+                ('attributes_offset', ctypes.c_uint64),
+                ('lists_offset', ctypes.c_uint64),
+                ('strings_offset', ctypes.c_uint64),
+                ('strings_size', ctypes.c_uint64)]
+
+class IrModel(ctypes.Structure):
+    _fields_ = [('name', IrString),
+                ('parent', IrString),
+                ('first_attribute', ctypes.c_uint32),
+                ('attribute_count', ctypes.c_uint32),
+                ('qualified_name', IrString)]
+
+class IrAttribute(ctypes.Structure):
+    _fields_ = [('name', IrString),
+                ('description', IrString),
+                ('type', IrString),
+                ('initial_value', IrString),
+                ('checker', IrString),
+                ('flags', IrString),
+                ('first_accessor', ctypes.c_uint32),
+                ('accessor_count', ctypes.c_uint32),
+                ('first_checker_argument', ctypes.c_uint32),
+                ('checker_argument_count', ctypes.c_uint32)]
+
+def _load_library() -> ctypes.CDLL:
+    # SPLASH_IR_LIBRARY, then next to this script and in its build directory
+    candidates = [os.environ.get('SPLASH_IR_LIBRARY')]
+    here = os.path.dirname(os.path.abspath(__file__))
+    for d in [here, os.path.join(here, 'build')]:
+        candidates += [os.path.join(d, 'libsplash_ir.so'),
+                       os.path.join(d, 'libsplash_ir.dylib'),
+                       os.path.join(d, 'splash_ir.dll')]
+
+    for c in candidates:
+        if c and os.path.exists(c):
+            lib = ctypes.CDLL(c)
+            break
+    else:
+        raise OSError('Cannot find libsplash_ir, set SPLASH_IR_LIBRARY to its path.')
+
+    lib.splash_ir_open.argtypes = [ctypes.c_char_p]
+    lib.splash_ir_open.restype = ctypes.c_void_p
+    lib.splash_ir_close.argtypes = [ctypes.c_void_p]
+    lib.splash_ir_close.restype = None
+    lib.splash_ir_data.argtypes = [ctypes.c_void_p]
+    lib.splash_ir_data.restype = ctypes.c_void_p
+    lib.splash_ir_size.argtypes = [ctypes.c_void_p]
+    lib.splash_ir_size.restype = ctypes.c_size_t
+    return lib
+
+_lib = None
+
+class BinaryIr:
+    def __init__(self, path: str):
+        global _lib
+        if _lib is None:
+            _lib = _load_library()
+
+        self._ir = _lib.splash_ir_open(path.encode())
+        if not self._ir:
+            raise ValueError(f'{path} is not a valid splash binary IR.')
+
+        base = _lib.splash_ir_data(self._ir)
+        header = IrHeader.from_address(base)
+        # the records are read in host order, like libsplash_ir reads them
+        if header.version != VERSION or header.byte_order != BYTE_ORDER_MARK:
+            self.close()
+            raise ValueError(f'{path} is a binary IR of another version or byte order.')
+        self.models = (IrModel * header.model_count).from_address(base + header.models_offset)
+        self.attributes = (IrAttribute * header.attribute_count).from_address(base + header.attributes_offset)
+        self.lists = (IrString * header.list_count).from_address(base + header.lists_offset)
+        self._strings = base + header.strings_offset
+
+    def close(self):
+        if self._ir:
+            _lib.splash_ir_close(self._ir)
+            self._ir = None
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, *args):
+        self.close()
+
+    def string(self, s: IrString) -> str:
+        return ctypes.string_at(self._strings + s.offset, s.size).decode()
+
+    def to_json(self) -> List:
+        """Models as the JSON export represents them."""
+        models = []
+        for m in self.models:
+            model = {}
+            if m.parent.size > 0:
+                model['parent'] = self.string(m.parent)
+            model['name'] = self.string(m.name)
+            model['attributes'] = []
+
+            for a in self.attributes[m.first_attribute:m.first_attribute + m.attribute_count]:
+                attribute = {
+                    'name': self.string(a.name),
+                    'description': self.string(a.description),
+                    'type': self.string(a.type),
+                    'initialValue': self.string(a.initial_value),
+                    'accessor': [self.string(s) for s in self.lists[a.first_accessor:a.first_accessor + a.accessor_count]],
+                    'checker': self.string(a.checker),
+                    'checkerArguments': [self.string(s) for s in
+                                         self.lists[a.first_checker_argument:a.first_checker_argument + a.checker_argument_count]],
+                }
+                if a.flags.size > 0:
+                    attribute['flags'] = self.string(a.flags)
+                model['attributes'].append(attribute)
+
+            models.append(model)
+
+        return models
+
+def load(path: str) -> List:
+    with BinaryIr(path) as ir:
+        return ir.to_json()
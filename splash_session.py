@@ -0,0 +1,179 @@
+"""In-process extraction of ns-3 models through libsplash.
+
+A Session runs splash inside the Python process and reads the models from
+its string pool through ctypes, without spawning the executable, writing an
+output file or parsing JSON:
+
+    with Session() as s:
+        s.load_compile_commands('build/compile_commands.json')
+        s.add_input('src/foo/model/foo.cc')
+        s.run()
+        models = s.models()
+"""
+import ctypes
+import os
+from typing import Dict, List, Optional, Sequence
+
+class SplashString(ctypes.Structure):
+    _fields_ = [('data', ctypes.c_void_p), ('size', ctypes.c_size_t)]
+
+# SplashAttributeField and SplashAttributeList of libsplash.h
+_FIELDS = [('name', 0), ('description', 1), ('type', 2), ('initialValue', 3)]
+_CHECKER = 4
+_FLAGS = 5
+_ACCESSOR = 0
+_CHECKER_ARGUMENTS = 1
+
+def _load_library() -> ctypes.CDLL:
+    # SPLASH_LIBRARY, then next to this script and in its build directory
+    candidates = [os.environ.get('SPLASH_LIBRARY')]
+    here = os.path.dirname(os.path.abspath(__file__))
+    for d in [here, os.path.join(here, 'build')]:
+        candidates += [os.path.join(d, 'libsplash.so'),
+                       os.path.join(d, 'libsplash.dylib'),
+                       os.path.join(d, 'libsplash.dll')]
+
+    for c in candidates:
+        if c and os.path.exists(c):
+            lib = ctypes.CDLL(c)
+            break
+    else:
+        raise OSError('Cannot find libsplash, set SPLASH_LIBRARY to its path.')
+
+    session = ctypes.c_void_p
+    signatures = {
+        'splash_session_create': ([], session),
+        'splash_session_destroy': ([session], None),
+        'splash_session_error': ([session], ctypes.c_char_p),
+        'splash_session_diagnostic_count': ([session], ctypes.c_size_t),
+        'splash_session_diagnostic': ([session, ctypes.c_size_t], ctypes.c_char_p),
+        'splash_session_clear_diagnostics': ([session], None),
+        'splash_session_load_compile_commands': ([session, ctypes.c_char_p], ctypes.c_int),
+        'splash_session_add_extra_argument': ([session, ctypes.c_char_p], None),
+        'splash_session_add_input': ([session, ctypes.c_char_p], ctypes.c_int),
+        'splash_session_add_source': ([session, ctypes.c_char_p, ctypes.POINTER(ctypes.c_char_p), ctypes.c_size_t],
+                                      ctypes.c_int),
+        'splash_session_set_jobs': ([session, ctypes.c_uint], None),
+        'splash_session_set_resolve_parents': ([session, ctypes.c_int], None),
+        'splash_session_set_prescan': ([session, ctypes.c_int], None),
+        'splash_session_set_cache': ([session, ctypes.c_char_p], None),
+        'splash_session_set_output': ([session, ctypes.c_char_p], None),
+        'splash_session_run': ([session], ctypes.c_int),
+        'splash_session_export': ([session], ctypes.c_int),
+        'splash_model_count': ([session], ctypes.c_size_t),
+        'splash_model_name': ([session, ctypes.c_size_t], SplashString),
+        'splash_model_parent': ([session, ctypes.c_size_t], SplashString),
+        'splash_attribute_count': ([session, ctypes.c_size_t], ctypes.c_uint32),
+        'splash_attribute_field': ([session, ctypes.c_size_t, ctypes.c_uint32, ctypes.c_int], SplashString),
+        'splash_attribute_list_size': ([session, ctypes.c_size_t, ctypes.c_uint32, ctypes.c_int], ctypes.c_uint32),
+        'splash_attribute_list_item': ([session, ctypes.c_size_t, ctypes.c_uint32, ctypes.c_int, ctypes.c_uint32],
+                                       SplashString),
+    }
+    for name, (argtypes, restype) in signatures.items():
+        f = getattr(lib, name)
+        f.argtypes = argtypes
+        f.restype = restype
+    return lib
+
+_lib = None
+
+def _string(s: SplashString) -> str:
+    return ctypes.string_at(s.data, s.size).decode() if s.size > 0 else ''
+
+class SplashError(RuntimeError):
+    pass
+
+class Session:
+    def __init__(self, jobs: int = 1, resolve_parents: bool = False, prescan: bool = False,
+                 cache_dir: Optional[str] = None, output: Optional[str] = None):
+        global _lib
+        if _lib is None:
+            _lib = _load_library()
+
+        self._session = _lib.splash_session_create()
+        if not self._session:
+            raise MemoryError('Cannot create a splash session.')
+        _lib.splash_session_set_jobs(self._session, jobs)
+        _lib.splash_session_set_resolve_parents(self._session, int(resolve_parents))
+        _lib.splash_session_set_prescan(self._session, int(prescan))
+        if cache_dir:
+            _lib.splash_session_set_cache(self._session, cache_dir.encode())
+        if output:
+            _lib.splash_session_set_output(self._session, output.encode())
+
+    def close(self):
+        if self._session:
+            _lib.splash_session_destroy(self._session)
+            self._session = None
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, *args):
+        self.close()
+
+    def _check(self, status: int):
+        if status != 0:
+            raise SplashError(_lib.splash_session_error(self._session).decode())
+
+    def load_compile_commands(self, path: str):
+        """Flags of the inputs added afterwards."""
+        self._check(_lib.splash_session_load_compile_commands(self._session, path.encode()))
+
+    def add_extra_argument(self, argument: str):
+        _lib.splash_session_add_extra_argument(self._session, argument.encode())
+
+    def add_input(self, path: str):
+        """An AST file, or a source file with its compile command and the extra arguments."""
+        self._check(_lib.splash_session_add_input(self._session, path.encode()))
+
+    def add_source(self, path: str, arguments: Sequence[str]):
+        """A source file parsed with exactly these arguments."""
+        args = (ctypes.c_char_p * len(arguments))(*[a.encode() for a in arguments])
+        self._check(_lib.splash_session_add_source(self._session, path.encode(), args, len(arguments)))
+
+    def run(self):
+        self._check(_lib.splash_session_run(self._session))
+
+    def export(self):
+        """Writes the models to the output of the session, as splash does."""
+        self._check(_lib.splash_session_export(self._session))
+
+    def diagnostics(self, clear: bool = False) -> List[str]:
+        """Warnings, progress messages and compiler diagnostics reported so far, which splash prints."""
+        s = self._session
+        messages = [_lib.splash_session_diagnostic(s, i).decode()
+                    for i in range(_lib.splash_session_diagnostic_count(s))]
+        if clear:
+            _lib.splash_session_clear_diagnostics(s)
+        return messages
+
+    def models(self) -> List[Dict]:
+        """Models of the last run as the JSON export represents them."""
+        s = self._session
+        models = []
+        for m in range(_lib.splash_model_count(s)):
+            model = {}
+            parent = _lib.splash_model_parent(s, m)
+            if parent.size > 0:
+                model['parent'] = _string(parent)
+            model['name'] = _string(_lib.splash_model_name(s, m))
+            model['attributes'] = []
+
+            for a in range(_lib.splash_attribute_count(s, m)):
+                def lst(kind):
+                    return [_string(_lib.splash_attribute_list_item(s, m, a, kind, i))
+                            for i in range(_lib.splash_attribute_list_size(s, m, a, kind))]
+
+                attribute = {key: _string(_lib.splash_attribute_field(s, m, a, field)) for key, field in _FIELDS}
+                attribute['accessor'] = lst(_ACCESSOR)
+                attribute['checker'] = _string(_lib.splash_attribute_field(s, m, a, _CHECKER))
+                attribute['checkerArguments'] = lst(_CHECKER_ARGUMENTS)
+                flags = _lib.splash_attribute_field(s, m, a, _FLAGS)
+                if flags.size > 0:
+                    attribute['flags'] = _string(flags)
+                model['attributes'].append(attribute)
+
+            models.append(model)
+
+        return models
@@ -0,0 +1,221 @@
+#include "stats.h"
+
+#include <algorithm>
+#include <ctime>
+#include <fstream>
+
+#include <boost/json.hpp>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+TraversalCounters& TraversalCounters::operator+=(const TraversalCounters &other)
+{
+    visited += other.visited;
+    pruned += other.pruned;
+    predicateCalls += other.predicateCalls;
+    typeIdMatches += other.typeIdMatches;
+    duplicateModels += other.duplicateModels;
+    attributes += other.attributes;
+    sourceBytes += other.sourceBytes;
+    return *this;
+}
+
+PhaseTime& PhaseTime::operator+=(const PhaseTime &other)
+{
+    wall += other.wall;
+    cpu += other.cpu;
+    return *this;
+}
+
+Stopwatch::Stopwatch(Clock clock) :
+    m_clock {clock},
+    m_wallStart {std::chrono::steady_clock::now()},
+    m_cpuStart {cpuTime(clock)}
+{}
+
+PhaseTime Stopwatch::elapsed() const
+{
+    const std::chrono::duration<double> wall = std::chrono::steady_clock::now() - m_wallStart;
+    return {wall.count(), cpuTime(m_clock) - m_cpuStart};
+}
+
+double Stopwatch::cpuTime(Clock clock)
+{
+#ifdef _WIN32
+    FILETIME creation, exit, kernel, user;
+    const BOOL ok = clock == Clock::Thread
+        ? GetThreadTimes(GetCurrentThread(), &creation, &exit, &kernel, &user)
+        : GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user);
+    if (!ok)
+        return 0;
+
+    auto seconds = [](const FILETIME &t) {
+        return ((static_cast<unsigned long long>(t.dwHighDateTime) << 32) | t.dwLowDateTime) * 1e-7;
+    };
+    return seconds(kernel) + seconds(user);
+#else
+    timespec t;
+    if (clock_gettime(clock == Clock::Thread ? CLOCK_THREAD_CPUTIME_ID : CLOCK_PROCESS_CPUTIME_ID, &t) != 0)
+        return 0;
+    return t.tv_sec + t.tv_nsec * 1e-9;
+#endif
+}
+
+void RunStats::recordPhase(const std::string &name, PhaseTime time)
+{
+    m_phases.emplace_back(name, time);
+}
+
+static boost::json::object phaseToJson(const PhaseTime &time, bool cpuMeasured = true)
+{
+    boost::json::object obj;
+    obj["wall"] = time.wall;
+    if (cpuMeasured)
+        obj["cpu"] = time.cpu;
+    else
+        obj["cpu"] = nullptr;
+    return obj;
+}
+
+static void countersToJson(const TraversalCounters &counters, boost::json::object &obj)
+{
+    obj["visitedCursors"] = counters.visited;
+    obj["prunedSubtrees"] = counters.pruned;
+    obj["predicateCalls"] = counters.predicateCalls;
+    obj["typeIdMatches"] = counters.typeIdMatches;
+    obj["duplicateModels"] = counters.duplicateModels;
+    obj["attributes"] = counters.attributes;
+    obj["sourceBytes"] = counters.sourceBytes;
+}
+
+static boost::json::object unitToJson(const UnitStats &unit, bool loadCpuMeasured)
+{
+    boost::json::object obj;
+    obj["path"] = unit.path;
+    obj["cached"] = unit.cached;
+    obj["skipped"] = unit.skipped;
+    if (unit.failed)
+        obj["failure"] = unit.failure;
+    obj["scan"] = phaseToJson(unit.scan);
+    obj["expectedModels"] = unit.expectedModels;
+    obj["cache"] = phaseToJson(unit.cache);
+    obj["load"] = phaseToJson(unit.load, loadCpuMeasured);
+    obj["traversal"] = phaseToJson(unit.traversal);
+    obj["models"] = unit.models;
+    countersToJson(unit.counters, obj);
+    return obj;
+}
+
+void RunStats::write(const std::string &path) const
+{
+    boost::json::object phases;
+    for (auto& [name, time] : m_phases)
+        phases[name] = phaseToJson(time);
+
+    // aggregated over every input
+    UnitStats total;
+    std::size_t cachedUnits = 0;
+    std::size_t skippedUnits = 0;
+    std::size_t failedUnits = 0;
+    boost::json::array unitsJson;
+    for (auto& unit : units) {
+        total.scan += unit.scan;
+        total.cache += unit.cache;
+        total.load += unit.load;
+        total.traversal += unit.traversal;
+        total.models += unit.models;
+        total.counters += unit.counters;
+        cachedUnits += unit.cached;
+        skippedUnits += unit.skipped;
+        failedUnits += unit.failed;
+        unitsJson.push_back(unitToJson(unit, loadCpuMeasured()));
+    }
+
+    boost::json::object totals;
+    totals["scan"] = phaseToJson(total.scan);
+    totals["cache"] = phaseToJson(total.cache);
+    totals["load"] = phaseToJson(total.load, loadCpuMeasured());
+    totals["traversal"] = phaseToJson(total.traversal);
+    totals["models"] = total.models;
+    countersToJson(total.counters, totals);
+
+    // units taking the longest to load and traverse
+    std::vector<const UnitStats *> slowest;
+    for (auto& unit : units)
+        slowest.push_back(&unit);
+    const std::size_t numSlowest = std::min(SLOWEST_UNITS, slowest.size());
+    std::partial_sort(slowest.begin(), slowest.begin() + numSlowest, slowest.end(),
+                      [](const UnitStats *a, const UnitStats *b) {
+        return a->load.wall + a->traversal.wall > b->load.wall + b->traversal.wall;
+    });
+
+    boost::json::array slowestJson;
+    for (std::size_t i = 0; i < numSlowest; i++) {
+        boost::json::object obj;
+        obj["path"] = slowest[i]->path;
+        obj["wall"] = slowest[i]->load.wall + slowest[i]->traversal.wall;
+        slowestJson.push_back(obj);
+    }
+
+    boost::json::object stats;
+    stats["jobs"] = jobs;
+    stats["inputs"] = units.size();
+    stats["cachedInputs"] = cachedUnits;
+    stats["skippedInputs"] = skippedUnits;
+    stats["failedInputs"] = failedUnits;
+    stats["peakRssBytes"] = peakResidentBytes();
+    stats["peakWorkerRssBytes"] = peakWorkerResidentBytes();
+    stats["phases"] = phases;
+    stats["totals"] = totals;
+    stats["slowestUnits"] = slowestJson;
+    stats["units"] = unitsJson;
+
+    std::ofstream ofs(path);
+    ofs << boost::json::serialize(stats) << std::endl;
+    if (!ofs)
+        throw StatsException(path, "write failed");
+}
+
+#ifndef _WIN32
+static std::size_t maxResidentBytes(int who)
+{
+    rusage usage;
+    if (getrusage(who, &usage) != 0)
+        return 0;
+#ifdef __APPLE__
+    return usage.ru_maxrss;
+#else
+    // kilobytes on Linux
+    return static_cast<std::size_t>(usage.ru_maxrss) * 1024;
+#endif
+}
+#endif
+
+std::size_t RunStats::peakResidentBytes()
+{
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+        return 0;
+    return counters.PeakWorkingSetSize;
+#else
+    return maxResidentBytes(RUSAGE_SELF);
+#endif
+}
+
+std::size_t RunStats::peakWorkerResidentBytes()
+{
+#ifdef _WIN32
+    // no worker processes there
+    return 0;
+#else
+    // the largest of the terminated and waited for children, which are the
+    // --isolate workers, all stopped by the end of the extraction
+    return maxResidentBytes(RUSAGE_CHILDREN);
+#endif
+}
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <exception>
+#include <string>
+#include <utility>
+#include <vector>
+
+class StatsException : std::exception
+{
+public:
+    StatsException(std::string path, std::string reason):
+        path {path},
+        reason {reason}
+    {}
+
+    std::string path;
+    std::string reason;
+};
+
+// Work done while traversing one translation unit.
+class TraversalCounters {
+public:
+    TraversalCounters() {}
+
+    TraversalCounters& operator+=(const TraversalCounters &other);
+
+    std::size_t visited {0};
+    std::size_t pruned {0};
+    std::size_t predicateCalls {0};
+    std::size_t typeIdMatches {0};
+    // GetTypeId subtrees skipped, their model being extracted by another unit
+    std::size_t duplicateModels {0};
+    std::size_t attributes {0};
+    // source text sliced out of the file buffers for attribute values
+    std::size_t sourceBytes {0};
+};
+
+// Wall and CPU time of a phase, in seconds.
+class PhaseTime {
+public:
+    PhaseTime() {}
+    PhaseTime(double w, double c) : wall {w}, cpu {c} {}
+
+    PhaseTime& operator+=(const PhaseTime &other);
+
+    double wall {0};
+    double cpu {0};
+};
+
+// Measures the wall and CPU time of a phase from its construction.
+class Stopwatch {
+public:
+    enum class Clock { Thread, Process };
+
+    Stopwatch(Clock clock);
+
+    PhaseTime elapsed() const;
+
+private:
+    static double cpuTime(Clock clock);
+
+    Clock m_clock;
+    std::chrono::steady_clock::time_point m_wallStart;
+    double m_cpuStart;
+};
+
+class UnitStats {
+public:
+    UnitStats() {}
+
+    std::string path;
+    bool cached {false};
+    // left out by --prescan, without any GetTypeId definition
+    bool skipped {false};
+    // crashed or timed out in an --isolate worker process
+    bool failed {false};
+    std::string failure;
+    PhaseTime scan;
+    std::size_t expectedModels {0};
+    // cache lookup and store, including the hashing of the inputs
+    PhaseTime cache;
+    PhaseTime load;
+    PhaseTime traversal;
+    std::size_t models {0};
+    TraversalCounters counters;
+};
+
+// Timings and counters of a splash run, written as a JSON sidecar by --stats.
+class RunStats {
+public:
+    static constexpr std::size_t SLOWEST_UNITS = 10;
+
+    RunStats() {}
+
+    void recordPhase(const std::string &name, PhaseTime time);
+
+    // Clock of the per input phases. A worker process extracts one input at
+    // a time, and so does a single worker thread.
+    Stopwatch::Clock unitClock() const
+    {
+        return jobs > 1 && !isolated ? Stopwatch::Clock::Thread : Stopwatch::Clock::Process;
+    }
+    // libclang parses on a thread of its own, which the clock of a worker
+    // thread misses: the CPU time of loads is then written as null
+    bool loadCpuMeasured() const { return unitClock() == Stopwatch::Clock::Process; }
+
+    // One entry per input, each filled by the worker extracting it
+    std::vector<UnitStats> units;
+    unsigned jobs {1};
+    // extracted by --isolate worker processes
+    bool isolated {false};
+
+    void write(const std::string &path) const;
+
+    // Peak resident set size of the process
+    static std::size_t peakResidentBytes();
+    // Peak resident set size of the largest --isolate worker process, which
+    // does the parsing there, zero without workers
+    static std::size_t peakWorkerResidentBytes();
+
+private:
+    std::vector<std::pair<std::string, PhaseTime>> m_phases;
+};
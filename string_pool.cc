@@ -0,0 +1,42 @@
+#include "string_pool.h"
+
+#include <algorithm>
+#include <cstring>
+
+StringPool::StringPool()
+{
+    m_strings.push_back({});
+    m_ids.emplace(std::string_view(), EMPTY);
+}
+
+StringId StringPool::intern(std::string_view str)
+{
+    auto it = m_ids.find(str);
+    if (it != m_ids.end())
+        return it->second;
+
+    const auto id = static_cast<StringId>(m_strings.size());
+    std::string_view stored = store(str);
+    m_strings.push_back(stored);
+    m_ids.emplace(stored, id);
+    return id;
+}
+
+std::string_view StringPool::store(std::string_view str)
+{
+    // strings larger than a chunk get one of their own
+    if (str.size() > m_chunkFree) {
+        const std::size_t size = std::max(CHUNK_SIZE, str.size());
+        m_chunks.push_back(std::make_unique<char[]>(size));
+        m_chunkEnd = m_chunks.back().get();
+        m_chunkFree = size;
+    }
+
+    char *data = m_chunkEnd;
+    std::memcpy(data, str.data(), str.size());
+    m_chunkEnd += str.size();
+    m_chunkFree -= str.size();
+    m_bytes += str.size();
+
+    return {data, str.size()};
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+using StringId = std::uint32_t;
+
+// Interned strings stored once in large arena chunks. Ids are dense, the
+// empty string is always id 0, and views stay valid for the pool lifetime.
+class StringPool
+{
+public:
+    static constexpr StringId EMPTY = 0;
+
+    StringPool();
+
+    StringId intern(std::string_view str);
+    std::string_view get(StringId id) const { return m_strings[id]; }
+
+    std::size_t size() const { return m_strings.size(); }
+    std::size_t bytes() const { return m_bytes; }
+
+private:
+    std::string_view store(std::string_view str);
+
+    static constexpr std::size_t CHUNK_SIZE = 1 << 16;
+
+    std::vector<std::unique_ptr<char[]>> m_chunks;
+    std::size_t m_chunkFree {0};
+    char *m_chunkEnd {nullptr};
+    std::size_t m_bytes {0};
+    std::vector<std::string_view> m_strings;
+    std::unordered_map<std::string_view, StringId> m_ids;
+};
@@ -0,0 +1,41 @@
+# --cache-dir reuses the inputs whose files are unchanged, even when touched,
+# parses again the inputs including an edited header and keeps an entry per
+# set of flags of an input
+include(${CMAKE_CURRENT_LIST_DIR}/common.cmake)
+
+generate_corpus(${WORK_DIRECTORY}/corpus -f 3 -n 2 -m 2 -d 1)
+set(database ${WORK_DIRECTORY}/corpus/compile_commands.json)
+set(cache ${WORK_DIRECTORY}/cache)
+set(header ${WORK_DIRECTORY}/corpus/include/ns3/synthetic-1-model.h)
+file(REMOVE_RECURSE ${cache})
+
+# Runs splash with the cache and checks how many inputs it reused, ARGN are
+# more splash options
+function(expect_reused reused output)
+  run_splash(-p ${database} --cache-dir ${cache} -o ${output} ${ARGN})
+  if (NOT SPLASH_OUTPUT MATCHES "Reused ${reused} of 3 unit")
+    message(FATAL_ERROR "expected ${reused} cached input(s):\n${SPLASH_OUTPUT}")
+  endif (NOT SPLASH_OUTPUT MATCHES "Reused ${reused} of 3 unit")
+endfunction(expect_reused)
+
+# a file modified less than a timestamp tick before the parse is not cached
+execute_process(COMMAND ${CMAKE_COMMAND} -E sleep 0.1)
+expect_reused(0 ${WORK_DIRECTORY}/parsed.json)
+expect_reused(3 ${WORK_DIRECTORY}/cached.json)
+expect_same_files(${WORK_DIRECTORY}/parsed.json ${WORK_DIRECTORY}/cached.json)
+
+file(TOUCH ${header})
+expect_reused(3 ${WORK_DIRECTORY}/touched.json)
+expect_same_files(${WORK_DIRECTORY}/parsed.json ${WORK_DIRECTORY}/touched.json)
+
+file(APPEND ${header} "// edited\n")
+execute_process(COMMAND ${CMAKE_COMMAND} -E sleep 0.1)
+expect_reused(2 ${WORK_DIRECTORY}/edited.json)
+expect_same_files(${WORK_DIRECTORY}/parsed.json ${WORK_DIRECTORY}/edited.json)
+expect_reused(3 ${WORK_DIRECTORY}/recached.json)
+
+# the entries of other flags live next to the previous ones
+expect_reused(0 ${WORK_DIRECTORY}/defined.json --extra-arg -DSPLASH_CACHE_TEST)
+expect_reused(3 ${WORK_DIRECTORY}/undefined.json)
+expect_reused(3 ${WORK_DIRECTORY}/redefined.json --extra-arg -DSPLASH_CACHE_TEST)
+expect_same_files(${WORK_DIRECTORY}/parsed.json ${WORK_DIRECTORY}/redefined.json)
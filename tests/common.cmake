@@ -0,0 +1,60 @@
+# Helpers of the end to end tests, run by ctest with cmake -P. Every test
+# receives the paths of SPLASH, SPLASH_CORPUS and its WORK_DIRECTORY, and
+# SPLASH_TEST_ARGUMENTS appended to every splash command line parsing sources.
+
+separate_arguments(splashTestArguments UNIX_COMMAND "${SPLASH_TEST_ARGUMENTS}")
+
+# Writes a synthetic corpus into directory, ARGN are splash_corpus options
+function(generate_corpus directory)
+  file(REMOVE_RECURSE ${directory})
+  execute_process(COMMAND ${SPLASH_CORPUS} ${directory} ${ARGN}
+                  RESULT_VARIABLE result OUTPUT_VARIABLE output ERROR_VARIABLE output)
+  if (NOT result EQUAL 0)
+    message(FATAL_ERROR "splash_corpus ${directory} ${ARGN} failed:\n${output}")
+  endif (NOT result EQUAL 0)
+endfunction(generate_corpus)
+
+# Runs splash with ARGN, its output is left in SPLASH_OUTPUT
+function(run_splash)
+  execute_process(COMMAND ${SPLASH} ${ARGN} ${splashTestArguments}
+                  RESULT_VARIABLE result OUTPUT_VARIABLE output ERROR_VARIABLE output)
+  if (NOT result EQUAL 0)
+    message(FATAL_ERROR "splash ${ARGN} failed:\n${output}")
+  endif (NOT result EQUAL 0)
+  set(SPLASH_OUTPUT "${output}" PARENT_SCOPE)
+endfunction(run_splash)
+
+# Runs a splash command that parses nothing, such as convert or query,
+# without SPLASH_TEST_ARGUMENTS. Its standard output is left in
+# SPLASH_OUTPUT and its exit code in SPLASH_RESULT.
+function(run_splash_command)
+  execute_process(COMMAND ${SPLASH} ${ARGN}
+                  RESULT_VARIABLE result OUTPUT_VARIABLE output ERROR_VARIABLE error
+                  OUTPUT_STRIP_TRAILING_WHITESPACE)
+  if (NOT result MATCHES "^[0-9]+$")
+    message(FATAL_ERROR "splash ${ARGN} did not run: ${result}\n${error}")
+  endif (NOT result MATCHES "^[0-9]+$")
+  set(SPLASH_OUTPUT "${output}" PARENT_SCOPE)
+  set(SPLASH_RESULT "${result}" PARENT_SCOPE)
+endfunction(run_splash_command)
+
+function(expect_same_files expected actual)
+  execute_process(COMMAND ${CMAKE_COMMAND} -E compare_files ${expected} ${actual} RESULT_VARIABLE result)
+  if (NOT result EQUAL 0)
+    message(FATAL_ERROR "${actual} differs from ${expected}")
+  endif (NOT result EQUAL 0)
+endfunction(expect_same_files)
+
+function(expect_match path regex)
+  file(READ ${path} contents)
+  if (NOT contents MATCHES "${regex}")
+    message(FATAL_ERROR "${path} does not match ${regex}:\n${contents}")
+  endif (NOT contents MATCHES "${regex}")
+endfunction(expect_match)
+
+function(expect_no_match path regex)
+  file(READ ${path} contents)
+  if (contents MATCHES "${regex}")
+    message(FATAL_ERROR "${path} matches ${regex}:\n${contents}")
+  endif (contents MATCHES "${regex}")
+endfunction(expect_no_match)
@@ -0,0 +1,38 @@
+# splash emit-ryven writes a node per model with the value conversions of
+# its attributes, rewrites only the changed files and removes stale nodes
+include(${CMAKE_CURRENT_LIST_DIR}/common.cmake)
+
+generate_corpus(${WORK_DIRECTORY}/corpus -f 2 -n 2 -m 3)
+run_splash(-p ${WORK_DIRECTORY}/corpus/compile_commands.json -o ${WORK_DIRECTORY}/models.json)
+run_splash(${WORK_DIRECTORY}/corpus/src/synthetic-0-model.cc --extra-arg=-I${WORK_DIRECTORY}/corpus/include
+           -o ${WORK_DIRECTORY}/fewer.json)
+set(package ${WORK_DIRECTORY}/packages/iodsim)
+file(REMOVE_RECURSE ${WORK_DIRECTORY}/packages)
+
+# Emits the nodes of models and checks the counts splash reports
+function(expect_emitted models regex)
+  run_splash_command(emit-ryven ${WORK_DIRECTORY}/${models} ${WORK_DIRECTORY}/packages -p iodsim ${ARGN})
+  if (NOT SPLASH_RESULT EQUAL 0 OR NOT SPLASH_OUTPUT MATCHES "${regex}")
+    message(FATAL_ERROR "splash emit-ryven ${models} ${ARGN} did not report ${regex}:\n${SPLASH_OUTPUT}")
+  endif (NOT SPLASH_RESULT EQUAL 0 OR NOT SPLASH_OUTPUT MATCHES "${regex}")
+endfunction(expect_emitted)
+
+expect_emitted(models.json "Emitted 4 node\\(s\\) .*: 5 file\\(s\\) written, 0 unchanged, 0 stale")
+set(node ${package}/nodes/iodsim___Synthetic1Model00/iodsim___Synthetic1Model00___METACODE.py)
+expect_match(${node} "'name': \"ns3::Synthetic1Model0\"")
+expect_match(${node} "{\"name\": \"Attribute0\", \"value\": float\\(self.input\\([0-9]\\)\\)}")
+expect_match(${node} "{\"name\": \"Attribute1\", \"value\": int\\(self.input\\([0-9]\\)\\)}")
+expect_match(${node} "{\"name\": \"Attribute2\", \"value\": bool\\(self.input\\([0-9]\\)\\)}")
+expect_match(${package}/iodsim.rpc "\"module name\": \"iodsim___Synthetic1Model00\"")
+
+expect_emitted(models.json "Emitted 4 node\\(s\\) .*: 0 file\\(s\\) written, 5 unchanged, 0 stale")
+
+# a type map changes the nodes of every model
+file(WRITE ${WORK_DIRECTORY}/types.txt "DoubleValue -\n")
+expect_emitted(models.json "Emitted 4 node\\(s\\) .*: 4 file\\(s\\) written, 1 unchanged, 0 stale" --type-map ${WORK_DIRECTORY}/types.txt)
+expect_match(${node} "{\"name\": \"Attribute0\", \"value\": self.input\\([0-9]\\)}")
+
+expect_emitted(fewer.json "Emitted 2 node\\(s\\) .*: 1 file\\(s\\) written, 2 unchanged, 2 stale" --type-map ${WORK_DIRECTORY}/types.txt)
+if (EXISTS ${package}/nodes/iodsim___Synthetic1Model00)
+  message(FATAL_ERROR "the node of Synthetic1Model0 is not removed")
+endif (EXISTS ${package}/nodes/iodsim___Synthetic1Model00)
@@ -0,0 +1,17 @@
+# splash convert from JSON to binary IR and back gives the same file
+include(${CMAKE_CURRENT_LIST_DIR}/common.cmake)
+
+generate_corpus(${WORK_DIRECTORY}/corpus -f 2 -n 3 -m 3 -d 2)
+run_splash(-p ${WORK_DIRECTORY}/corpus/compile_commands.json ${CMAKE_CURRENT_LIST_DIR}/sources/literals.cc
+           --extra-arg=-I${WORK_DIRECTORY}/corpus/include -o ${WORK_DIRECTORY}/models.json)
+
+foreach (conversion "models.json;models.spir" "models.spir;roundtrip.json")
+  list(GET conversion 0 input)
+  list(GET conversion 1 output)
+  run_splash_command(convert ${WORK_DIRECTORY}/${input} --output ${WORK_DIRECTORY}/${output})
+  if (NOT SPLASH_RESULT EQUAL 0)
+    message(FATAL_ERROR "splash convert ${input} to ${output} failed:\n${SPLASH_OUTPUT}")
+  endif (NOT SPLASH_RESULT EQUAL 0)
+endforeach (conversion)
+
+expect_same_files(${WORK_DIRECTORY}/models.json ${WORK_DIRECTORY}/roundtrip.json)
@@ -0,0 +1,12 @@
+# Descriptions are the values of their string literals: escapes decoded,
+# adjacent literals concatenated, macros expanded and raw strings kept
+include(${CMAKE_CURRENT_LIST_DIR}/common.cmake)
+
+# only for its ns3/object.h
+generate_corpus(${WORK_DIRECTORY}/corpus -f 1 -n 1 -m 1)
+run_splash(${CMAKE_CURRENT_LIST_DIR}/sources/literals.cc --extra-arg=-I${WORK_DIRECTORY}/corpus/include
+           -o ${WORK_DIRECTORY}/models.json)
+
+# as escaped again by the JSON export
+expect_match(${WORK_DIRECTORY}/models.json "\"name\":\"Range\",\"description\":\"Range in \\\\\"meters\\\\\",\\\\tsplit over two lines\\.\"")
+expect_match(${WORK_DIRECTORY}/models.json "\"name\":\"Count\",\"description\":\"Count of \\\\\"raw\\\\\" \\\\\\\\n items\\.\"")
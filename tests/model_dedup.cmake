@@ -0,0 +1,65 @@
+# Models are kept once, by the definition of their GetTypeId, also when a
+# header defines it for several inputs
+include(${CMAKE_CURRENT_LIST_DIR}/common.cmake)
+
+# the in-class declaration of GetTypeId neither replaces nor duplicates the
+# definition below it
+generate_corpus(${WORK_DIRECTORY}/local -f 2 -n 4 -m 4 -d 2 --local-classes)
+run_splash(-p ${WORK_DIRECTORY}/local/compile_commands.json -o ${WORK_DIRECTORY}/local.json)
+expect_match(${WORK_DIRECTORY}/local.json "\"name\":\"Synthetic0Model0\",\"attributes\":\\[{\"name\":\"Attribute")
+expect_match(${WORK_DIRECTORY}/local.json "\"name\":\"Synthetic1Model3\",\"attributes\":\\[{\"name\":\"Attribute")
+expect_no_match(${WORK_DIRECTORY}/local.json "\"attributes\":\\[\\]")
+
+# an input listed twice adds nothing, with threads and with worker processes
+generate_corpus(${WORK_DIRECTORY}/corpus -f 2 -n 4 -m 4 -d 2)
+set(database ${WORK_DIRECTORY}/corpus/compile_commands.json)
+set(a ${WORK_DIRECTORY}/corpus/src/synthetic-0-model.cc)
+set(b ${WORK_DIRECTORY}/corpus/src/synthetic-1-model.cc)
+run_splash(-p ${database} ${a} ${b} -o ${WORK_DIRECTORY}/once.json)
+run_splash(-p ${database} ${a} ${b} ${a} -j 3 -o ${WORK_DIRECTORY}/twice.json)
+run_splash(-p ${database} ${a} ${b} ${a} -j 3 --isolate -o ${WORK_DIRECTORY}/isolated.json)
+expect_match(${WORK_DIRECTORY}/once.json "\"name\":\"Synthetic1Model3\",\"attributes\":\\[{\"name\":\"Attribute")
+expect_same_files(${WORK_DIRECTORY}/once.json ${WORK_DIRECTORY}/twice.json)
+expect_same_files(${WORK_DIRECTORY}/once.json ${WORK_DIRECTORY}/isolated.json)
+
+# a GetTypeId defined inline in a header is extracted once from the distinct
+# inputs including it, claimed by the header rather than as a conflict, and
+# their cache entries hold it as well
+set(first ${CMAKE_CURRENT_LIST_DIR}/sources/shared-first.cc)
+set(second ${CMAKE_CURRENT_LIST_DIR}/sources/shared-second.cc)
+set(include --extra-arg=-I${WORK_DIRECTORY}/corpus/include)
+set(cache ${WORK_DIRECTORY}/cache)
+file(REMOVE_RECURSE ${cache})
+
+# Checks that output holds SharedModel once, before the models of the inputs
+function(expect_shared_once output)
+  file(READ ${output} contents)
+  string(REGEX MATCHALL "\"name\":\"SharedModel\"" shared "${contents}")
+  list(LENGTH shared count)
+  if (NOT count EQUAL 1)
+    message(FATAL_ERROR "${output} holds SharedModel ${count} time(s):\n${contents}")
+  endif (NOT count EQUAL 1)
+  expect_match(${output} "{\"parent\":\"ns3::Object\",\"name\":\"SharedModel\",\"attributes\":\\[{\"name\":\"Rate\",.*{\"parent\":\"ns3::SharedModel\",\"name\":\"FirstUser\",.*{\"parent\":\"ns3::SharedModel\",\"name\":\"SecondUser\",")
+  if (SPLASH_OUTPUT MATCHES "Warning: model SharedModel is defined in")
+    message(FATAL_ERROR "the header defining SharedModel is reported as a conflict:\n${SPLASH_OUTPUT}")
+  endif (SPLASH_OUTPUT MATCHES "Warning: model SharedModel is defined in")
+endfunction(expect_shared_once)
+
+run_splash(${first} ${second} ${include} -o ${WORK_DIRECTORY}/shared.json)
+expect_shared_once(${WORK_DIRECTORY}/shared.json)
+if (NOT SPLASH_OUTPUT MATCHES "Skipped 1 model definition")
+  message(FATAL_ERROR "the second extraction of SharedModel is not skipped:\n${SPLASH_OUTPUT}")
+endif (NOT SPLASH_OUTPUT MATCHES "Skipped 1 model definition")
+run_splash(${first} ${second} ${include} -j 2 --isolate -o ${WORK_DIRECTORY}/shared-isolated.json)
+expect_shared_once(${WORK_DIRECTORY}/shared-isolated.json)
+expect_same_files(${WORK_DIRECTORY}/shared.json ${WORK_DIRECTORY}/shared-isolated.json)
+
+execute_process(COMMAND ${CMAKE_COMMAND} -E sleep 0.1)
+run_splash(${first} ${second} ${include} --cache-dir ${cache} -o ${WORK_DIRECTORY}/shared-parsed.json)
+run_splash(${first} ${second} ${include} --cache-dir ${cache} -o ${WORK_DIRECTORY}/shared-cached.json)
+if (NOT SPLASH_OUTPUT MATCHES "Reused 2 of 2 unit")
+  message(FATAL_ERROR "the inputs sharing SharedModel are not cached:\n${SPLASH_OUTPUT}")
+endif (NOT SPLASH_OUTPUT MATCHES "Reused 2 of 2 unit")
+expect_shared_once(${WORK_DIRECTORY}/shared-cached.json)
+expect_same_files(${WORK_DIRECTORY}/shared.json ${WORK_DIRECTORY}/shared-parsed.json)
+expect_same_files(${WORK_DIRECTORY}/shared.json ${WORK_DIRECTORY}/shared-cached.json)
@@ -0,0 +1,33 @@
+# --resolve-parents links parents spelled with or without their namespaces,
+# tells apart the classes of a name in different namespaces, appends the
+# inherited attributes after the own ones down a chain, and reports the
+# parents missing from the inputs
+include(${CMAKE_CURRENT_LIST_DIR}/common.cmake)
+
+# only for its ns3/object.h
+generate_corpus(${WORK_DIRECTORY}/corpus -f 1 -n 1 -m 1)
+run_splash(${CMAKE_CURRENT_LIST_DIR}/sources/parents.cc --extra-arg=-I${WORK_DIRECTORY}/corpus/include
+           --resolve-parents -o ${WORK_DIRECTORY}/models.json)
+set(models ${WORK_DIRECTORY}/models.json)
+
+expect_match(${models} "{\"parent\":\"ns3::Object\",\"name\":\"Base\",\"attributes\":\\[{\"name\":\"Gain\"[^{]*}\\]}")
+expect_match(${models} "{\"parent\":\"ns3::lte::Base\",\"name\":\"Derived\",\"attributes\":\\[{\"name\":\"Count\",[^{]*},{\"name\":\"Gain\",")
+expect_match(${models} "{\"parent\":\"ns3::Derived\",\"name\":\"Leaf\",\"attributes\":\\[{\"name\":\"Delay\",[^{]*},{\"name\":\"Count\",[^{]*},{\"name\":\"Gain\",")
+expect_match(${models} "{\"parent\":\"ns3::Missing\",\"name\":\"Orphan\",\"attributes\":\\[{\"name\":\"Enabled\"[^{]*}\\]}")
+if (NOT SPLASH_OUTPUT MATCHES "Warning: parent ns3::Missing of Orphan not found")
+  message(FATAL_ERROR "the missing parent of Orphan is not reported:\n${SPLASH_OUTPUT}")
+endif (NOT SPLASH_OUTPUT MATCHES "Warning: parent ns3::Missing of Orphan not found")
+if (SPLASH_OUTPUT MATCHES "Warning: parent ns3::(lte::Base|Derived|wifi::Station)")
+  message(FATAL_ERROR "a parent among the inputs is reported missing:\n${SPLASH_OUTPUT}")
+endif (SPLASH_OUTPUT MATCHES "Warning: parent ns3::(lte::Base|Derived|wifi::Station)")
+
+# a class sharing the name of its parent, or of an unrelated class it derives
+# from, is not its own ancestor
+expect_match(${models} "{\"parent\":\"ns3::wifi::Station\",\"name\":\"Station\",\"attributes\":\\[{\"name\":\"Hops\",[^{]*},{\"name\":\"Channel\",")
+expect_match(${models} "{\"parent\":\"ns3::Phy\",\"name\":\"Phy\",\"attributes\":\\[{\"name\":\"Power\"[^{]*}\\]}")
+if (NOT SPLASH_OUTPUT MATCHES "Warning: parent ns3::Phy of Phy not found")
+  message(FATAL_ERROR "the missing parent of ns3::wimax::Phy is not reported:\n${SPLASH_OUTPUT}")
+endif (NOT SPLASH_OUTPUT MATCHES "Warning: parent ns3::Phy of Phy not found")
+if (SPLASH_OUTPUT MATCHES "own ancestor")
+  message(FATAL_ERROR "a model is reported as its own ancestor:\n${SPLASH_OUTPUT}")
+endif (SPLASH_OUTPUT MATCHES "own ancestor")
@@ -0,0 +1,14 @@
+# --pch none, preamble and umbrella extract byte-identical outputs
+include(${CMAKE_CURRENT_LIST_DIR}/common.cmake)
+
+generate_corpus(${WORK_DIRECTORY}/corpus -f 4 -n 8 -m 4 -d 3)
+
+foreach (mode none preamble umbrella)
+  run_splash(-p ${WORK_DIRECTORY}/corpus/compile_commands.json --pch ${mode} -j 2
+             -o ${WORK_DIRECTORY}/${mode}.json)
+endforeach (mode)
+
+# identical empty extractions would prove nothing
+expect_match(${WORK_DIRECTORY}/none.json "\"name\":\"Synthetic3Model7\",\"attributes\":\\[{\"name\":\"Attribute")
+expect_same_files(${WORK_DIRECTORY}/none.json ${WORK_DIRECTORY}/preamble.json)
+expect_same_files(${WORK_DIRECTORY}/none.json ${WORK_DIRECTORY}/umbrella.json)
@@ -0,0 +1,18 @@
+# --prescan skips no input the full parse extracts models from, whether
+# GetTypeId is defined below its class or inline in its body
+include(${CMAKE_CURRENT_LIST_DIR}/common.cmake)
+
+generate_corpus(${WORK_DIRECTORY}/corpus -f 3 -n 4 -m 4 -d 2 --local-classes)
+set(database ${WORK_DIRECTORY}/corpus/compile_commands.json)
+
+run_splash(-p ${database} -o ${WORK_DIRECTORY}/plain.json)
+run_splash(-p ${database} --prescan -o ${WORK_DIRECTORY}/prescan.json)
+
+expect_match(${WORK_DIRECTORY}/plain.json "\"name\":\"Synthetic2Model1\",\"attributes\":\\[{\"name\":\"Attribute")
+expect_same_files(${WORK_DIRECTORY}/plain.json ${WORK_DIRECTORY}/prescan.json)
+if (NOT SPLASH_OUTPUT MATCHES "Skipped 0 of 3 unit")
+  message(FATAL_ERROR "--prescan skipped an input:\n${SPLASH_OUTPUT}")
+endif (NOT SPLASH_OUTPUT MATCHES "Skipped 0 of 3 unit")
+if (SPLASH_OUTPUT MATCHES "Warning")
+  message(FATAL_ERROR "--prescan and the parse disagree:\n${SPLASH_OUTPUT}")
+endif (SPLASH_OUTPUT MATCHES "Warning")
@@ -0,0 +1,69 @@
+# splash query answers every kind of lookup on a converted IR, value types
+# with or without their namespace, links parents by their qualified names,
+# and splash serve answers the same over its socket
+include(${CMAKE_CURRENT_LIST_DIR}/common.cmake)
+
+generate_corpus(${WORK_DIRECTORY}/corpus -f 2 -n 3 -m 3 -d 2)
+run_splash(-p ${WORK_DIRECTORY}/corpus/compile_commands.json -o ${WORK_DIRECTORY}/models.json)
+run_splash_command(convert ${WORK_DIRECTORY}/models.json --output ${WORK_DIRECTORY}/models.spir)
+if (NOT SPLASH_RESULT EQUAL 0)
+  message(FATAL_ERROR "splash convert failed:\n${SPLASH_OUTPUT}")
+endif (NOT SPLASH_RESULT EQUAL 0)
+
+# Runs splash query on the IR and checks its answer against regex
+function(expect_answer regex)
+  run_splash_command(query ${WORK_DIRECTORY}/models.spir ${ARGN})
+  if (NOT SPLASH_RESULT EQUAL 0 OR NOT SPLASH_OUTPUT MATCHES "${regex}")
+    message(FATAL_ERROR "splash query ${ARGN} answered ${SPLASH_RESULT}, not ${regex}:\n${SPLASH_OUTPUT}")
+  endif (NOT SPLASH_RESULT EQUAL 0 OR NOT SPLASH_OUTPUT MATCHES "${regex}")
+endfunction(expect_answer)
+
+set(allModels "^\\[\"Synthetic0Model0\",\"Synthetic0Model1\",\"Synthetic0Model2\",\"Synthetic1Model0\",\"Synthetic1Model1\",\"Synthetic1Model2\"\\]$")
+
+expect_answer("^{\"parent\":\"ns3::Synthetic0Model0\",\"name\":\"Synthetic0Model1\",\"attributes\":\\[.*\"description\":\"Attribute 0 of Synthetic0Model1 "
+              --name Synthetic0Model1)
+expect_answer("${allModels}" --prefix Synthetic)
+expect_answer("^\\[\"Synthetic1Model0\",\"Synthetic1Model1\",\"Synthetic1Model2\"\\]$" --prefix Synthetic1)
+expect_answer("${allModels}" --type DoubleValue)
+expect_answer("${allModels}" --type ns3::DoubleValue)
+expect_answer("^\\[\\]$" --type ns3::StringValue)
+expect_answer("^\\[\"Synthetic0Model1\"\\]$" --children Synthetic0Model0)
+
+run_splash_command(query ${WORK_DIRECTORY}/models.spir --name Synthetic9Model9)
+if (NOT SPLASH_RESULT EQUAL 1 OR NOT SPLASH_OUTPUT MATCHES "^{\"error\":\"unknown model Synthetic9Model9\"}$")
+  message(FATAL_ERROR "splash query of an unknown model answered ${SPLASH_RESULT}:\n${SPLASH_OUTPUT}")
+endif (NOT SPLASH_RESULT EQUAL 1 OR NOT SPLASH_OUTPUT MATCHES "^{\"error\":\"unknown model Synthetic9Model9\"}$")
+
+# a model inherits from the class of its own name in another namespace, found
+# by the qualified names written into an IR by the extraction
+run_splash(${CMAKE_CURRENT_LIST_DIR}/sources/parents.cc --extra-arg=-I${WORK_DIRECTORY}/corpus/include
+           -o ${WORK_DIRECTORY}/parents.spir)
+run_splash_command(query ${WORK_DIRECTORY}/parents.spir --name Station)
+if (NOT SPLASH_RESULT EQUAL 0 OR NOT SPLASH_OUTPUT MATCHES "^{\"parent\":\"ns3::wifi::Station\",\"name\":\"Station\",\"attributes\":\\[{\"name\":\"Hops\",[^{]*},{\"name\":\"Channel\",")
+  message(FATAL_ERROR "splash query of a model named like its parent answered ${SPLASH_RESULT}:\n${SPLASH_OUTPUT}")
+endif (NOT SPLASH_RESULT EQUAL 0 OR NOT SPLASH_OUTPUT MATCHES "^{\"parent\":\"ns3::wifi::Station\",\"name\":\"Station\",\"attributes\":\\[{\"name\":\"Hops\",[^{]*},{\"name\":\"Channel\",")
+
+if (NOT CMAKE_HOST_UNIX)
+  return()
+endif (NOT CMAKE_HOST_UNIX)
+
+# a relative socket path stays below the length limit of sun_path
+set(socket ${WORK_DIRECTORY}/splash.sock)
+file(REMOVE ${socket})
+execute_process(COMMAND sh -c "\"$0\" serve models.spir --socket splash.sock >serve.log 2>&1 & echo $!" ${SPLASH}
+                WORKING_DIRECTORY ${WORK_DIRECTORY} OUTPUT_VARIABLE server OUTPUT_STRIP_TRAILING_WHITESPACE)
+foreach (attempt RANGE 100)
+  if (EXISTS ${socket})
+    break()
+  endif (EXISTS ${socket})
+  execute_process(COMMAND ${CMAKE_COMMAND} -E sleep 0.1)
+endforeach (attempt)
+
+execute_process(COMMAND ${SPLASH} query --socket splash.sock --type ns3::DoubleValue
+                WORKING_DIRECTORY ${WORK_DIRECTORY}
+                RESULT_VARIABLE result OUTPUT_VARIABLE output ERROR_VARIABLE output OUTPUT_STRIP_TRAILING_WHITESPACE)
+execute_process(COMMAND kill ${server})
+if (NOT result EQUAL 0 OR NOT output MATCHES "${allModels}")
+  file(READ ${WORK_DIRECTORY}/serve.log log)
+  message(FATAL_ERROR "splash query --socket answered ${result}:\n${output}\nsplash serve:\n${log}")
+endif (NOT result EQUAL 0 OR NOT output MATCHES "${allModels}")
@@ -0,0 +1,24 @@
+#include "ns3/object.h"
+#define UNIT_NAME "meters"
+namespace ns3 {
+class Literal : public Object
+{
+public:
+  static ns3::TypeId GetTypeId();
+  double m_range;
+  uint32_t m_count;
+};
+ns3::TypeId
+Literal::GetTypeId()
+{
+  static ns3::TypeId tid = ns3::TypeId("ns3::Literal")
+    .SetParent<Object>()
+    .AddAttribute("Range", "Range in \"" UNIT_NAME "\",\tsplit"
+                  " over two lines.",
+                  DoubleValue(1.5),
+                  MakeDoubleAccessor(&Literal::m_range), MakeDoubleChecker<double>())
+    .AddAttribute("Count", R"(Count of "raw" \n items.)", UintegerValue(3),
+                  MakeUintegerAccessor(&Literal::m_count), MakeUintegerChecker<uint32_t>());
+  return tid;
+}
+} // namespace ns3
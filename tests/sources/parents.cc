@@ -0,0 +1,120 @@
+#include "ns3/object.h"
+namespace ns3 {
+namespace lte {
+class Base : public Object
+{
+public:
+  static ns3::TypeId GetTypeId();
+  double m_gain;
+};
+} // namespace lte
+class Derived : public lte::Base
+{
+public:
+  static ns3::TypeId GetTypeId();
+  uint32_t m_count;
+};
+namespace lte {
+class Leaf : public Derived
+{
+public:
+  static ns3::TypeId GetTypeId();
+  double m_delay;
+};
+} // namespace lte
+namespace wifi {
+class Station : public Object
+{
+public:
+  static ns3::TypeId GetTypeId();
+  uint32_t m_channel;
+};
+} // namespace wifi
+namespace mesh {
+class Station : public wifi::Station
+{
+public:
+  static ns3::TypeId GetTypeId();
+  uint32_t m_hops;
+};
+} // namespace mesh
+class Phy : public Object {};
+namespace wimax {
+class Phy : public ns3::Phy
+{
+public:
+  static ns3::TypeId GetTypeId();
+  double m_power;
+};
+} // namespace wimax
+class Missing : public Object {};
+class Orphan : public Missing
+{
+public:
+  static ns3::TypeId GetTypeId();
+  bool m_enabled;
+};
+ns3::TypeId
+lte::Base::GetTypeId()
+{
+  static ns3::TypeId tid = ns3::TypeId("ns3::lte::Base")
+    .SetParent<Object>()
+    .AddAttribute("Gain", "Gain of the base.", DoubleValue(1.0),
+                  MakeDoubleAccessor(&Base::m_gain), MakeDoubleChecker<double>());
+  return tid;
+}
+ns3::TypeId
+Derived::GetTypeId()
+{
+  static ns3::TypeId tid = ns3::TypeId("ns3::Derived")
+    .SetParent<ns3::lte::Base>()
+    .AddAttribute("Count", "Count of the derived.", UintegerValue(2),
+                  MakeUintegerAccessor(&Derived::m_count), MakeUintegerChecker<uint32_t>());
+  return tid;
+}
+ns3::TypeId
+lte::Leaf::GetTypeId()
+{
+  static ns3::TypeId tid = ns3::TypeId("ns3::lte::Leaf")
+    .SetParent<Derived>()
+    .AddAttribute("Delay", "Delay of the leaf.", DoubleValue(0.1),
+                  MakeDoubleAccessor(&Leaf::m_delay), MakeDoubleChecker<double>());
+  return tid;
+}
+ns3::TypeId
+mesh::Station::GetTypeId()
+{
+  static ns3::TypeId tid = ns3::TypeId("ns3::mesh::Station")
+    .SetParent<wifi::Station>()
+    .AddAttribute("Hops", "Hops of the mesh station.", UintegerValue(1),
+                  MakeUintegerAccessor(&Station::m_hops), MakeUintegerChecker<uint32_t>());
+  return tid;
+}
+ns3::TypeId
+wifi::Station::GetTypeId()
+{
+  static ns3::TypeId tid = ns3::TypeId("ns3::wifi::Station")
+    .SetParent<Object>()
+    .AddAttribute("Channel", "Channel of the station.", UintegerValue(6),
+                  MakeUintegerAccessor(&Station::m_channel), MakeUintegerChecker<uint32_t>());
+  return tid;
+}
+ns3::TypeId
+wimax::Phy::GetTypeId()
+{
+  static ns3::TypeId tid = ns3::TypeId("ns3::wimax::Phy")
+    .SetParent<ns3::Phy>()
+    .AddAttribute("Power", "Power of the phy.", DoubleValue(20.0),
+                  MakeDoubleAccessor(&Phy::m_power), MakeDoubleChecker<double>());
+  return tid;
+}
+ns3::TypeId
+Orphan::GetTypeId()
+{
+  static ns3::TypeId tid = ns3::TypeId("ns3::Orphan")
+    .SetParent<Missing>()
+    .AddAttribute("Enabled", "Whether the orphan is enabled.", BooleanValue(true),
+                  MakeBooleanAccessor(&Orphan::m_enabled), MakeBooleanChecker());
+  return tid;
+}
+} // namespace ns3
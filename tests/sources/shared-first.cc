@@ -0,0 +1,18 @@
+#include "shared-model.h"
+namespace ns3 {
+class FirstUser : public SharedModel
+{
+public:
+  static ns3::TypeId GetTypeId();
+  bool m_enabled;
+};
+ns3::TypeId
+FirstUser::GetTypeId()
+{
+  static ns3::TypeId tid = ns3::TypeId("ns3::FirstUser")
+    .SetParent<SharedModel>()
+    .AddAttribute("Enabled", "Enabled of the first user.", BooleanValue(true),
+                  MakeBooleanAccessor(&FirstUser::m_enabled), MakeBooleanChecker());
+  return tid;
+}
+} // namespace ns3
@@ -0,0 +1,19 @@
+#ifndef SHARED_MODEL_H
+#define SHARED_MODEL_H
+#include "ns3/object.h"
+namespace ns3 {
+class SharedModel : public Object
+{
+public:
+  static ns3::TypeId GetTypeId()
+  {
+    static ns3::TypeId tid = ns3::TypeId("ns3::SharedModel")
+      .SetParent<Object>()
+      .AddAttribute("Rate", "Rate of the shared model.", DoubleValue(1.0),
+                    MakeDoubleAccessor(&SharedModel::m_rate), MakeDoubleChecker<double>());
+    return tid;
+  }
+  double m_rate;
+};
+} // namespace ns3
+#endif
@@ -0,0 +1,18 @@
+#include "shared-model.h"
+namespace ns3 {
+class SecondUser : public SharedModel
+{
+public:
+  static ns3::TypeId GetTypeId();
+  uint32_t m_count;
+};
+ns3::TypeId
+SecondUser::GetTypeId()
+{
+  static ns3::TypeId tid = ns3::TypeId("ns3::SecondUser")
+    .SetParent<SharedModel>()
+    .AddAttribute("Count", "Count of the second user.", UintegerValue(3),
+                  MakeUintegerAccessor(&SecondUser::m_count), MakeUintegerChecker<uint32_t>());
+  return tid;
+}
+} // namespace ns3
@@ -0,0 +1,136 @@
+#include "trace.h"
+
+#include <cstdio>
+#include <mutex>
+
+TraceLevel Trace::m_level {TraceLevel::Off};
+
+static std::FILE *sink = stderr;
+static std::mutex sinkMutex;
+
+// Trace lines of the current thread, written to the sink in blocks.
+class TraceBuffer {
+public:
+    ~TraceBuffer()
+    {
+        flush();
+    }
+
+    void append(const std::string &line)
+    {
+        data += line;
+        if (data.size() >= flushThreshold)
+            flush();
+    }
+
+    void flush()
+    {
+        if (data.empty())
+            return;
+
+        std::lock_guard<std::mutex> lock(sinkMutex);
+        std::fwrite(data.data(), 1, data.size(), sink);
+        std::fflush(sink);
+        data.clear();
+    }
+
+    static constexpr std::size_t flushThreshold = 1 << 16;
+    std::string data;
+};
+
+static thread_local TraceBuffer buffer;
+
+static std::string escape(const std::string &str)
+{
+    std::string escaped;
+    escaped.reserve(str.size());
+
+    for (char c : str) {
+        switch (c) {
+            case '"':  escaped += "\\\""; break;
+            case '\\': escaped += "\\\\"; break;
+            case '\n': escaped += "\\n"; break;
+            case '\t': escaped += "\\t"; break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    char code[7];
+                    std::snprintf(code, sizeof(code), "\\u%04x", c);
+                    escaped += code;
+                } else {
+                    escaped += c;
+                }
+        }
+    }
+
+    return escaped;
+}
+
+static const char* levelName(TraceLevel level)
+{
+    switch (level) {
+        case TraceLevel::Info:   return "info";
+        case TraceLevel::Debug:  return "debug";
+        case TraceLevel::Cursor: return "cursor";
+        default:                 return "off";
+    }
+}
+
+void Trace::configure(TraceLevel level, const std::string &sinkPath)
+{
+    m_level = level;
+
+    if (!sinkPath.empty()) {
+        std::FILE *f = std::fopen(sinkPath.c_str(), "w");
+        if (f != nullptr)
+            sink = f;
+    }
+}
+
+bool Trace::parseLevel(const std::string &name, TraceLevel &level)
+{
+    if (name == "off")    { level = TraceLevel::Off; return true; }
+    if (name == "info")   { level = TraceLevel::Info; return true; }
+    if (name == "debug")  { level = TraceLevel::Debug; return true; }
+    if (name == "cursor") { level = TraceLevel::Cursor; return true; }
+    return false;
+}
+
+void Trace::event(TraceLevel level, const char *function, const std::string &message)
+{
+    write(std::string("{\"level\":\"") + levelName(level) +
+          "\",\"fn\":\"" + function +
+          "\",\"msg\":\"" + escape(message) + "\"}\n");
+}
+
+void Trace::cursor(TraceLevel level, const char *function, const CXCursor &cursor, const char *decision)
+{
+    CXString kind = clang_getCursorKindSpelling(clang_getCursorKind(cursor));
+    CXString spell = clang_getCursorSpelling(cursor);
+    CXFile file;
+    unsigned line, column;
+    clang_getSpellingLocation(clang_getCursorLocation(cursor), &file, &line, &column, nullptr);
+    CXString fileName = clang_getFileName(file);
+    const char *fileNameStr = clang_getCString(fileName);
+
+    write(std::string("{\"level\":\"") + levelName(level) +
+          "\",\"fn\":\"" + function +
+          "\",\"kind\":\"" + clang_getCString(kind) +
+          "\",\"spelling\":\"" + escape(clang_getCString(spell)) +
+          "\",\"loc\":\"" + escape(fileNameStr ? fileNameStr : "") + ":" +
+          std::to_string(line) + ":" + std::to_string(column) +
+          "\",\"decision\":\"" + decision + "\"}\n");
+
+    clang_disposeString(kind);
+    clang_disposeString(spell);
+    clang_disposeString(fileName);
+}
+
+void Trace::flush()
+{
+    buffer.flush();
+}
+
+void Trace::write(const std::string &line)
+{
+    buffer.append(line);
+}
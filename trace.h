@@ -0,0 +1,59 @@
+#pragma once
+
+#include <sstream>
+#include <string>
+
+#include <clang-c/Index.h>
+
+// Verbosity of trace events, from the least to the most frequent.
+enum class TraceLevel { Off, Info, Debug, Cursor };
+
+// Leveled tracing of the extraction. Events are written as JSON lines into a
+// per-thread buffer that is flushed to the sink in large blocks.
+//
+// Tracing is compiled in only when SPLASH_ENABLE_TRACING is defined (Debug
+// builds, or -DSPLASH_ENABLE_TRACING=ON). Otherwise every SPLASH_TRACE* macro
+// expands to nothing and its arguments are never evaluated.
+class Trace
+{
+public:
+    static constexpr bool compiledIn =
+#ifdef SPLASH_ENABLE_TRACING
+        true;
+#else
+        false;
+#endif
+
+    static void configure(TraceLevel level, const std::string &sinkPath);
+    static bool isEnabled(TraceLevel level) { return level <= m_level; }
+    // False if name is not one of off, info, debug or cursor
+    static bool parseLevel(const std::string &name, TraceLevel &level);
+
+    static void event(TraceLevel level, const char *function, const std::string &message);
+    static void cursor(TraceLevel level, const char *function, const CXCursor &cursor, const char *decision);
+    static void flush();
+
+private:
+    static void write(const std::string &line);
+
+    static TraceLevel m_level;
+};
+
+#ifdef SPLASH_ENABLE_TRACING
+#define SPLASH_TRACE(level, message)                                      \
+    do {                                                                  \
+        if (Trace::isEnabled(level)) {                                    \
+            std::ostringstream traceMessage_;                             \
+            traceMessage_ << message;                                     \
+            Trace::event(level, __func__, traceMessage_.str());           \
+        }                                                                 \
+    } while (0)
+#define SPLASH_TRACE_CURSOR(level, cursor, decision)                      \
+    do {                                                                  \
+        if (Trace::isEnabled(level))                                      \
+            Trace::cursor(level, __func__, cursor, decision);             \
+    } while (0)
+#else
+#define SPLASH_TRACE(level, message) do {} while (0)
+#define SPLASH_TRACE_CURSOR(level, cursor, decision) do {} while (0)
+#endif
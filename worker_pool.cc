@@ -0,0 +1,301 @@
+#include "worker_pool.h"
+#include "trace.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+
+#ifndef _WIN32
+#include <csignal>
+#include <poll.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+// Frame sent by a worker: task index, status and payload size, then payload
+static constexpr std::size_t FRAME_HEADER_SIZE = sizeof(std::uint64_t) + 1 + sizeof(std::uint64_t);
+static constexpr unsigned char FRAME_OK = 0;
+static constexpr unsigned char FRAME_ERROR = 1;
+
+WorkerPool::WorkerPool(unsigned workers, std::chrono::milliseconds timeout, Task task) :
+    m_size {std::max(workers, 1u)},
+    m_timeout {timeout},
+    m_task {task}
+{}
+
+#ifndef _WIN32
+
+WorkerPool::~WorkerPool()
+{
+    for (auto& worker : m_workers)
+        stop(worker, false);
+}
+
+static bool writeAll(int fd, const char *data, std::size_t size)
+{
+    while (size > 0) {
+        const ssize_t written = write(fd, data, size);
+        if (written < 0 && errno == EINTR)
+            continue;
+        if (written <= 0)
+            return false;
+        data += written;
+        size -= written;
+    }
+
+    return true;
+}
+
+static bool readAll(int fd, char *data, std::size_t size)
+{
+    while (size > 0) {
+        const ssize_t got = read(fd, data, size);
+        if (got < 0 && errno == EINTR)
+            continue;
+        if (got <= 0)
+            return false;
+        data += got;
+        size -= got;
+    }
+
+    return true;
+}
+
+void WorkerPool::spawn(Worker &worker)
+{
+    int command[2], result[2];
+    if (pipe(command) != 0)
+        throw std::runtime_error("cannot create a worker pipe");
+    if (pipe(result) != 0) {
+        close(command[0]);
+        close(command[1]);
+        throw std::runtime_error("cannot create a worker pipe");
+    }
+
+    // buffered output would be written twice, once by each process
+    std::cout.flush();
+    Trace::flush();
+    std::fflush(nullptr);
+
+    const pid_t pid = fork();
+    if (pid < 0)
+        throw std::runtime_error("cannot fork a worker process");
+
+    if (pid == 0) {
+        // a sibling keeping these ends open would never see them close
+        for (auto& other : m_workers) {
+            if (other.commandFd >= 0)
+                close(other.commandFd);
+            if (other.resultFd >= 0)
+                close(other.resultFd);
+        }
+        close(command[1]);
+        close(result[0]);
+        serve(command[0], result[1]);
+    }
+
+    close(command[0]);
+    close(result[1]);
+    worker.pid = pid;
+    worker.commandFd = command[1];
+    worker.resultFd = result[0];
+    worker.busy = false;
+    worker.buffer.clear();
+}
+
+void WorkerPool::serve(int commandFd, int resultFd)
+{
+    // the supervisor handles Ctrl-C and stops the workers by closing their pipes
+    std::signal(SIGINT, SIG_IGN);
+    std::signal(SIGPIPE, SIG_DFL);
+
+    std::uint64_t task;
+    while (readAll(commandFd, reinterpret_cast<char *>(&task), sizeof(task))) {
+        unsigned char status = FRAME_OK;
+        std::string payload;
+        try {
+            payload = m_task(task);
+        } catch (const std::exception &e) {
+            status = FRAME_ERROR;
+            payload = e.what();
+        } catch (...) {
+            status = FRAME_ERROR;
+            payload = "unknown error";
+        }
+        std::cout.flush();
+        std::fflush(nullptr);
+
+        char header[FRAME_HEADER_SIZE];
+        const std::uint64_t size = payload.size();
+        std::memcpy(header, &task, sizeof(task));
+        header[sizeof(task)] = static_cast<char>(status);
+        std::memcpy(header + sizeof(task) + 1, &size, sizeof(size));
+        if (!writeAll(resultFd, header, sizeof(header)) || !writeAll(resultFd, payload.data(), payload.size()))
+            break;
+    }
+
+    // skip the destructors of the state copied from the supervisor, which
+    // would also have flushed the trace of this thread
+    Trace::flush();
+    _exit(0);
+}
+
+void WorkerPool::stop(Worker &worker, bool kill)
+{
+    if (worker.pid < 0)
+        return;
+
+    if (kill)
+        ::kill(worker.pid, SIGKILL);
+    close(worker.commandFd);
+    close(worker.resultFd);
+    int status;
+    waitpid(worker.pid, &status, 0);
+    worker.pid = -1;
+    worker.commandFd = -1;
+    worker.resultFd = -1;
+}
+
+std::string WorkerPool::exitReason(int status) const
+{
+    if (WIFSIGNALED(status))
+        return std::string("crashed with signal ") + std::to_string(WTERMSIG(status)) + " (" + strsignal(WTERMSIG(status)) + ")";
+    return "exited with status " + std::to_string(WEXITSTATUS(status));
+}
+
+void WorkerPool::run(std::size_t tasks, const ResultHandler &onResult, const FailureHandler &onFailure)
+{
+    // writing to a worker gone would otherwise kill the supervisor silently.
+    // The disposition of the caller is restored afterwards.
+    const auto previousSigpipe = std::signal(SIGPIPE, SIG_IGN);
+    try {
+        dispatch(tasks, onResult, onFailure);
+    } catch (...) {
+        std::signal(SIGPIPE, previousSigpipe);
+        throw;
+    }
+    std::signal(SIGPIPE, previousSigpipe);
+}
+
+void WorkerPool::dispatch(std::size_t tasks, const ResultHandler &onResult, const FailureHandler &onFailure)
+{
+    using Clock = std::chrono::steady_clock;
+
+    m_workers.resize(std::min<std::size_t>(m_size, tasks));
+    for (auto& worker : m_workers)
+        spawn(worker);
+
+    std::size_t next = 0, done = 0;
+    std::vector<pollfd> fds(m_workers.size());
+    while (done < tasks) {
+        // hand out tasks to idle workers
+        for (auto& worker : m_workers) {
+            if (worker.busy || next >= tasks)
+                continue;
+
+            const std::uint64_t task = next;
+            if (!writeAll(worker.commandFd, reinterpret_cast<const char *>(&task), sizeof(task))) {
+                // died while idle, nothing is lost
+                stop(worker, true);
+                spawn(worker);
+                m_restarts++;
+                continue;
+            }
+            worker.busy = true;
+            worker.task = next++;
+            worker.deadline = Clock::now() + m_timeout;
+        }
+
+        // wake up at the earliest deadline
+        int timeout = -1;
+        for (std::size_t w = 0; w < m_workers.size(); w++) {
+            fds[w] = {m_workers[w].resultFd, POLLIN, 0};
+            if (m_workers[w].busy && m_timeout.count() > 0) {
+                const auto left = std::chrono::duration_cast<std::chrono::milliseconds>(m_workers[w].deadline - Clock::now());
+                const int ms = static_cast<int>(std::max<std::int64_t>(left.count(), 0)) + 1;
+                timeout = timeout < 0 ? ms : std::min(timeout, ms);
+            }
+        }
+        if (poll(fds.data(), fds.size(), timeout) < 0 && errno != EINTR)
+            throw std::runtime_error("cannot wait for the worker processes");
+
+        for (std::size_t w = 0; w < m_workers.size(); w++) {
+            Worker &worker = m_workers[w];
+
+            if (fds[w].revents & (POLLIN | POLLHUP | POLLERR)) {
+                char chunk[64 * 1024];
+                const ssize_t got = read(worker.resultFd, chunk, sizeof(chunk));
+                if (got > 0) {
+                    worker.buffer.append(chunk, got);
+                } else if (got == 0 || errno != EINTR) {
+                    // crashed, or exited on its own
+                    int status = 0;
+                    waitpid(worker.pid, &status, 0);
+                    close(worker.commandFd);
+                    close(worker.resultFd);
+                    worker.pid = -1;
+                    worker.commandFd = -1;
+                    worker.resultFd = -1;
+                    if (worker.busy) {
+                        worker.busy = false;
+                        onFailure(worker.task, exitReason(status));
+                        done++;
+                    }
+                    if (next < tasks) {
+                        spawn(worker);
+                        m_restarts++;
+                    }
+                    continue;
+                }
+            }
+
+            // complete frames
+            while (worker.buffer.size() >= FRAME_HEADER_SIZE) {
+                std::uint64_t task, size;
+                std::memcpy(&task, worker.buffer.data(), sizeof(task));
+                const unsigned char status = worker.buffer[sizeof(task)];
+                std::memcpy(&size, worker.buffer.data() + sizeof(task) + 1, sizeof(size));
+                if (worker.buffer.size() < FRAME_HEADER_SIZE + size)
+                    break;
+
+                std::string payload = worker.buffer.substr(FRAME_HEADER_SIZE, size);
+                worker.buffer.erase(0, FRAME_HEADER_SIZE + size);
+                worker.busy = false;
+                done++;
+                if (status == FRAME_OK)
+                    onResult(task, payload);
+                else
+                    onFailure(task, payload);
+            }
+
+            if (worker.busy && m_timeout.count() > 0 && Clock::now() >= worker.deadline) {
+                stop(worker, true);
+                worker.busy = false;
+                onFailure(worker.task, "timed out after " + std::to_string(m_timeout.count()) + " ms");
+                done++;
+                if (next < tasks) {
+                    spawn(worker);
+                    m_restarts++;
+                }
+            }
+        }
+    }
+
+    for (auto& worker : m_workers)
+        stop(worker, false);
+    m_workers.clear();
+}
+
+#else
+
+WorkerPool::~WorkerPool() {}
+
+void WorkerPool::run(std::size_t, const ResultHandler &, const FailureHandler &)
+{
+    throw std::runtime_error("worker processes are not supported on this platform");
+}
+
+#endif
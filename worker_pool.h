@@ -0,0 +1,65 @@
+#pragma once
+
+#include <chrono>
+#include <functional>
+#include <string>
+#include <vector>
+
+// Runs indexed tasks in a pool of forked worker processes. Each task has a
+// wall-clock budget: a worker exceeding it is killed, one crashing is
+// reaped, and in both cases the task is reported failed and the worker is
+// replaced, so one bad task never stops the others. Results come back as
+// byte strings over pipes. Only available on POSIX systems.
+class WorkerPool
+{
+public:
+    static constexpr bool isSupported =
+#ifdef _WIN32
+        false;
+#else
+        true;
+#endif
+
+    // Runs in a worker process, returns the result payload. An exception
+    // fails the task with its message.
+    using Task = std::function<std::string(std::size_t)>;
+    using ResultHandler = std::function<void(std::size_t, std::string &payload)>;
+    using FailureHandler = std::function<void(std::size_t, const std::string &reason)>;
+
+    // A zero timeout lets tasks run for as long as they need
+    WorkerPool(unsigned workers, std::chrono::milliseconds timeout, Task task);
+    ~WorkerPool();
+
+    // Runs tasks 0 to tasks - 1 and calls a handler for each of them, in
+    // the calling process and in completion order
+    void run(std::size_t tasks, const ResultHandler &onResult, const FailureHandler &onFailure);
+
+    std::size_t restarts() const { return m_restarts; }
+
+private:
+    class Worker {
+    public:
+        Worker() {}
+
+        int pid {-1};
+        // task indexes to the worker, frames from it
+        int commandFd {-1};
+        int resultFd {-1};
+        bool busy {false};
+        std::size_t task {0};
+        std::chrono::steady_clock::time_point deadline;
+        std::string buffer;
+    };
+
+    void dispatch(std::size_t tasks, const ResultHandler &onResult, const FailureHandler &onFailure);
+    void spawn(Worker &worker);
+    void stop(Worker &worker, bool kill);
+    [[noreturn]] void serve(int commandFd, int resultFd);
+    std::string exitReason(int status) const;
+
+    unsigned m_size;
+    std::chrono::milliseconds m_timeout;
+    Task m_task;
+    std::vector<Worker> m_workers;
+    std::size_t m_restarts {0};
+};